@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file           : console.h
+  * @brief          : Line based command console on a receive ring
+  ******************************************************************************
+  * Bytes are taken from a uart_ring_t and collected into lines ending in CR
+  * or LF. Each line is split on blanks and the first word looked up in the
+  * command table given to console_init(). Replies go through printf().
+  * "help" lists the table.
+  *
+  * This file does not depend on the HAL so it can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "uart_ring.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define CONSOLE_LINE_MAX      48
+#define CONSOLE_ARGS_MAX      6
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  const char *name;
+  void      (*run)(int argc, char *argv[]);
+  const char *help;
+} console_cmd_t;
+
+/* Exported functions --------------------------------------------------------*/
+void console_init(const console_cmd_t *cmds, uint8_t count);
+
+/* Consumes every byte in the ring and runs the completed lines. */
+void console_input(uart_ring_t *r);
+
+/* Runs one line; the buffer is modified. */
+void console_exec(char *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONSOLE_H__ */
@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file           : control.h
+  * @brief          : PID + slew limited PWM output stage
+  ******************************************************************************
+  * One control_step() per PWM period:
+  *
+  *   setpoint - measurement -> arm_pid_f32 -> + trim -> clamp -> slew limit
+  *
+  * The result is the compare value for the PWM channel. arm_pid_f32 is the
+  * incremental form, so writing the limited output back into its state
+  * keeps the integrator from winding up while the output is saturated.
+  *
+  * control_stats_t records the period between steps and the time spent in
+  * them, in the units of the clock passed in (microseconds on the board).
+  *
+  * Only the reference C sources of CMSIS-DSP are used, so this file can be
+  * compiled and tested on a host with -DARM_MATH_CM3.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CONTROL_H__
+#define __CONTROL_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "arm_math.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  arm_pid_instance_f32 pid;
+  float32_t trim;                 /* output when the controller is at rest */
+  float32_t out_min;
+  float32_t out_max;
+  float32_t slew;                 /* max change per step, 0 = unlimited    */
+  float32_t out;                  /* last output                           */
+} control_chan_t;
+
+typedef struct
+{
+  uint32_t steps;
+  uint32_t last;                  /* start of the previous step            */
+  uint32_t period_min;
+  uint32_t period_max;
+  uint32_t exec_min;
+  uint32_t exec_max;
+  uint64_t exec_sum;
+} control_stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+void      control_init(control_chan_t *c, float32_t trim, float32_t out_min,
+                       float32_t out_max, float32_t slew);
+void      control_gains(control_chan_t *c, float32_t kp, float32_t ki, float32_t kd);
+
+/* Returns the new output. */
+float32_t control_step(control_chan_t *c, float32_t setpoint, float32_t measure);
+
+/* Slews the output back to trim and clears the controller, e.g. when the
+   setpoint is lost. */
+float32_t control_hold(control_chan_t *c);
+
+void      control_stats_init(control_stats_t *s);
+void      control_stats_add(control_stats_t *s, uint32_t start, uint32_t end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONTROL_H__ */
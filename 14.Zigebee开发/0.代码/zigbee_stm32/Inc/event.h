@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file           : event.h
+  * @brief          : Bitmask event scheduler for the main loop
+  ******************************************************************************
+  * Interrupt handlers post events with event_post(); the main loop calls
+  * event_run_once(), which runs the handler of every pending event, lowest
+  * event number first. When nothing is pending the loop goes to sleep in
+  * the idle hook (__WFI on the target) until the next interrupt.
+  *
+  * The idle hook is entered with interrupts masked: an event posted after
+  * the pending word was checked still wakes the core, and its interrupt
+  * runs as soon as the mask is lifted, so no event is ever slept through.
+  *
+  * The platform is reached only through event_port_t, so this file does not
+  * depend on the HAL and can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __EVENT_H__
+#define __EVENT_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define EVENT_MAX             32
+
+/* Exported macro ------------------------------------------------------------*/
+#define EVENT(id)             ((uint32_t)1 << (id))
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*event_handler_t)(void);
+
+typedef struct
+{
+  uint32_t (*lock)(void);           /* mask interrupts, return previous state */
+  void     (*unlock)(uint32_t key); /* restore the state returned by lock()   */
+  void     (*idle)(void);           /* sleep until the next interrupt         */
+  uint32_t (*clock)(void);          /* free-running time base, any unit       */
+} event_port_t;
+
+typedef struct
+{
+  uint32_t wakeups;                 /* times the loop left the idle hook      */
+  uint32_t sleep_time;              /* clock units spent in the idle hook     */
+  uint32_t dispatched;              /* handler calls                          */
+  uint32_t count[EVENT_MAX];        /* handler calls per event                */
+} event_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern event_stats_t event_stats;
+
+/* Exported functions --------------------------------------------------------*/
+void     event_init(const event_port_t *port);
+void     event_register(uint8_t id, event_handler_t handler);
+
+/* Safe from interrupt handlers and from the main loop. */
+void     event_post(uint32_t events);
+
+/* Runs the handlers of all pending events, or sleeps if there are none.
+   Returns the number of handlers called. */
+uint16_t event_run_once(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENT_H__ */
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file           : latency.h
+  * @brief          : Request/response latency statistics
+  ******************************************************************************
+  * latency_start() stamps the moment a request has left the UART and
+  * latency_stop() the moment the answer has been received (IDLE line). The
+  * round trip is kept as min/avg/max and as a log-linear histogram: values
+  * below 8 us get a bin each, above that every power of two is split in
+  * 8 bins, so any percentile is known within 12.5 %.
+  *
+  * Times are in microseconds from a free-running 32 bit counter. This file
+  * does not depend on the HAL so it can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define LATENCY_SUB_BITS      3
+#define LATENCY_MAX_BITS      24                  /* last bin holds >= 16.7 s */
+#define LATENCY_BINS          ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  volatile uint32_t t_start;      /* request sent (interrupt context)       */
+  volatile uint8_t  pending;      /* waiting for the answer                 */
+
+  uint32_t count;
+  uint32_t missed;                /* requests that got no answer            */
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint16_t hist[LATENCY_BINS];
+} latency_t;
+
+/* Exported functions --------------------------------------------------------*/
+void     latency_init(latency_t *l);
+
+/* Interrupt context: request transmit complete / answer receive complete.
+   latency_stop() returns 1 when a sample was recorded. */
+void     latency_start(latency_t *l, uint32_t now);
+int      latency_stop(latency_t *l, uint32_t now);
+
+void     latency_record(latency_t *l, uint32_t us);
+
+/* Upper bound of the bin holding the given percentile (0..100). */
+uint32_t latency_percentile(const latency_t *l, uint8_t percent);
+uint32_t latency_avg(const latency_t *l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LATENCY_H__ */
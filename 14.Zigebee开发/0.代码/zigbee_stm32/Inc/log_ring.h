@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file           : log_ring.h
+  * @brief          : Transmit ring for the USART1 log channel
+  ******************************************************************************
+  * Bytes are queued by the main loop (printf) and sent by DMA straight out
+  * of the ring, one contiguous block at a time:
+  *
+  *   sent ........ tail ............ head
+  *   | DMA in flight |    pending     |
+  *
+  * The DMA reads the ring in place, so queued bytes cannot be reclaimed
+  * while a transfer is running: when the ring is full new bytes are dropped
+  * (drop-newest) and counted in dropped.
+  *
+  * Single writer (main loop) and single DMA completion context.
+  * This file does not depend on the HAL so it can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t           *buf;       /* size must be a power of two       */
+  uint16_t           size;
+  volatile uint32_t  head;      /* bytes queued                      */
+  volatile uint32_t  tail;      /* bytes handed to the DMA           */
+  volatile uint32_t  sent;      /* bytes the DMA has finished with   */
+  uint32_t           dropped;   /* bytes lost because the ring was full */
+} log_ring_t;
+
+/* Exported functions --------------------------------------------------------*/
+void     log_ring_init(log_ring_t *r, uint8_t *buf, uint16_t size);
+
+/* Queue len bytes; returns how many were accepted. */
+uint16_t log_ring_write(log_ring_t *r, const uint8_t *data, uint16_t len);
+
+/* If no transfer is in flight, returns the next contiguous pending block and
+   marks it in flight. Returns 0 when busy or empty. */
+uint16_t log_ring_claim(log_ring_t *r, uint8_t **data);
+
+/* The in-flight transfer finished. */
+void     log_ring_done(log_ring_t *r);
+
+uint16_t log_ring_pending(const log_ring_t *r);
+uint8_t  log_ring_busy(const log_ring_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOG_RING_H__ */
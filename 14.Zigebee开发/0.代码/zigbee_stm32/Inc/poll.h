@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : poll.h
+  * @brief          : Per-channel request scheduler with adaptive backoff
+  ******************************************************************************
+  * Every channel sends one request per period, at phase offset from a common
+  * time origin, so channels with the same period do not transmit together.
+  * poll_due() is called from a periodic tick (1 kHz, POLL_PERIOD_MIN) and
+  * tells when the request must go out.
+  *
+  * A request still unanswered when the next one is due counts as a timeout
+  * and doubles the interval, up to POLL_BACKOFF_MAX times. Each answer
+  * halves it again, so the rate settles at what the link can deliver.
+  *
+  * Times are in microseconds. This file does not depend on the HAL so it can
+  * be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __POLL_H__
+#define __POLL_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define POLL_PERIOD_MIN       1000u       /* 1 kHz                          */
+#define POLL_BACKOFF_MAX      6           /* interval up to period * 64     */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t          period;       /* configured, 0 = off                    */
+  uint32_t          phase;
+  uint32_t          interval;     /* period with backoff applied            */
+  uint32_t          next;         /* time the next request is due           */
+  uint8_t           backoff;
+  volatile uint8_t  waiting;      /* request sent, no answer yet            */
+
+  uint32_t          sent;
+  volatile uint32_t answered;
+  uint32_t          timeouts;
+  uint32_t          busy;         /* transmitter not free when due          */
+} poll_chan_t;
+
+/* Exported functions --------------------------------------------------------*/
+void poll_set(poll_chan_t *c, uint32_t period, uint32_t phase, uint32_t now);
+
+/* Returns 1 when a request must be sent now. */
+int  poll_due(poll_chan_t *c, uint32_t now);
+
+/* The request could not be sent. */
+void poll_abort(poll_chan_t *c);
+
+/* Interrupt context: an answer arrived. */
+void poll_answer(poll_chan_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POLL_H__ */
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file           : pose.h
+  * @brief          : Kalman filter for the 6-DOF node pose
+  ******************************************************************************
+  * Every axis is modelled as constant velocity with white acceleration
+  * noise, state [position; rate]. The three linear axes (x, y, z) share one
+  * noise setting and the three angles (theta, phi, gamma) another. Axes in a
+  * group are updated together with the same dt, so they share one 2x2
+  * covariance and one gain, and the group state is a single 2x3 matrix:
+  *
+  *   X = F X,  P = F P F' + Q           (predict)
+  *   K = P H' / (H P H' + R)            (H = [1 0])
+  *   X = X + K (z - H X),  P = (I - K H) P
+  *
+  * The matrix work is done with the CMSIS-DSP arm_mat_* functions. Angles
+  * are in radians: their innovation z - H X is wrapped into (-pi, pi] and
+  * the filtered angle is kept in that range, so crossing +-180 degrees is a
+  * small step and not a jump of 2 pi.
+  *
+  * Only the reference C sources of CMSIS-DSP are used, so this file can be
+  * compiled on a host with -DARM_MATH_CM3 (see Tools/pose_bench.c).
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __POSE_H__
+#define __POSE_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "arm_math.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define POSE_AXES             6   /* x y z theta phi gamma */
+#define POSE_GROUP_AXES       3
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  float32_t               x[2 * POSE_GROUP_AXES]; /* row 0 position, row 1 rate */
+  float32_t               p[2 * 2];
+  float32_t               q;      /* acceleration noise density              */
+  float32_t               r;      /* measurement variance                    */
+  uint8_t                 wrap;   /* positions are angles, wrap at +-pi      */
+  arm_matrix_instance_f32 X;
+  arm_matrix_instance_f32 P;
+} pose_group_t;
+
+typedef struct
+{
+  pose_group_t lin;
+  pose_group_t ang;
+  uint8_t      valid;             /* first measurement seen                  */
+  uint32_t     updates;
+} pose_filter_t;
+
+/* Exported functions --------------------------------------------------------*/
+void pose_init(pose_filter_t *f, float32_t q_lin, float32_t r_lin,
+               float32_t q_ang, float32_t r_ang);
+
+/* z: measured x y z theta phi gamma; dt: seconds since the last update. */
+void pose_update(pose_filter_t *f, const float32_t z[POSE_AXES], float32_t dt);
+
+/* Smoothed pose and its rate of change (units per second). */
+void pose_get(const pose_filter_t *f, float32_t pose[POSE_AXES], float32_t rate[POSE_AXES]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POSE_H__ */
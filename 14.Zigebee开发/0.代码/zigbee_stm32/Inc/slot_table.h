@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file           : slot_table.h
+  * @brief          : Node table rebuilt from slot-table key and delta frames
+  ******************************************************************************
+  * A keyframe (ZB_FRAME_KEY) carries the values of its slots as floats and
+  * becomes the key of those slots. A delta frame (ZB_FRAME_DELTA) carries
+  * value = key + delta * 2^e per channel and is only applied to slots whose
+  * key has the same keyframe id; other slots keep their value until the
+  * next keyframe. The decoded value is within half a quantum of the value
+  * sent. A report frame (ZB_FRAME_REPORT) sets the values of the slots it
+  * lists and leaves their key alone.
+  *
+  * This file does not depend on the HAL so it can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SLOT_TABLE_H__
+#define __SLOT_TABLE_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "zb_frame.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SLOT_TABLE_SLOTS      32
+#define SLOT_TABLE_M          4           /* channels kept per slot         */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  id;                    /* keyframe id of key[]                   */
+  uint8_t  valid;
+  uint8_t  m;                     /* channels in value[]                    */
+  uint32_t frame;                 /* slot_table_t.frames when last decoded  */
+  float    key[SLOT_TABLE_M];
+  float    value[SLOT_TABLE_M];
+} slot_entry_t;
+
+typedef struct
+{
+  slot_entry_t slot[SLOT_TABLE_SLOTS];
+  uint32_t     frames;
+  uint32_t     keyframes;
+  uint32_t     deltas;
+  uint32_t     reports;
+  uint32_t     stale;             /* slots of delta frames without their key */
+} slot_table_t;
+
+/* Exported functions --------------------------------------------------------*/
+void     slot_table_init(slot_table_t *t);
+
+/* Applies a ZB_FRAME_KEY, ZB_FRAME_DELTA or ZB_FRAME_REPORT frame and
+   returns the number of slots decoded. Those slots have slot[i].frame == t->frames afterwards.
+   Slots whose values would run past f->length are not decoded. */
+uint16_t slot_table_update(slot_table_t *t, const zb_frame_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SLOT_TABLE_H__ */
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.h
+  * @brief          : Telemetry records for the USART1 log channel
+  ******************************************************************************
+  * Binary mode sends one COBS encoded record per decoded value, terminated
+  * by 0x00:
+  *
+  *   ver | seq(2) | tick_ms(4) | node(2) | value(float, 4) | xor
+  *
+  * All fields are little endian, xor covers ver .. value. Text mode prints
+  * the same fields as "seq tick node value" lines.
+  *
+  * This file does not depend on the HAL; Tools/telemetry_dump.c uses it to
+  * decode captures on a PC.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define TELEMETRY_BINARY       0
+#define TELEMETRY_TEXT         1
+
+#define TELEMETRY_VERSION      0x01
+#define TELEMETRY_RECORD_LEN   14
+/* COBS adds one byte per 254, plus the 0x00 delimiter. */
+#define TELEMETRY_FRAME_MAX    (TELEMETRY_RECORD_LEN + 2)
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*telemetry_write_t)(const uint8_t *data, uint16_t len);
+
+typedef struct
+{
+  uint16_t seq;
+  uint32_t tick;
+  uint16_t node;
+  float    value;
+} telemetry_record_t;
+
+typedef struct
+{
+  uint8_t           mode;
+  uint16_t          seq;
+  telemetry_write_t write;
+} telemetry_t;
+
+/* Exported functions --------------------------------------------------------*/
+void     telemetry_init(telemetry_t *t, uint8_t mode, telemetry_write_t write);
+void     telemetry_send(telemetry_t *t, uint32_t tick, uint16_t node, float value);
+
+void     telemetry_pack(const telemetry_record_t *rec, uint8_t *buf);
+int      telemetry_unpack(const uint8_t *buf, uint16_t len, telemetry_record_t *rec);
+
+uint16_t cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+uint16_t cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TELEMETRY_H__ */
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file           : uart_port.h
+  * @brief          : Table driven receive ports (circular DMA + frame decoder)
+  ******************************************************************************
+  * Every entry of the port table owns one USART, its RX DMA channel running
+  * in circular mode, a receive ring and a frame decoder. The interrupt
+  * handlers only publish the DMA position; uart_port_poll() decodes all
+  * ports from the main loop and calls each port's frame handler, or hands
+  * the raw ring to the port's on_rx handler.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_PORT_H__
+#define __UART_PORT_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include "uart_ring.h"
+#include "zb_frame.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct uart_port uart_port_t;
+
+typedef void (*uart_port_frame_t)(uart_port_t *port, const zb_frame_t *frame);
+typedef void (*uart_port_rx_t)(uart_port_t *port);
+
+struct uart_port
+{
+  UART_HandleTypeDef *huart;
+  uint8_t            *rx_buf;     /* circular DMA target, power of two */
+  uint16_t            rx_size;
+  uart_port_frame_t   on_frame;
+  float              *value;      /* value addressed to this board, may be NULL */
+  uart_port_rx_t      on_rx;      /* if set, consumes the raw ring instead of
+                                     the frame decoder */
+
+  uart_ring_t         ring;
+  zb_frame_stats_t    stats;
+  volatile uint8_t    rx_event;   /* set by the IDLE interrupt */
+};
+
+/* Exported functions --------------------------------------------------------*/
+void         uart_port_start(uart_port_t *ports, uint8_t count);
+uart_port_t *uart_port_find(UART_HandleTypeDef *huart);
+
+/* Interrupt context. */
+void         uart_port_irq(UART_HandleTypeDef *huart);
+void         uart_port_rx_event(UART_HandleTypeDef *huart);
+void         uart_port_rx_error(UART_HandleTypeDef *huart);
+
+/* Called from interrupt context when new bytes are in a port's ring, and
+   when the line went idle after a burst. The defaults do nothing. */
+void         uart_port_rx_callback(uart_port_t *port);
+void         uart_port_idle_callback(uart_port_t *port);
+
+/* Main loop. */
+void         uart_port_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_PORT_H__ */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file           : uart_ring.h
+  * @brief          : Circular-DMA receive ring (single producer, single consumer)
+  ******************************************************************************
+  * The DMA channel runs in circular mode over the ring storage and is never
+  * stopped. The USART IDLE interrupt and the DMA half/full transfer interrupts
+  * publish the DMA write position (producer, ISR context); the main loop
+  * consumes the bytes in place (consumer). head and tail are free-running
+  * byte counters, each written by one side only, so no locking is needed.
+  *
+  * This file does not depend on the HAL so it can be compiled on a host.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_RING_H__
+#define __UART_RING_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t           *buf;          /* DMA target, size is a power of two     */
+  uint16_t           size;
+  uint16_t           dma_pos;      /* last DMA write offset (producer)       */
+  volatile uint32_t  head;         /* bytes written (producer)               */
+  volatile uint32_t  tail;         /* bytes consumed (consumer)              */
+  volatile uint32_t  restart_head; /* head value when the DMA restarted      */
+  volatile uint16_t  restarts;     /* DMA restarts (producer)                */
+  uint16_t           restarts_seen;/* restarts handled (consumer)            */
+  uint32_t           overruns;     /* times the DMA lapped the consumer      */
+} uart_ring_t;
+
+/* Exported functions --------------------------------------------------------*/
+void     uart_ring_init(uart_ring_t *r, uint8_t *buf, uint16_t size);
+
+/* Producer: call from the IDLE, half-transfer and transfer-complete events
+   with the current DMA NDTR value (__HAL_DMA_GET_COUNTER). */
+void     uart_ring_dma_update(uart_ring_t *r, uint16_t ndtr);
+
+/* Producer: the DMA was restarted at offset 0, e.g. after a UART error. */
+void     uart_ring_dma_restart(uart_ring_t *r);
+
+/* Consumer. */
+uint16_t uart_ring_count(uart_ring_t *r);
+uint16_t uart_ring_peek(uart_ring_t *r, uint8_t **data);
+void     uart_ring_skip(uart_ring_t *r, uint16_t len);
+uint16_t uart_ring_read(uart_ring_t *r, uint8_t *dst, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_RING_H__ */
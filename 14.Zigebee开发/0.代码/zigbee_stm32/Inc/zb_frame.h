@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file           : zb_frame.h
+  * @brief          : Streaming decoder for the 0x3A ... 0x23 ZigBee frames
+  ******************************************************************************
+  * Six frame layouts are accepted:
+  *
+  *   node frame  (9 bytes, sent by an end device for its own slot, and by
+  *                the coordinator once per node of its table)
+  *     0x3A | addr_hi addr_lo | f0 f1 f2 f3 | xor | 0x23
+  *     xor covers addr_hi .. f3.
+  *
+  *   pose frame  (29 bytes, full pose of one node)
+  *     0x3B | addr_hi addr_lo | x y z theta phi gamma (6 x float) | xor | 0x23
+  *     xor covers addr_hi .. the last float byte.
+  *
+  *   table frame (26 bytes, fixed 4-slot table of older coordinator builds)
+  *     0x3A | 4 x (addr_hi addr_lo f0 f1 f2 f3) | 0x23
+  *
+  *   slot-table frame (variable, SerialApp SlotFrame.h, coordinator built
+  *   with SERIAL_APP_UART_TABLE)
+  *     0x3C | seq id first count m | count*m floats              | xor | 0x23
+  *     0x3E | seq id first count m | m exponents | count*m int16 | xor | 0x23
+  *     xor covers seq .. the last value byte. Slots carry no address; the
+  *     slot index stands in for it. Delta frames are decoded by slot_table.h.
+  *
+  *   report frame (variable, coordinator: slots refreshed by the end
+  *                 devices in one superframe)
+  *     0x41 | seq count m | count * (slot, m floats) | xor | 0x23
+  *     xor covers seq .. the last value byte.
+  *
+  *   link frame  (13 bytes, sent by an end device for every sender of
+  *                slot-table frames it has heard)
+  *     0x3F | src_hi src_lo | rx lost dup reorder (4 x uint16, big-endian)
+  *          | xor | 0x23
+  *     xor covers src_hi .. reorder_lo.
+  *
+  * Node frames are also written to an end device to set its uplink values;
+  * the address field is then the channel (zb_frame_put_node).
+  *
+  * Frames are validated in place in the receive ring and returned as a view
+  * into the ring memory; nothing is copied until a field is read. Garbage
+  * and truncated frames are skipped byte by byte until the next start byte.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ZB_FRAME_H__
+#define __ZB_FRAME_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "uart_ring.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define ZB_FRAME_SOF          0x3A
+#define ZB_FRAME_POSE_SOF     0x3B
+#define ZB_FRAME_KEY_SOF      0x3C
+#define ZB_FRAME_DELTA_SOF    0x3E
+#define ZB_FRAME_LINK_SOF     0x3F
+#define ZB_FRAME_REPORT_SOF   0x41
+#define ZB_FRAME_EOF          0x23
+
+#define ZB_FRAME_SLOT_LEN     6
+#define ZB_FRAME_NODE_LEN     (1 + ZB_FRAME_SLOT_LEN + 1 + 1)
+#define ZB_FRAME_TABLE_SLOTS  4
+#define ZB_FRAME_TABLE_LEN    (1 + ZB_FRAME_TABLE_SLOTS * ZB_FRAME_SLOT_LEN + 1)
+#define ZB_FRAME_POSE_AXES    6
+#define ZB_FRAME_POSE_LEN     (1 + 2 + ZB_FRAME_POSE_AXES * 4 + 1 + 1)
+#define ZB_FRAME_LINK_LEN     (1 + 2 + 4 * 2 + 1 + 1)
+#define ZB_FRAME_TAB_HDR      6
+#define ZB_FRAME_REPORT_HDR   4
+#define ZB_FRAME_TAB_MAX      128   /* longest slot-table frame accepted */
+
+#define ZB_FRAME_NODE         1
+#define ZB_FRAME_TABLE        2
+#define ZB_FRAME_POSE         3
+#define ZB_FRAME_KEY          4
+#define ZB_FRAME_DELTA        5
+#define ZB_FRAME_LINK         6
+#define ZB_FRAME_REPORT       7
+
+/* Exported types ------------------------------------------------------------*/
+
+/* A frame that sits in the ring. It can wrap, so it is made of two segments. */
+typedef struct
+{
+  const uint8_t *seg[2];
+  uint16_t       seg_len[2];
+  uint16_t       length;
+  uint8_t        type;
+} zb_frame_t;
+
+/* Link statistics of one sender as counted by an end device. */
+typedef struct
+{
+  uint16_t addr;
+  uint16_t rx;             /* frames used                                 */
+  uint16_t lost;           /* gaps in the sequence numbers                */
+  uint16_t dup;
+  uint16_t reorder;        /* late frames dropped, a newer one was used   */
+} zb_frame_link_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t skipped;        /* bytes discarded while resynchronizing */
+  uint32_t bad_checksum;
+} zb_frame_stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/* Returns 1 and fills f when a complete frame is at the read position of the
+   ring, 0 when more bytes are needed. The frame stays in the ring until
+   zb_frame_release() is called. */
+int      zb_frame_next(uart_ring_t *r, zb_frame_t *f, zb_frame_stats_t *st);
+void     zb_frame_release(uart_ring_t *r, const zb_frame_t *f);
+
+/* Bytes past the end of the frame read as 0, and a float that does not
+   fit in the frame as 0. */
+uint8_t  zb_frame_byte(const zb_frame_t *f, uint16_t off);
+float    zb_frame_float(const zb_frame_t *f, uint16_t off);
+uint16_t zb_frame_slots(const zb_frame_t *f);
+/* Node address of a slot; the slot index of the node table for key, delta
+   and report frames. */
+uint16_t zb_frame_slot_addr(const zb_frame_t *f, uint16_t slot);
+/* First value of a slot; 0 for delta frames, see slot_table.h. */
+float    zb_frame_slot_float(const zb_frame_t *f, uint16_t slot);
+
+/* The six floats of a pose frame. */
+void     zb_frame_pose(const zb_frame_t *f, float pose[ZB_FRAME_POSE_AXES]);
+
+/* Writes a node frame to buf (ZB_FRAME_NODE_LEN bytes), returns its length. */
+uint16_t zb_frame_put_node(uint8_t *buf, uint16_t addr, float value);
+
+/* The counters of a link frame. */
+void     zb_frame_link(const zb_frame_t *f, zb_frame_link_t *link);
+
+/* Value of the slot addressed to addr; returns 0 if the frame has none. */
+int      zb_frame_find(const zb_frame_t *f, uint16_t addr, float *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ZB_FRAME_H__ */
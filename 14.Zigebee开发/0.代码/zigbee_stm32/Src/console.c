@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file           : console.c
+  * @brief          : Line based command console on a receive ring
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "console.h"
+
+/* Private variables ---------------------------------------------------------*/
+static const console_cmd_t *console_cmds;
+static uint8_t              console_count;
+static char                 console_line[CONSOLE_LINE_MAX];
+static uint8_t              console_len;
+static uint8_t              console_overflow;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void console_help(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < console_count; i++)
+    printf("%s\r\n", console_cmds[i].help);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void console_init(const console_cmd_t *cmds, uint8_t count)
+{
+  console_cmds     = cmds;
+  console_count    = count;
+  console_len      = 0;
+  console_overflow = 0;
+}
+
+void console_exec(char *line)
+{
+  char *argv[CONSOLE_ARGS_MAX];
+  int argc = 0;
+  uint8_t i;
+
+  while(*line != '\0' && argc < CONSOLE_ARGS_MAX)
+  {
+    while(*line == ' ' || *line == '\t')
+      *line++ = '\0';
+    if(*line == '\0')
+      break;
+    argv[argc++] = line;
+    while(*line != '\0' && *line != ' ' && *line != '\t')
+      line++;
+  }
+  if(argc == 0)
+    return;
+
+  for(i = 0; i < console_count; i++)
+  {
+    if(strcmp(argv[0], console_cmds[i].name) == 0)
+    {
+      console_cmds[i].run(argc, argv);
+      return;
+    }
+  }
+  if(strcmp(argv[0], "help") != 0)
+    printf("unknown command: %s\r\n", argv[0]);
+  console_help();
+}
+
+void console_input(uart_ring_t *r)
+{
+  uint8_t c;
+
+  while(uart_ring_read(r, &c, 1) == 1)
+  {
+    if(c != '\r' && c != '\n')
+    {
+      if(console_len < CONSOLE_LINE_MAX - 1)
+        console_line[console_len++] = (char)c;
+      else
+        console_overflow = 1;
+      continue;
+    }
+
+    /* End of line: overlong lines are dropped as a whole. */
+    console_line[console_len] = '\0';
+    if(console_overflow)
+      printf("line too long\r\n");
+    else
+      console_exec(console_line);
+    console_len      = 0;
+    console_overflow = 0;
+  }
+}
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file           : control.c
+  * @brief          : PID + slew limited PWM output stage
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "control.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static float32_t control_limit(control_chan_t *c, float32_t out)
+{
+  if(out > c->out_max)
+    out = c->out_max;
+  if(out < c->out_min)
+    out = c->out_min;
+  if(c->slew > 0.0f)
+  {
+    if(out > c->out + c->slew)
+      out = c->out + c->slew;
+    if(out < c->out - c->slew)
+      out = c->out - c->slew;
+  }
+  c->out = out;
+  return out;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void control_init(control_chan_t *c, float32_t trim, float32_t out_min,
+                  float32_t out_max, float32_t slew)
+{
+  memset(c, 0, sizeof(*c));
+  c->trim    = trim;
+  c->out_min = out_min;
+  c->out_max = out_max;
+  c->slew    = slew;
+  c->out     = trim;
+  arm_pid_init_f32(&c->pid, 1);
+}
+
+void control_gains(control_chan_t *c, float32_t kp, float32_t ki, float32_t kd)
+{
+  c->pid.Kp = kp;
+  c->pid.Ki = ki;
+  c->pid.Kd = kd;
+  /* Keep the state so the output does not jump. */
+  arm_pid_init_f32(&c->pid, 0);
+}
+
+float32_t control_step(control_chan_t *c, float32_t setpoint, float32_t measure)
+{
+  float32_t out = control_limit(c, c->trim + arm_pid_f32(&c->pid, setpoint - measure));
+
+  /* Anti-windup: continue from the output that was actually applied. */
+  c->pid.state[2] = out - c->trim;
+  return out;
+}
+
+float32_t control_hold(control_chan_t *c)
+{
+  arm_pid_reset_f32(&c->pid);
+  return control_limit(c, c->trim);
+}
+
+void control_stats_init(control_stats_t *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->period_min = 0xFFFFFFFFu;
+  s->exec_min   = 0xFFFFFFFFu;
+}
+
+void control_stats_add(control_stats_t *s, uint32_t start, uint32_t end)
+{
+  uint32_t exec = end - start;
+  uint32_t period;
+
+  if(s->steps != 0)
+  {
+    period = start - s->last;
+    if(period < s->period_min)
+      s->period_min = period;
+    if(period > s->period_max)
+      s->period_max = period;
+  }
+  s->last = start;
+  if(exec < s->exec_min)
+    s->exec_min = exec;
+  if(exec > s->exec_max)
+    s->exec_max = exec;
+  s->exec_sum += exec;
+  s->steps++;
+}
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file           : event.c
+  * @brief          : Bitmask event scheduler for the main loop
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "event.h"
+
+/* Exported variables --------------------------------------------------------*/
+event_stats_t event_stats;
+
+/* Private variables ---------------------------------------------------------*/
+static const event_port_t *event_port;
+static event_handler_t     event_handlers[EVENT_MAX];
+static volatile uint32_t   event_pending;
+
+/* Exported functions --------------------------------------------------------*/
+
+void event_init(const event_port_t *port)
+{
+  event_port    = port;
+  event_pending = 0;
+  memset(event_handlers, 0, sizeof(event_handlers));
+  memset(&event_stats, 0, sizeof(event_stats));
+}
+
+void event_register(uint8_t id, event_handler_t handler)
+{
+  if(id < EVENT_MAX)
+    event_handlers[id] = handler;
+}
+
+void event_post(uint32_t events)
+{
+  uint32_t key = event_port->lock();
+
+  event_pending |= events;
+  event_port->unlock(key);
+}
+
+uint16_t event_run_once(void)
+{
+  uint32_t key, events, start;
+  uint16_t calls = 0;
+  uint8_t  id;
+
+  key = event_port->lock();
+  events = event_pending;
+  if(events == 0)
+  {
+    /* The waking interrupt is serviced once unlock() lifts the mask. */
+    start = event_port->clock();
+    event_port->idle();
+    event_stats.sleep_time += event_port->clock() - start;
+    event_stats.wakeups++;
+    event_port->unlock(key);
+    return 0;
+  }
+  event_pending = 0;
+  event_port->unlock(key);
+
+  for(id = 0; events != 0; id++, events >>= 1)
+  {
+    if((events & 1) == 0)
+      continue;
+    event_stats.count[id]++;
+    if(event_handlers[id] != NULL)
+    {
+      event_handlers[id]();
+      calls++;
+    }
+  }
+  event_stats.dispatched += calls;
+  return calls;
+}
@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file           : latency.c
+  * @brief          : Request/response latency statistics
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "latency.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SUB_BINS      (1u << LATENCY_SUB_BITS)
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint8_t msb(uint32_t v)
+{
+  uint8_t n = 0;
+
+  while(v >>= 1)
+    n++;
+  return n;
+}
+
+static uint16_t latency_bin(uint32_t us)
+{
+  uint8_t e;
+
+  if(us < SUB_BINS)
+    return (uint16_t)us;
+  e = msb(us);
+  if(e >= LATENCY_MAX_BITS)
+    return LATENCY_BINS - 1;
+  return (uint16_t)(((e - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) |
+                    ((us >> (e - LATENCY_SUB_BITS)) & (SUB_BINS - 1)));
+}
+
+/* Largest value that falls in the bin. */
+static uint32_t latency_bin_top(uint16_t bin)
+{
+  uint8_t  e   = (uint8_t)((bin >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1);
+  uint32_t sub = bin & (SUB_BINS - 1);
+
+  if(bin < SUB_BINS)
+    return bin;
+  if(bin == LATENCY_BINS - 1)
+    return 0xFFFFFFFFu;
+  return ((SUB_BINS + sub + 1) << (e - LATENCY_SUB_BITS)) - 1;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void latency_init(latency_t *l)
+{
+  memset(l, 0, sizeof(*l));
+  l->min = 0xFFFFFFFFu;
+}
+
+void latency_start(latency_t *l, uint32_t now)
+{
+  if(l->pending)
+    l->missed++;
+  l->t_start = now;
+  l->pending = 1;
+}
+
+int latency_stop(latency_t *l, uint32_t now)
+{
+  if(!l->pending)
+    return 0;
+  l->pending = 0;
+  latency_record(l, now - l->t_start);
+  return 1;
+}
+
+void latency_record(latency_t *l, uint32_t us)
+{
+  uint16_t bin = latency_bin(us);
+
+  if(us < l->min)
+    l->min = us;
+  if(us > l->max)
+    l->max = us;
+  l->sum += us;
+  l->count++;
+  if(l->hist[bin] != 0xFFFF)
+    l->hist[bin]++;
+}
+
+uint32_t latency_percentile(const latency_t *l, uint8_t percent)
+{
+  uint32_t total = 0, rank, seen = 0;
+  uint16_t bin;
+
+  for(bin = 0; bin < LATENCY_BINS; bin++)
+    total += l->hist[bin];
+  if(total == 0)
+    return 0;
+
+  /* Smallest bin that covers percent of the samples. */
+  rank = (total * percent + 99) / 100;
+  if(rank == 0)
+    rank = 1;
+  for(bin = 0; bin < LATENCY_BINS; bin++)
+  {
+    seen += l->hist[bin];
+    if(seen >= rank)
+      break;
+  }
+  if(bin == LATENCY_BINS)
+    bin = LATENCY_BINS - 1;
+  return latency_bin_top(bin) < l->max ? latency_bin_top(bin) : l->max;
+}
+
+uint32_t latency_avg(const latency_t *l)
+{
+  return l->count ? (uint32_t)(l->sum / l->count) : 0;
+}
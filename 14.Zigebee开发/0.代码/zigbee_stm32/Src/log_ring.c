@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file           : log_ring.c
+  * @brief          : Transmit ring for the USART1 log channel
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "log_ring.h"
+
+/* Exported functions --------------------------------------------------------*/
+
+void log_ring_init(log_ring_t *r, uint8_t *buf, uint16_t size)
+{
+  r->buf     = buf;
+  r->size    = size;
+  r->head    = 0;
+  r->tail    = 0;
+  r->sent    = 0;
+  r->dropped = 0;
+}
+
+uint16_t log_ring_write(log_ring_t *r, const uint8_t *data, uint16_t len)
+{
+  uint32_t space = r->size - (r->head - r->sent);
+  uint16_t off   = (uint16_t)r->head & (r->size - 1);
+  uint16_t first;
+
+  if(len > space)
+  {
+    r->dropped += len - space;
+    len = (uint16_t)space;
+  }
+
+  first = r->size - off;
+  if(first > len)
+    first = len;
+  memcpy(&r->buf[off], data, first);
+  memcpy(r->buf, &data[first], len - first);
+
+  r->head += len;
+  return len;
+}
+
+uint16_t log_ring_claim(log_ring_t *r, uint8_t **data)
+{
+  uint32_t pending = r->head - r->tail;
+  uint16_t off     = (uint16_t)r->tail & (r->size - 1);
+  uint16_t len     = r->size - off;
+
+  if(r->tail != r->sent || pending == 0)
+    return 0;
+
+  if(pending < len)
+    len = (uint16_t)pending;
+  *data = &r->buf[off];
+  r->tail += len;
+  return len;
+}
+
+void log_ring_done(log_ring_t *r)
+{
+  r->sent = r->tail;
+}
+
+uint16_t log_ring_pending(const log_ring_t *r)
+{
+  return (uint16_t)(r->head - r->sent);
+}
+
+uint8_t log_ring_busy(const log_ring_t *r)
+{
+  return r->tail != r->sent;
+}
@@ -41,24 +41,75 @@
 #include "stm32f1xx_hal.h"
 
 /* USER CODE BEGIN Includes */
-
+#include <stdlib.h>
+#include <string.h>
+#include "uart_port.h"
+#include "event.h"
+#include "latency.h"
+#include "poll.h"
+#include "control.h"
+#include "pose.h"
+#include "console.h"
+#include "log_ring.h"
+#include "telemetry.h"
+#include "slot_table.h"
 /* USER CODE END Includes */
 
 /* Private variables ---------------------------------------------------------*/
 TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim2;
 TIM_HandleTypeDef htim3;
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
+UART_HandleTypeDef huart3;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_usart3_rx;
+DMA_HandleTypeDef hdma_usart3_tx;
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
 
 
-#define BUFFERSIZE_left 20				
-uint8_t ReceiveBuff_left[BUFFERSIZE_left];						//ջ
-uint8_t recv_end_flag_left = 0,Rx_len_left=0;
+#define RX_BUFSIZE 256					//ÿڵѭDMAջ,2
+uint8_t rx_buf_usart1[RX_BUFSIZE];
+uint8_t rx_buf_usart2[RX_BUFSIZE];
+uint8_t rx_buf_usart3[RX_BUFSIZE];
+
+#define LOCAL_NODE_ID 0x0002			//ڵЭݱеĵַ
+
+#define LOG_BUFSIZE 1024				//1ӡͻ,2
+uint8_t log_buf[LOG_BUFSIZE];
+log_ring_t log_tx;
+
+/*	ѭ¼,Сȴ	*/
+#define EV_UART_RX  0					//ڽյ
+#define EV_REQUEST  1					//TIM1 1kHz: ˿Ƿ˷ʱ
+
+#define REQUEST_PERIOD 10000			//Ĭ(us),100Hz
+
+/*	TIM3 4·PWM(50Hz,λ10us)ջ	*/
+#define PWM_CHANNELS 4
+#define PWM_TRIM    150					//1.5ms,ֹͣ
+#define PWM_MIN     100
+#define PWM_MAX     200
+#define PWM_SLEW    2.0f				//ÿPWM仯
+#define PID_KP      1.0f				//ĬPID,pid޸
+#define PID_KI      0.0f
+#define PID_KD      0.0f
+
+/*	ڵλ(x y z theta phi gamma)˲	*/
+#define POSE_NODES  4					//ٵĽڵ
+#define POSE_Q_LIN  100.0f				//߼ٶ
+#define POSE_R_LIN  0.0025f				//λò
+#define POSE_Q_ANG  100.0f				//Ǽٶ
+#define POSE_R_ANG  0.0025f				//ǶȲ
+
+#define TELEMETRY_MODE TELEMETRY_BINARY	//1ʽ: TELEMETRY_BINARY / TELEMETRY_TEXT
+telemetry_t telem;
 
 union position1
 {
@@ -72,7 +123,90 @@ uint8_t aTxStartMessages[] ="?s\r\n";
 int car_speed=145;//150--stop
 
 
-void uartdamget_left(void);
+void port_frame(uart_port_t *port, const zb_frame_t *frame);
+void request_send(void);
+void console_rx(uart_port_t *port);
+void cmd_lat(int argc, char *argv[]);
+void cmd_rate(int argc, char *argv[]);
+void cmd_ctl(int argc, char *argv[]);
+void cmd_pid(int argc, char *argv[]);
+void pwm_update(void);
+void pose_frame(const zb_frame_t *frame);
+void cmd_pose(int argc, char *argv[]);
+void table_frame(const zb_frame_t *frame);
+void cmd_tab(int argc, char *argv[]);
+void link_frame(const zb_frame_t *frame);
+void cmd_link(int argc, char *argv[]);
+void cmd_up(int argc, char *argv[]);
+uint32_t micros(void);
+uint32_t sched_lock(void);
+void sched_unlock(uint32_t primask);
+void sched_idle(void);
+void log_kick(void);
+void log_flush(void);
+void telemetry_out(const uint8_t *data, uint16_t len);
+
+/*	ն˿ڱ: ÿڶDMAͨλ֡	*/
+uart_port_t uart_ports[] =
+{
+	/*      ջ      С        ֡      ڵ/ */
+	{ &huart1, rx_buf_usart1, RX_BUFSIZE, NULL,       NULL, console_rx },
+	{ &huart2, rx_buf_usart2, RX_BUFSIZE, port_frame, &x1_data.position1_float },
+	{ &huart3, rx_buf_usart3, RX_BUFSIZE, port_frame, &y1_data.position1_float },
+};
+
+/*	ÿ˿ڵ-Ӧʱͳ,˿ڱһһӦ	*/
+latency_t port_latency[sizeof(uart_ports) / sizeof(uart_ports[0])];
+/*	ÿ˿ڵ,Ϊ0Ķ˿ڲ	*/
+poll_chan_t port_poll[sizeof(uart_ports) / sizeof(uart_ports[0])];
+
+/*	PWMͨ趨ֵ(ZigBee,2)ͷ(3),ΪNULLֹͨͣ	*/
+float * const pwm_setpoint[PWM_CHANNELS] = { &x1_data.position1_float, NULL, NULL, NULL };
+float * const pwm_measure[PWM_CHANNELS]  = { &y1_data.position1_float, NULL, NULL, NULL };
+const uint32_t pwm_channel[PWM_CHANNELS] = { TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4 };
+control_chan_t pwm_ctl[PWM_CHANNELS];
+control_stats_t pwm_stats;
+
+/*	ÿڵһλ˲,ڵƽλдpose_filtered,仯дpose_rate
+	(x1/y1PWM趨ֵͷ,λ˲д)	*/
+uint16_t pose_addr[POSE_NODES];
+uint32_t pose_time[POSE_NODES];
+pose_filter_t pose_filt[POSE_NODES];
+uint8_t pose_nodes;
+float pose_filtered[POSE_AXES];
+float pose_rate[POSE_AXES];
+
+/*	Эݱ֡(ؼ֡/֡)ʱ,ڴ˻ԭ۵	*/
+slot_table_t node_table;
+
+/*	նͳƵĸߵ·(յ/ʧ/ظ/)	*/
+#define LINK_NODES 8
+zb_frame_link_t link_stats[LINK_NODES];
+uint8_t link_nodes;
+
+/*	: 󷢸ն˵Ĳֵ,ÿͨһڵ֡(ֶַΪͨ),
+	նԼʱ϶Э	*/
+#define UPLINK_CH  4
+float uplink_value[UPLINK_CH];
+uint8_t uplink_mask;					//λͨŷ
+uint8_t port_tx[sizeof(uart_ports) / sizeof(uart_ports[0])][sizeof(aTxStartMessages) + UPLINK_CH * ZB_FRAME_NODE_LEN];
+
+volatile uint16_t us_overflows;			//TIM2,micros()ĸ16λ
+
+const event_port_t sched_port = { sched_lock, sched_unlock, sched_idle, micros };
+
+/*	1	*/
+const console_cmd_t console_cmds[] =
+{
+	{ "lat", cmd_lat, "lat [reset]    request/answer latency per port (us)" },
+	{ "rate", cmd_rate, "rate [port hz [phase_us]]    request rate per port, 0 = off, max 1000" },
+	{ "ctl", cmd_ctl, "ctl [reset]    PWM outputs and control loop timing (us)" },
+	{ "pid", cmd_pid, "pid ch kp ki kd    set the PID gains of a PWM channel" },
+	{ "pose", cmd_pose, "pose    filtered pose and rate per node" },
+	{ "tab", cmd_tab, "tab    node table decoded from key/delta frames" },
+	{ "link", cmd_link, "link    lost/duplicate/late frames per sender, counted by the end device" },
+	{ "up", cmd_up, "up [ch value|ch off]    values sent up to the coordinator with each request" },
+};
 
 /* USER CODE END PV */
 
@@ -82,7 +216,9 @@ static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_USART3_UART_Init(void);
 static void MX_TIM1_Init(void);
+static void MX_TIM2_Init(void);
 static void MX_TIM3_Init(void);
 static void MX_NVIC_Init(void);
                                     
@@ -100,7 +236,11 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 #endif 
 PUTCHAR_PROTOTYPE
 {
-	HAL_UART_Transmit(&huart1 , (uint8_t *)&ch, 1, 0xFFFF);
+	uint8_t c = (uint8_t)ch;
+
+	/*	д뷢ͻ,DMA,ѭ	*/
+	log_ring_write(&log_tx, &c, 1);
+	log_kick();
 return ch;
 }
 
@@ -132,7 +272,21 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  log_ring_init(&log_tx, log_buf, LOG_BUFSIZE);
+  telemetry_init(&telem, TELEMETRY_MODE, telemetry_out);
+  slot_table_init(&node_table);
+  event_init(&sched_port);
+  event_register(EV_UART_RX, uart_port_poll);
+  event_register(EV_REQUEST, request_send);
+  console_init(console_cmds, sizeof(console_cmds) / sizeof(console_cmds[0]));
+  for(int i = 0; i < sizeof(port_latency) / sizeof(port_latency[0]); i++)
+    latency_init(&port_latency[i]);
+  for(int i = 0; i < PWM_CHANNELS; i++)
+  {
+    control_init(&pwm_ctl[i], PWM_TRIM, PWM_MIN, PWM_MAX, PWM_SLEW);
+    control_gains(&pwm_ctl[i], PID_KP, PID_KI, PID_KD);
+  }
+  control_stats_init(&pwm_stats);
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -147,19 +301,30 @@ int main(void)
   MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_USART2_UART_Init();
+  MX_USART3_UART_Init();
   MX_TIM1_Init();
+  MX_TIM2_Init();
   MX_TIM3_Init();
 
   /* Initialize interrupts */
   MX_NVIC_Init();
   /* USER CODE BEGIN 2 */
 	//printf("This is a USART DMA Receive Test!!!\r\n");
-	/*	ʹܴ1 IDLEж	*/
+	/*	ʹܸ IDLEж,ѭDMA(ֻһ,ֹͣ)	*/
 
-	__HAL_UART_ENABLE_IT(&huart2, UART_IT_IDLE);  //dma,ж
+	uart_port_start(uart_ports, sizeof(uart_ports) / sizeof(uart_ports[0]));
 	
 
-   HAL_TIM_Base_Start_IT(&htim1);//ʱ
+   HAL_TIM_Base_Start_IT(&htim2);//1usɼ,ʱʱ׼
+   /*	23,λ	*/
+   poll_set(&port_poll[1], REQUEST_PERIOD, 0, micros());
+   poll_set(&port_poll[2], REQUEST_PERIOD, REQUEST_PERIOD / 2, micros());
+   HAL_TIM_Base_Start_IT(&htim1);//1kHzȽ
+
+   /*	PWM,ÿ¼һο	*/
+   for(int i = 0; i < PWM_CHANNELS; i++)
+     HAL_TIM_PWM_Start(&htim3, pwm_channel[i]);
+   HAL_TIM_Base_Start_IT(&htim3);
 	 
 
   /* USER CODE END 2 */
@@ -168,9 +333,8 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
- //  uartdamget();
-	 uartdamget_left();
-		
+	 /*	ISRύ¼,û¼ʱWFI	*/
+	 event_run_once();
 
   /* USER CODE END WHILE */
 
@@ -243,9 +407,27 @@ static void MX_NVIC_Init(void)
   /* USART2_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(USART2_IRQn);
+  /* USART3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(USART3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(USART3_IRQn);
+  /* DMA1_Channel2_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+  /* DMA1_Channel3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+  /* DMA1_Channel4_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  /* DMA1_Channel5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
   /* DMA1_Channel6_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+  /* DMA1_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
 }
 
 /* TIM1 init function */
@@ -256,7 +438,7 @@ static void MX_TIM1_Init(void)
   TIM_MasterConfigTypeDef sMasterConfig;
 
   htim1.Instance = TIM1;
-  htim1.Init.Prescaler = 36000-1;
+  htim1.Init.Prescaler = 72-1;
   htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim1.Init.Period = 1000-1;
   htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
@@ -282,6 +464,39 @@ static void MX_TIM1_Init(void)
 
 }
 
+/* TIM2 init function */
+static void MX_TIM2_Init(void)
+{
+
+  TIM_ClockConfigTypeDef sClockSourceConfig;
+  TIM_MasterConfigTypeDef sMasterConfig;
+
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 72-1;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 0xFFFF;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+}
+
 /* TIM3 init function */
 static void MX_TIM3_Init(void)
 {
@@ -373,6 +588,25 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/* USART3 init function */
+static void MX_USART3_UART_Init(void)
+{
+
+  huart3.Instance = USART3;
+  huart3.Init.BaudRate = 115200;
+  huart3.Init.WordLength = UART_WORDLENGTH_8B;
+  huart3.Init.StopBits = UART_STOPBITS_1;
+  huart3.Init.Parity = UART_PARITY_NONE;
+  huart3.Init.Mode = UART_MODE_TX_RX;
+  huart3.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart3.Init.OverSampling = UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&huart3) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+}
+
 /** 
   * Enable DMA controller clock
   */
@@ -425,40 +659,461 @@ static void MX_GPIO_Init(void)
 
 
 
-void uartdamget_left(void)
+/*	յһ֡: ÿڵͨ1һң¼,ڵݴӦ	*/
+void port_frame(uart_port_t *port, const zb_frame_t *frame)
 {
-	
-	if(recv_end_flag_left ==1)
+	uint32_t tick = HAL_GetTick();
+	float value;
+
+	if(frame->type == ZB_FRAME_KEY || frame->type == ZB_FRAME_DELTA || frame->type == ZB_FRAME_REPORT)
+	{
+		table_frame(frame);
+		return;
+	}
+	if(frame->type == ZB_FRAME_LINK)
+	{
+		link_frame(frame);
+		return;
+	}
+	for(uint16_t s=0;s<zb_frame_slots(frame);s++)
+		telemetry_send(&telem, tick, zb_frame_slot_addr(frame, s), zb_frame_slot_float(frame, s));
+
+	if(frame->type == ZB_FRAME_POSE)
 	{
-		
+		pose_frame(frame);
+		return;
+	}
+	if(port->value != NULL && zb_frame_find(frame, LOCAL_NODE_ID, &value))
+		*port->value = value;
+}
+
+/*	λ֡: ڵַҵ˲,֮֡ʱԤ	*/
+void pose_frame(const zb_frame_t *frame)
+{
+	uint16_t addr = zb_frame_slot_addr(frame, 0);
+	uint32_t now = micros();
+	float z[POSE_AXES];
+	int i;
+
+	for(i = 0; i < pose_nodes && pose_addr[i] != addr; i++)
+	{
+	}
+	if(i == pose_nodes)
+	{
+		if(pose_nodes == POSE_NODES)
+			return;
+		pose_addr[i] = addr;
+		pose_init(&pose_filt[i], POSE_Q_LIN, POSE_R_LIN, POSE_Q_ANG, POSE_R_ANG);
+		pose_nodes++;
+	}
+
+	zb_frame_pose(frame, z);
+	pose_update(&pose_filt[i], z, (now - pose_time[i]) * 1e-6f);
+	pose_time[i] = now;
+
+	if(addr == LOCAL_NODE_ID)
+		pose_get(&pose_filt[i], pose_filtered, pose_rate);
+}
+
+/*	pose: ӡڵ͸ڵ˲λ˺ͱ仯	*/
+void cmd_pose(int argc, char *argv[])
+{
+	float pose[POSE_AXES], rate[POSE_AXES];
+
+	for(int i = 0; i < pose_nodes; i++)
+	{
+		pose_get(&pose_filt[i], pose, rate);
+		printf("node 0x%04X updates %lu\r\n", pose_addr[i], (unsigned long)pose_filt[i].updates);
+		for(int a = 0; a < POSE_AXES; a++)
+			printf("  %g (%g/s)", (double)pose[a], (double)rate[a]);
+		printf("\r\n");
+	}
+	printf("local 0x%04X\r\n", LOCAL_NODE_ID);
+	for(int a = 0; a < POSE_AXES; a++)
+		printf("  %g (%g/s)", (double)pose_filtered[a], (double)pose_rate[a]);
+	printf("\r\n");
+}
+
+/*	ݱ֡/ϱ֡: ݱ,ÿĲһң¼,ڵֶΪۺ	*/
+void table_frame(const zb_frame_t *frame)
+{
+	uint32_t tick = HAL_GetTick();
+	uint16_t s;
+
+	slot_table_update(&node_table, frame);
+	for(uint16_t i = 0; i < zb_frame_slots(frame); i++)
+	{
+		s = zb_frame_slot_addr(frame, i);
+		if(s < SLOT_TABLE_SLOTS && node_table.slot[s].frame == node_table.frames)
+			telemetry_send(&telem, tick, s, node_table.slot[s].value[0]);
+	}
+}
+
+/*	tab: ӡݱ۵ֵ͹ؼ֡/֡	*/
+void cmd_tab(int argc, char *argv[])
+{
+	printf("frames %lu key %lu delta %lu report %lu stale %lu\r\n", (unsigned long)node_table.frames,
+	       (unsigned long)node_table.keyframes, (unsigned long)node_table.deltas,
+	       (unsigned long)node_table.reports, (unsigned long)node_table.stale);
+	for(int s = 0; s < SLOT_TABLE_SLOTS; s++)
+	{
+		if(node_table.slot[s].frame == 0)
+			continue;
+		printf("slot %2d key %3u", s, node_table.slot[s].id);
+		for(int j = 0; j < node_table.slot[s].m; j++)
+			printf("  %g", (double)node_table.slot[s].value[j]);
+		printf("\r\n");
+	}
+}
+
+/*	·ͳ֡: ߵַµļ	*/
+void link_frame(const zb_frame_t *frame)
+{
+	zb_frame_link_t link;
+	int i;
+
+	zb_frame_link(frame, &link);
+	for(i = 0; i < link_nodes && link_stats[i].addr != link.addr; i++)
+	{
+	}
+	if(i == link_nodes)
+	{
+		if(link_nodes == LINK_NODES)
+			return;
+		link_nodes++;
+	}
+	link_stats[i] = link;
+}
+
+/*	link: ӡߵ·	*/
+void cmd_link(int argc, char *argv[])
+{
+	for(int i = 0; i < link_nodes; i++)
+		printf("src 0x%04X rx %u lost %u dup %u late %u\r\n", link_stats[i].addr,
+		       link_stats[i].rx, link_stats[i].lost, link_stats[i].dup, link_stats[i].reorder);
+}
 
+/*	up: /رͨ,ʱӡ	*/
+void cmd_up(int argc, char *argv[])
+{
+	unsigned long ch;
 
-		for(int i=0;i<Rx_len_left;i++)
+	if(argc == 3)
+	{
+		if((ch = strtoul(argv[1], NULL, 0)) >= UPLINK_CH)
 		{
-			/*	ӡյ */
-				printf("%c",ReceiveBuff_left[i]);
+			printf("channel 0..%d\r\n", UPLINK_CH - 1);
+			return;
 		}
-		for(int i = 0; i < Rx_len_left ; i++) 
-			x1_data.position1_char[i]=ReceiveBuff_left[i];//ֵܵX1
-
-		/*	սջ	*/
-		for(int i = 0; i < Rx_len_left ; i++) 
-			ReceiveBuff_left[i]=0;
-		/*	ݳ	*/
-		Rx_len_left=0;
-		recv_end_flag_left=0;
+		if(strcmp(argv[2], "off") == 0)
+			uplink_mask &= ~(1u << ch);
+		else
+		{
+			uplink_value[ch] = strtof(argv[2], NULL);
+			uplink_mask |= 1u << ch;
+		}
+	}
+	for(int i = 0; i < UPLINK_CH; i++)
+	{
+		if(uplink_mask & (1u << i))
+			printf("ch %d %g\r\n", i, (double)uplink_value[i]);
 	}
-	/*	һν	*/
-	HAL_UART_Receive_DMA(&huart2,(uint8_t*)ReceiveBuff_left,BUFFERSIZE_left);
+}
+
+/*	DMA/ȫ: »λдλ	*/
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+	uart_port_rx_event(huart);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+	uart_port_rx_event(huart);
+}
+
+/*	OREȴʱHALֹDMA,ӻ¿ѭ	*/
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	uart_port_rx_error(huart);
+
+	if(huart->Instance == USART1 && huart->gState == HAL_UART_STATE_READY && log_ring_busy(&log_tx))
+	{
+		/*	DMA,һμ	*/
+		log_ring_done(&log_tx);
+		log_kick();
+	}
+}
+
+/*	ڽյ,ѭ	*/
+void uart_port_rx_callback(uart_port_t *port)
+{
+	event_post(EVENT(EV_UART_RX));
+}
+
+/*	ڵĶ˿DMA,ͨĽڵ֡,æһ	*/
+void request_send(void)
+{
+	uint32_t now = micros();
+	uint16_t len;
+
+	for(int i = 0; i < sizeof(port_poll) / sizeof(port_poll[0]); i++)
+	{
+		if(!poll_due(&port_poll[i], now))
+			continue;
+		memcpy(port_tx[i], aTxStartMessages, sizeof(aTxStartMessages));
+		len = sizeof(aTxStartMessages);
+		for(int ch = 0; ch < UPLINK_CH; ch++)
+		{
+			if(uplink_mask & (1u << ch))
+				len += zb_frame_put_node(&port_tx[i][len], ch, uplink_value[ch]);
+		}
+		if(HAL_UART_Transmit_DMA(uart_ports[i].huart, port_tx[i], len) != HAL_OK)
+			poll_abort(&port_poll[i]);
+	}
+}
+
+/*	ƽ̨ӿ: ж//ʱ	*/
+uint32_t sched_lock(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	return primask;
+}
+
+void sched_unlock(uint32_t primask)
+{
+	__set_PRIMASK(primask);
+}
+
+/*	ж״̬WFI: жܻں,жϺִ	*/
+void sched_idle(void)
+{
+	__WFI();
+}
+
+/*	΢ʱ׼: TIM2ֵΪ16λ,Ϊ16λ	*/
+uint32_t micros(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t hi, lo;
+
+	__disable_irq();
+	hi = us_overflows;
+	lo = __HAL_TIM_GET_COUNTER(&htim2);
+	/*	жϻδִ	*/
+	if(__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) && lo < 0x8000)
+		hi++;
+	__set_PRIMASK(primask);
+	return (hi << 16) | lo;
+}
+
+/*	߿: Ӧ,¼ʱ	*/
+void uart_port_idle_callback(uart_port_t *port)
+{
+	latency_stop(&port_latency[port - uart_ports], micros());
+	poll_answer(&port_poll[port - uart_ports]);
+}
+
+void console_rx(uart_port_t *port)
+{
+	console_input(&port->ring);
+}
+
+/*	lat: ӡ˿-Ӧʱ; lat reset: 	*/
+void cmd_lat(int argc, char *argv[])
+{
+	latency_t *l;
+
+	for(int i = 0; i < sizeof(port_latency) / sizeof(port_latency[0]); i++)
+	{
+		l = &port_latency[i];
+		if(argc > 1 && strcmp(argv[1], "reset") == 0)
+		{
+			__disable_irq();
+			latency_init(l);
+			__enable_irq();
+			continue;
+		}
+		if(l->count == 0 && l->missed == 0)
+			continue;
+		printf("port %d n %lu missed %lu min %lu avg %lu p50 %lu p90 %lu p99 %lu max %lu\r\n", i,
+			(unsigned long)l->count, (unsigned long)l->missed, (unsigned long)(l->count ? l->min : 0),
+			(unsigned long)latency_avg(l), (unsigned long)latency_percentile(l, 50),
+			(unsigned long)latency_percentile(l, 90), (unsigned long)latency_percentile(l, 99),
+			(unsigned long)l->max);
+	}
+}
+
+/*	rate: ӡ˿ںͳʱ˱; rate <˿> <Hz> [λus]: ޸	*/
+void cmd_rate(int argc, char *argv[])
+{
+	poll_chan_t *c;
+	unsigned long port, hz;
+
+	if(argc >= 3)
+	{
+		port = strtoul(argv[1], NULL, 0);
+		hz = strtoul(argv[2], NULL, 0);
+		if(port >= sizeof(port_poll) / sizeof(port_poll[0]) || uart_ports[port].on_rx != NULL || hz > 1000)
+		{
+			printf("bad port or rate\r\n");
+			return;
+		}
+		__disable_irq();
+		poll_set(&port_poll[port], hz ? 1000000 / hz : 0, argc > 3 ? strtoul(argv[3], NULL, 0) : 0, micros());
+		__enable_irq();
+	}
+	for(int i = 0; i < sizeof(port_poll) / sizeof(port_poll[0]); i++)
+	{
+		c = &port_poll[i];
+		if(c->period == 0)
+			continue;
+		printf("port %d period %lu phase %lu interval %lu sent %lu answered %lu timeouts %lu busy %lu\r\n", i,
+			(unsigned long)c->period, (unsigned long)c->phase, (unsigned long)c->interval, (unsigned long)c->sent,
+			(unsigned long)c->answered, (unsigned long)c->timeouts, (unsigned long)c->busy);
+	}
+}
+
+/*	趨ֵ -> PID -> ޷/ -> CCR,ȽֵԤװ,һPWMЧ	*/
+void pwm_update(void)
+{
+	uint32_t start = micros();
+	float out;
+
+	for(int i = 0; i < PWM_CHANNELS; i++)
+	{
+		if(pwm_setpoint[i] != NULL && pwm_measure[i] != NULL)
+			out = control_step(&pwm_ctl[i], *pwm_setpoint[i], *pwm_measure[i]);
+		else
+			out = control_hold(&pwm_ctl[i]);
+		__HAL_TIM_SET_COMPARE(&htim3, pwm_channel[i], (uint32_t)(out + 0.5f));
+	}
+	control_stats_add(&pwm_stats, start, micros());
+}
+
+/*	ctl: ӡPWMͿ/ִʱ; ctl reset: ͳ	*/
+void cmd_ctl(int argc, char *argv[])
+{
+	control_stats_t s;
+
+	if(argc > 1 && strcmp(argv[1], "reset") == 0)
+	{
+		__disable_irq();
+		control_stats_init(&pwm_stats);
+		__enable_irq();
+		return;
+	}
+	for(int i = 0; i < PWM_CHANNELS; i++)
+		printf("ch %d out %d kp %g ki %g kd %g\r\n", i + 1, (int)(pwm_ctl[i].out + 0.5f),
+			(double)pwm_ctl[i].pid.Kp, (double)pwm_ctl[i].pid.Ki, (double)pwm_ctl[i].pid.Kd);
+
+	__disable_irq();
+	s = pwm_stats;
+	__enable_irq();
+	if(s.steps > 1)
+		printf("steps %lu period min %lu max %lu exec min %lu avg %lu max %lu\r\n", (unsigned long)s.steps,
+			(unsigned long)s.period_min, (unsigned long)s.period_max, (unsigned long)s.exec_min,
+			(unsigned long)(s.exec_sum / s.steps), (unsigned long)s.exec_max);
+}
+
+/*	pid <ͨ1-4> <kp> <ki> <kd>	*/
+void cmd_pid(int argc, char *argv[])
+{
+	unsigned long ch;
+
+	if(argc != 5 || (ch = strtoul(argv[1], NULL, 0)) < 1 || ch > PWM_CHANNELS)
+	{
+		printf("usage: pid ch kp ki kd\r\n");
+		return;
+	}
+	__disable_irq();
+	control_gains(&pwm_ctl[ch - 1], strtof(argv[2], NULL), strtof(argv[3], NULL), strtof(argv[4], NULL));
+	__enable_irq();
+}
+
+/*	1 DMA,ͻʣ	*/
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	uart_port_t *port;
+
+	if(huart->Instance == USART1)
+	{
+		log_ring_done(&log_tx);
+		log_kick();
+	}
+	else if((port = uart_port_find(huart)) != NULL)
+	{
+		/*	,ʼʱ	*/
+		latency_start(&port_latency[port - uart_ports], micros());
+	}
+}
+
+/*	ң¼д봮1ͻ	*/
+void telemetry_out(const uint8_t *data, uint16_t len)
+{
+	log_ring_write(&log_tx, data, len);
+	log_kick();
+}
+
+/*	DMAʱѷͻһݽDMA	*/
+void log_kick(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t *data;
+	uint16_t len;
+
+	__disable_irq();
+	if((len = log_ring_claim(&log_tx, &data)) != 0)
+	{
+		if(HAL_UART_Transmit_DMA(&huart1, data, len) != HAL_OK)
+		{
+			log_tx.dropped += len;
+			log_ring_done(&log_tx);
+		}
+	}
+	__set_PRIMASK(primask);
+}
+
+/*	·ʹ: ж,ѯ껺еȫ	*/
+void log_flush(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t *data;
+	uint16_t len;
+
+	__disable_irq();
+	if(log_ring_busy(&log_tx))
+	{
+		while((hdma_usart1_tx.Instance->CCR & DMA_CCR_EN) && __HAL_DMA_GET_COUNTER(&hdma_usart1_tx) != 0)
+		{
+		}
+		HAL_UART_AbortTransmit(&huart1);
+		log_ring_done(&log_tx);
+	}
+	while((len = log_ring_claim(&log_tx, &data)) != 0)
+	{
+		HAL_UART_Transmit(&huart1, data, len, 0xFFFF);
+		log_ring_done(&log_tx);
+	}
+	__set_PRIMASK(primask);
 }
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 
 {
 
-    if (htim->Instance == htim1.Instance)//
+    if (htim->Instance == htim2.Instance)
+    {
+			us_overflows++;
+    }
+    else if (htim->Instance == htim3.Instance)//PWMڿʼ,һڵıȽֵ
+    {
+			pwm_update();
+    }
+    else if (htim->Instance == htim1.Instance)//
     {      
-			HAL_UART_Transmit_IT(&huart2 ,(uint8_t*)aTxStartMessages,sizeof(aTxStartMessages));
+			event_post(EVENT(EV_REQUEST));
     }
 	  
 }
@@ -475,6 +1130,7 @@ void _Error_Handler(char *file, int line)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
+  log_flush();
   while(1)
   {
   }
@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file           : poll.c
+  * @brief          : Per-channel request scheduler with adaptive backoff
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "poll.h"
+
+/* Exported functions --------------------------------------------------------*/
+
+void poll_set(poll_chan_t *c, uint32_t period, uint32_t phase, uint32_t now)
+{
+  memset(c, 0, sizeof(*c));
+  if(period == 0)
+    return;
+  if(period < POLL_PERIOD_MIN)
+    period = POLL_PERIOD_MIN;
+  c->period   = period;
+  c->phase    = phase % period;
+  c->interval = period;
+  /* First slot at or after now that lies on phase + k * period. */
+  c->next     = now + (uint32_t)(c->phase - now % period + period) % period;
+}
+
+int poll_due(poll_chan_t *c, uint32_t now)
+{
+  if(c->period == 0 || (int32_t)(now - c->next) < 0)
+    return 0;
+
+  if(c->waiting)
+  {
+    c->timeouts++;
+    if(c->backoff < POLL_BACKOFF_MAX)
+      c->backoff++;
+  }
+  c->interval = c->period << c->backoff;
+
+  /* Stay on the phase grid; skip slots that were missed entirely. */
+  c->next += c->interval;
+  if((int32_t)(now - c->next) >= 0)
+    c->next = now + c->interval - (now - c->next) % c->interval;
+
+  c->waiting = 1;
+  c->sent++;
+  return 1;
+}
+
+void poll_abort(poll_chan_t *c)
+{
+  c->waiting = 0;
+  c->sent--;
+  c->busy++;
+}
+
+void poll_answer(poll_chan_t *c)
+{
+  if(!c->waiting)
+    return;
+  c->waiting = 0;
+  c->answered++;
+  if(c->backoff > 0)
+    c->backoff--;
+}
@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * @file           : pose.c
+  * @brief          : Kalman filter for the 6-DOF node pose
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+
+#include "pose.h"
+
+/* Private define ------------------------------------------------------------*/
+#define P_INIT        1.0e3f      /* covariance after the first measurement */
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Angle in (-pi, pi]. */
+static float32_t pose_wrap(float32_t a)
+{
+  if(a > PI || a <= -PI)
+  {
+    a = fmodf(a + PI, 2.0f * PI);
+    if(a <= 0.0f)
+      a += 2.0f * PI;
+    a -= PI;
+  }
+  return a;
+}
+
+static void pose_group_init(pose_group_t *g, float32_t q, float32_t r, uint8_t wrap)
+{
+  memset(g, 0, sizeof(*g));
+  g->q    = q;
+  g->r    = r;
+  g->wrap = wrap;
+  arm_mat_init_f32(&g->X, 2, POSE_GROUP_AXES, g->x);
+  arm_mat_init_f32(&g->P, 2, 2, g->p);
+}
+
+static void pose_group_reset(pose_group_t *g, const float32_t *z)
+{
+  uint8_t i;
+
+  for(i = 0; i < POSE_GROUP_AXES; i++)
+  {
+    g->x[i]                   = g->wrap ? pose_wrap(z[i]) : z[i];
+    g->x[POSE_GROUP_AXES + i] = 0.0f;
+  }
+  g->p[0] = g->r;
+  g->p[1] = 0.0f;
+  g->p[2] = 0.0f;
+  g->p[3] = P_INIT;
+}
+
+static void pose_group_update(pose_group_t *g, const float32_t *z, float32_t dt)
+{
+  float32_t f[4]  = { 1.0f, dt, 0.0f, 1.0f };
+  float32_t ft[4], fp[4], fpft[4], q[4], xp[2 * POSE_GROUP_AXES];
+  float32_t k[2], y[POSE_GROUP_AXES], ky[2 * POSE_GROUP_AXES];
+  float32_t dt2 = dt * dt, s, p00, p01;
+  arm_matrix_instance_f32 F, Ft, FP, FPFt, Q, XP, K, Y, KY;
+  uint8_t i;
+
+  arm_mat_init_f32(&F, 2, 2, f);
+  arm_mat_init_f32(&Ft, 2, 2, ft);
+  arm_mat_init_f32(&FP, 2, 2, fp);
+  arm_mat_init_f32(&FPFt, 2, 2, fpft);
+  arm_mat_init_f32(&Q, 2, 2, q);
+  arm_mat_init_f32(&XP, 2, POSE_GROUP_AXES, xp);
+  arm_mat_init_f32(&K, 2, 1, k);
+  arm_mat_init_f32(&Y, 1, POSE_GROUP_AXES, y);
+  arm_mat_init_f32(&KY, 2, POSE_GROUP_AXES, ky);
+
+  /* Predict. Q is the discrete white acceleration model. */
+  arm_mat_mult_f32(&F, &g->X, &XP);
+  arm_mat_trans_f32(&F, &Ft);
+  arm_mat_mult_f32(&F, &g->P, &FP);
+  arm_mat_mult_f32(&FP, &Ft, &FPFt);
+  q[0] = g->q * dt2 * dt2 * 0.25f;
+  q[1] = g->q * dt2 * dt * 0.5f;
+  q[2] = q[1];
+  q[3] = g->q * dt2;
+  arm_mat_add_f32(&FPFt, &Q, &g->P);
+
+  /* Update: every axis measures its position only. */
+  s    = g->p[0] + g->r;
+  k[0] = g->p[0] / s;
+  k[1] = g->p[2] / s;
+  for(i = 0; i < POSE_GROUP_AXES; i++)
+    y[i] = g->wrap ? pose_wrap(z[i] - xp[i]) : z[i] - xp[i];
+  arm_mat_mult_f32(&K, &Y, &KY);
+  arm_mat_add_f32(&XP, &KY, &g->X);
+  if(g->wrap)
+    for(i = 0; i < POSE_GROUP_AXES; i++)
+      g->x[i] = pose_wrap(g->x[i]);
+
+  p00 = g->p[0];
+  p01 = g->p[1];
+  g->p[0] -= k[0] * p00;
+  g->p[1] -= k[0] * p01;
+  g->p[2] -= k[1] * p00;
+  g->p[3] -= k[1] * p01;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void pose_init(pose_filter_t *f, float32_t q_lin, float32_t r_lin,
+               float32_t q_ang, float32_t r_ang)
+{
+  pose_group_init(&f->lin, q_lin, r_lin, 0);
+  pose_group_init(&f->ang, q_ang, r_ang, 1);
+  f->valid   = 0;
+  f->updates = 0;
+}
+
+void pose_update(pose_filter_t *f, const float32_t z[POSE_AXES], float32_t dt)
+{
+  if(!f->valid)
+  {
+    pose_group_reset(&f->lin, &z[0]);
+    pose_group_reset(&f->ang, &z[POSE_GROUP_AXES]);
+    f->valid = 1;
+  }
+  else if(dt > 0.0f)
+  {
+    pose_group_update(&f->lin, &z[0], dt);
+    pose_group_update(&f->ang, &z[POSE_GROUP_AXES], dt);
+  }
+  f->updates++;
+}
+
+void pose_get(const pose_filter_t *f, float32_t pose[POSE_AXES], float32_t rate[POSE_AXES])
+{
+  uint8_t i;
+
+  for(i = 0; i < POSE_GROUP_AXES; i++)
+  {
+    pose[i]                   = f->lin.x[i];
+    rate[i]                   = f->lin.x[POSE_GROUP_AXES + i];
+    pose[POSE_GROUP_AXES + i] = f->ang.x[i];
+    rate[POSE_GROUP_AXES + i] = f->ang.x[POSE_GROUP_AXES + i];
+  }
+}
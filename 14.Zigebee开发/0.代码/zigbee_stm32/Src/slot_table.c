@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file           : slot_table.c
+  * @brief          : Node table rebuilt from slot-table key and delta frames
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+
+#include "slot_table.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t report_update(slot_table_t *t, const zb_frame_t *f)
+{
+  uint16_t count = zb_frame_byte(f, 2);
+  uint16_t m     = zb_frame_byte(f, 3);
+  uint16_t keep  = m < SLOT_TABLE_M ? m : SLOT_TABLE_M;
+  uint16_t done  = 0;
+  uint16_t s, j;
+  uint32_t off, end;
+  slot_entry_t *e;
+
+  if(f->length < ZB_FRAME_REPORT_HDR + 2)
+    return 0;
+  /* Entries end before the checksum; those past it are not decoded. */
+  end = f->length - 2;
+  t->frames++;
+  t->reports++;
+  for(s = 0, off = ZB_FRAME_REPORT_HDR; s < count; s++, off += 1 + m * 4)
+  {
+    if(off + 1 + m * 4 > end)
+      break;
+    if(zb_frame_byte(f, (uint16_t)off) >= SLOT_TABLE_SLOTS)
+      continue;
+    e = &t->slot[zb_frame_byte(f, (uint16_t)off)];
+    for(j = 0; j < keep; j++)
+      e->value[j] = zb_frame_float(f, (uint16_t)(off + 1 + j * 4));
+    e->m     = (uint8_t)keep;
+    e->frame = t->frames;
+    done++;
+  }
+  return done;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void slot_table_init(slot_table_t *t)
+{
+  memset(t, 0, sizeof(*t));
+}
+
+uint16_t slot_table_update(slot_table_t *t, const zb_frame_t *f)
+{
+  uint8_t  id    = zb_frame_byte(f, 2);
+  uint16_t first = zb_frame_byte(f, 3);
+  uint16_t count = zb_frame_byte(f, 4);
+  uint16_t m     = zb_frame_byte(f, 5);
+  uint16_t keep  = m < SLOT_TABLE_M ? m : SLOT_TABLE_M;
+  uint16_t done  = 0;
+  uint16_t s, j;
+  uint32_t off, end;
+  float    q[SLOT_TABLE_M];
+  slot_entry_t *e;
+
+  if(f->type == ZB_FRAME_REPORT)
+    return report_update(t, f);
+  if(f->type != ZB_FRAME_KEY && f->type != ZB_FRAME_DELTA)
+    return 0;
+  if(f->length < ZB_FRAME_TAB_HDR + 2)
+    return 0;
+  /* Values end before the checksum; slots past it are not decoded. */
+  end = f->length - 2;
+  t->frames++;
+
+  if(f->type == ZB_FRAME_KEY)
+  {
+    t->keyframes++;
+    for(s = 0; s < count && first + s < SLOT_TABLE_SLOTS; s++)
+    {
+      off = ZB_FRAME_TAB_HDR + (uint32_t)s * m * 4;
+      if(off + m * 4 > end)
+        break;
+      e = &t->slot[first + s];
+      for(j = 0; j < keep; j++)
+        e->key[j] = e->value[j] = zb_frame_float(f, (uint16_t)(off + j * 4));
+      e->id    = id;
+      e->valid = 1;
+      e->m     = (uint8_t)keep;
+      e->frame = t->frames;
+      done++;
+    }
+    return done;
+  }
+
+  t->deltas++;
+  if(ZB_FRAME_TAB_HDR + (uint32_t)m > end)
+    return 0;
+  for(j = 0; j < keep; j++)
+    q[j] = ldexpf(1.0f, (int8_t)zb_frame_byte(f, ZB_FRAME_TAB_HDR + j));
+
+  for(s = 0; s < count && first + s < SLOT_TABLE_SLOTS; s++)
+  {
+    off = ZB_FRAME_TAB_HDR + m + (uint32_t)s * m * 2;
+    if(off + m * 2 > end)
+      break;
+    e = &t->slot[first + s];
+    if(!e->valid || e->id != id)
+    {
+      t->stale++;
+      continue;
+    }
+    for(j = 0; j < keep; j++)
+    {
+      int16_t d = (int16_t)(zb_frame_byte(f, (uint16_t)(off + j * 2)) |
+                            (zb_frame_byte(f, (uint16_t)(off + j * 2 + 1)) << 8));
+
+      e->value[j] = e->key[j] + d * q[j];
+    }
+    e->frame = t->frames;
+    done++;
+  }
+  return done;
+}
@@ -0,0 +1,160 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.c
+  * @brief          : Telemetry records for the USART1 log channel
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void telemetry_init(telemetry_t *t, uint8_t mode, telemetry_write_t write)
+{
+  t->mode  = mode;
+  t->seq   = 0;
+  t->write = write;
+}
+
+void telemetry_send(telemetry_t *t, uint32_t tick, uint16_t node, float value)
+{
+  telemetry_record_t rec;
+  uint8_t raw[TELEMETRY_RECORD_LEN];
+  uint8_t out[48];                  /* >= TELEMETRY_FRAME_MAX and one text line */
+  uint16_t len;
+  int n;
+
+  rec.seq   = t->seq++;
+  rec.tick  = tick;
+  rec.node  = node;
+  rec.value = value;
+
+  if(t->mode == TELEMETRY_TEXT)
+  {
+    n = snprintf((char *)out, sizeof(out), "%u %lu %u %g\r\n",
+                 rec.seq, (unsigned long)rec.tick, rec.node, (double)rec.value);
+    if(n < 0)
+      return;
+    len = (uint16_t)n < sizeof(out) ? (uint16_t)n : sizeof(out) - 1;
+  }
+  else
+  {
+    telemetry_pack(&rec, raw);
+    len = cobs_encode(raw, sizeof(raw), out);
+    out[len++] = 0x00;
+  }
+  t->write(out, len);
+}
+
+void telemetry_pack(const telemetry_record_t *rec, uint8_t *buf)
+{
+  uint8_t x = 0;
+  uint8_t i;
+
+  buf[0] = TELEMETRY_VERSION;
+  put_le16(&buf[1], rec->seq);
+  put_le32(&buf[3], rec->tick);
+  put_le16(&buf[7], rec->node);
+  memcpy(&buf[9], &rec->value, 4);
+  for(i = 0; i < TELEMETRY_RECORD_LEN - 1; i++)
+    x ^= buf[i];
+  buf[TELEMETRY_RECORD_LEN - 1] = x;
+}
+
+/* Returns 1 if buf holds a valid record. */
+int telemetry_unpack(const uint8_t *buf, uint16_t len, telemetry_record_t *rec)
+{
+  uint8_t x = 0;
+  uint8_t i;
+
+  if(len != TELEMETRY_RECORD_LEN || buf[0] != TELEMETRY_VERSION)
+    return 0;
+  for(i = 0; i < TELEMETRY_RECORD_LEN; i++)
+    x ^= buf[i];
+  if(x != 0)
+    return 0;
+
+  rec->seq  = get_le16(&buf[1]);
+  rec->tick = get_le32(&buf[3]);
+  rec->node = get_le16(&buf[7]);
+  memcpy(&rec->value, &buf[9], 4);
+  return 1;
+}
+
+/* Consistent Overhead Byte Stuffing: removes every 0x00 from src so 0x00
+   can delimit frames. dst needs len + len / 254 + 1 bytes. */
+uint16_t cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+  uint16_t code_at = 0;
+  uint16_t out     = 1;
+  uint8_t  code    = 1;
+  uint16_t i;
+
+  for(i = 0; i < len; i++)
+  {
+    if(src[i] != 0)
+    {
+      dst[out++] = src[i];
+      code++;
+    }
+    if(src[i] == 0 || code == 0xFF)
+    {
+      dst[code_at] = code;
+      code_at = out++;
+      code = 1;
+    }
+  }
+  dst[code_at] = code;
+  return out;
+}
+
+/* Returns the decoded length, or 0 if src is not valid COBS. */
+uint16_t cobs_decode(const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+  uint16_t in  = 0;
+  uint16_t out = 0;
+  uint8_t  code;
+  uint8_t  i;
+
+  while(in < len)
+  {
+    code = src[in++];
+    if(code == 0 || in + code - 1 > len)
+      return 0;
+    for(i = 1; i < code; i++)
+      dst[out++] = src[in++];
+    if(code != 0xFF && in < len)
+      dst[out++] = 0;
+  }
+  return out;
+}
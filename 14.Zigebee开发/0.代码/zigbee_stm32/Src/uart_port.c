@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file           : uart_port.c
+  * @brief          : Table driven receive ports (circular DMA + frame decoder)
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "uart_port.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uart_port_t *port_table;
+static uint8_t      port_count;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void uart_port_dma_start(uart_port_t *port)
+{
+  HAL_UART_Receive_DMA(port->huart, port->rx_buf, port->rx_size);
+}
+
+static void uart_port_rx_update(uart_port_t *port)
+{
+  uart_ring_dma_update(&port->ring, __HAL_DMA_GET_COUNTER(port->huart->hdmarx));
+  port->rx_event = 1;
+  uart_port_rx_callback(port);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void uart_port_start(uart_port_t *ports, uint8_t count)
+{
+  uart_port_t *port;
+  uint8_t i;
+
+  port_table = ports;
+  port_count = count;
+
+  for(i = 0; i < count; i++)
+  {
+    port = &ports[i];
+    uart_ring_init(&port->ring, port->rx_buf, port->rx_size);
+    port->rx_event = 0;
+    __HAL_UART_ENABLE_IT(port->huart, UART_IT_IDLE);
+    uart_port_dma_start(port);
+  }
+}
+
+uart_port_t *uart_port_find(UART_HandleTypeDef *huart)
+{
+  uint8_t i;
+
+  for(i = 0; i < port_count; i++)
+  {
+    if(port_table[i].huart == huart)
+      return &port_table[i];
+  }
+  return NULL;
+}
+
+__weak void uart_port_rx_callback(uart_port_t *port)
+{
+  UNUSED(port);
+}
+
+__weak void uart_port_idle_callback(uart_port_t *port)
+{
+  UNUSED(port);
+}
+
+/* Call from USARTx_IRQHandler after HAL_UART_IRQHandler(). */
+void uart_port_irq(UART_HandleTypeDef *huart)
+{
+  uart_port_t *port;
+
+  if(__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE) == RESET)
+    return;
+  __HAL_UART_CLEAR_IDLEFLAG(huart);
+
+  port = uart_port_find(huart);
+  if(port != NULL)
+  {
+    uart_port_idle_callback(port);
+    uart_port_rx_update(port);
+  }
+}
+
+/* DMA half-transfer and transfer-complete callbacks. */
+void uart_port_rx_event(UART_HandleTypeDef *huart)
+{
+  uart_port_t *port = uart_port_find(huart);
+
+  if(port != NULL)
+    uart_port_rx_update(port);
+}
+
+/* Overrun and friends abort the RX DMA inside the HAL: start it again. */
+void uart_port_rx_error(UART_HandleTypeDef *huart)
+{
+  uart_port_t *port = uart_port_find(huart);
+
+  if(port != NULL && huart->RxState == HAL_UART_STATE_READY)
+  {
+    uart_ring_dma_restart(&port->ring);
+    uart_port_dma_start(port);
+  }
+}
+
+void uart_port_poll(void)
+{
+  uart_port_t *port;
+  zb_frame_t frame;
+  uint8_t i;
+
+  for(i = 0; i < port_count; i++)
+  {
+    port = &port_table[i];
+    if(!port->rx_event)
+      continue;
+    port->rx_event = 0;
+
+    if(port->on_rx != NULL)
+    {
+      port->on_rx(port);
+      continue;
+    }
+    while(zb_frame_next(&port->ring, &frame, &port->stats))
+    {
+      if(port->on_frame != NULL)
+        port->on_frame(port, &frame);
+      zb_frame_release(&port->ring, &frame);
+    }
+  }
+}
@@ -0,0 +1,112 @@
+/**
+  ******************************************************************************
+  * @file           : uart_ring.c
+  * @brief          : Circular-DMA receive ring (single producer, single consumer)
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "uart_ring.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Bytes waiting for the consumer. Resolves DMA restarts and overruns by
+   dropping whatever the DMA may already have overwritten. */
+static uint32_t uart_ring_level(uart_ring_t *r)
+{
+  uint32_t used;
+
+  if(r->restarts_seen != r->restarts)
+  {
+    r->restarts_seen = r->restarts;
+    r->tail = r->restart_head;
+  }
+
+  used = r->head - r->tail;
+  if(used > r->size)
+  {
+    r->overruns++;
+    r->tail = r->head;
+    used = 0;
+  }
+  return used;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void uart_ring_init(uart_ring_t *r, uint8_t *buf, uint16_t size)
+{
+  r->buf           = buf;
+  r->size          = size;
+  r->dma_pos       = 0;
+  r->head          = 0;
+  r->tail          = 0;
+  r->restart_head  = 0;
+  r->restarts      = 0;
+  r->restarts_seen = 0;
+  r->overruns      = 0;
+}
+
+void uart_ring_dma_update(uart_ring_t *r, uint16_t ndtr)
+{
+  uint16_t pos = (uint16_t)(r->size - ndtr) & (r->size - 1);
+
+  r->head += (uint16_t)(pos - r->dma_pos) & (r->size - 1);
+  r->dma_pos = pos;
+}
+
+void uart_ring_dma_restart(uart_ring_t *r)
+{
+  /* Realign head with offset 0 of the buffer where the DMA starts again. */
+  uint32_t head = (r->head + r->size - 1) & ~(uint32_t)(r->size - 1);
+
+  r->dma_pos = 0;
+  r->head = head;
+  r->restart_head = head;
+  r->restarts++;
+}
+
+uint16_t uart_ring_count(uart_ring_t *r)
+{
+  return (uint16_t)uart_ring_level(r);
+}
+
+/* Returns the length of the contiguous block at the read position. */
+uint16_t uart_ring_peek(uart_ring_t *r, uint8_t **data)
+{
+  uint32_t used = uart_ring_level(r);
+  uint16_t off  = (uint16_t)r->tail & (r->size - 1);
+  uint16_t len  = r->size - off;
+
+  if(used < len)
+    len = (uint16_t)used;
+  *data = &r->buf[off];
+  return len;
+}
+
+void uart_ring_skip(uart_ring_t *r, uint16_t len)
+{
+  uint32_t used = uart_ring_level(r);
+
+  if(len > used)
+    len = (uint16_t)used;
+  r->tail += len;
+}
+
+uint16_t uart_ring_read(uart_ring_t *r, uint8_t *dst, uint16_t len)
+{
+  uint16_t done = 0;
+  uint16_t n;
+  uint8_t *p;
+
+  while(done < len && (n = uart_ring_peek(r, &p)) != 0)
+  {
+    if(n > len - done)
+      n = len - done;
+    memcpy(&dst[done], p, n);
+    uart_ring_skip(r, n);
+    done += n;
+  }
+  return done;
+}
@@ -0,0 +1,320 @@
+/**
+  ******************************************************************************
+  * @file           : zb_frame.c
+  * @brief          : Streaming decoder for the 0x3A ... 0x23 ZigBee frames
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "zb_frame.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint8_t ring_at(const uart_ring_t *r, uint16_t i)
+{
+  return r->buf[(uint16_t)(r->tail + i) & (r->size - 1)];
+}
+
+static uint8_t ring_xor(const uart_ring_t *r, uint16_t off, uint16_t len)
+{
+  uint8_t x = 0;
+
+  while(len--)
+    x ^= ring_at(r, off++);
+  return x;
+}
+
+static int is_sof(uint8_t b)
+{
+  return b == ZB_FRAME_SOF || b == ZB_FRAME_POSE_SOF ||
+         b == ZB_FRAME_KEY_SOF || b == ZB_FRAME_DELTA_SOF ||
+         b == ZB_FRAME_LINK_SOF || b == ZB_FRAME_REPORT_SOF;
+}
+
+static uint8_t *find_sof(uint8_t *p, uint16_t n)
+{
+  while(n--)
+  {
+    if(is_sof(*p))
+      return p;
+    p++;
+  }
+  return NULL;
+}
+
+/* Length of the slot-table or report frame at the read position, from its
+   header; 0 if the header cannot be right. The header can claim up to
+   255 x 255 values, so the length is worked out in 32 bits and checked
+   before it is narrowed. */
+static uint16_t tab_len(const uart_ring_t *r)
+{
+  uint8_t  sof   = ring_at(r, 0);
+  uint32_t m     = ring_at(r, sof == ZB_FRAME_REPORT_SOF ? 3 : 5);
+  uint32_t delta = sof == ZB_FRAME_DELTA_SOF;
+  uint32_t len;
+
+  if(m == 0)
+    return 0;
+  if(sof == ZB_FRAME_REPORT_SOF)
+    len = ZB_FRAME_REPORT_HDR + ring_at(r, 2) * (1 + m * 4) + 2;
+  else
+    len = ZB_FRAME_TAB_HDR + (delta ? m : 0) + ring_at(r, 4) * m * (delta ? 2 : 4) + 2;
+  return len <= ZB_FRAME_TAB_MAX && len <= r->size ? (uint16_t)len : 0;
+}
+
+static uint8_t tab_type(uint8_t sof)
+{
+  switch(sof)
+  {
+  case ZB_FRAME_KEY_SOF:
+    return ZB_FRAME_KEY;
+  case ZB_FRAME_DELTA_SOF:
+    return ZB_FRAME_DELTA;
+  default:
+    return ZB_FRAME_REPORT;
+  }
+}
+
+/* Offset within the frame, or f->length, which reads as 0, if past it. */
+static uint16_t bound_off(const zb_frame_t *f, uint32_t off)
+{
+  return off < f->length ? (uint16_t)off : f->length;
+}
+
+/* Offset of slot in a report frame. */
+static uint16_t report_off(const zb_frame_t *f, uint16_t slot)
+{
+  return bound_off(f, ZB_FRAME_REPORT_HDR + (uint32_t)slot * (1 + zb_frame_byte(f, 3) * 4));
+}
+
+static uint16_t view_u16(const zb_frame_t *f, uint16_t off)
+{
+  return (uint16_t)((zb_frame_byte(f, off) << 8) | zb_frame_byte(f, off + 1));
+}
+
+static void frame_view(const uart_ring_t *r, zb_frame_t *f, uint16_t len, uint8_t type)
+{
+  uint16_t off   = (uint16_t)r->tail & (r->size - 1);
+  uint16_t first = r->size - off;
+
+  if(first > len)
+    first = len;
+  f->seg[0]     = &r->buf[off];
+  f->seg_len[0] = first;
+  f->seg[1]     = r->buf;
+  f->seg_len[1] = len - first;
+  f->length     = len;
+  f->type       = type;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int zb_frame_next(uart_ring_t *r, zb_frame_t *f, zb_frame_stats_t *st)
+{
+  uint8_t *p, *sof;
+  uint16_t n, skip, avail, len;
+  int node_eof;
+
+  for(;;)
+  {
+    /* Drop everything in front of the next start byte. */
+    while((n = uart_ring_peek(r, &p)) != 0 && !is_sof(*p))
+    {
+      sof  = find_sof(p, n);
+      skip = sof ? (uint16_t)(sof - p) : n;
+      uart_ring_skip(r, skip);
+      st->skipped += skip;
+    }
+
+    avail = uart_ring_count(r);
+    if(n != 0 && (*p == ZB_FRAME_KEY_SOF || *p == ZB_FRAME_DELTA_SOF ||
+                  *p == ZB_FRAME_REPORT_SOF))
+    {
+      if(avail < ZB_FRAME_TAB_HDR)
+        return 0;
+      len = tab_len(r);
+      if(len != 0)
+      {
+        if(avail < len)
+          return 0;
+        if(ring_at(r, len - 1) == ZB_FRAME_EOF &&
+           ring_xor(r, 1, len - 3) == ring_at(r, len - 2))
+        {
+          frame_view(r, f, len, tab_type(*p));
+          st->frames++;
+          return 1;
+        }
+      }
+      st->bad_checksum++;
+      uart_ring_skip(r, 1);
+      st->skipped++;
+      continue;
+    }
+
+    if(n != 0 && (*p == ZB_FRAME_POSE_SOF || *p == ZB_FRAME_LINK_SOF))
+    {
+      len = *p == ZB_FRAME_POSE_SOF ? ZB_FRAME_POSE_LEN : ZB_FRAME_LINK_LEN;
+      if(avail < len)
+        return 0;
+      if(ring_at(r, len - 1) == ZB_FRAME_EOF &&
+         ring_xor(r, 1, len - 3) == ring_at(r, len - 2))
+      {
+        frame_view(r, f, len, *p == ZB_FRAME_POSE_SOF ? ZB_FRAME_POSE : ZB_FRAME_LINK);
+        st->frames++;
+        return 1;
+      }
+      st->bad_checksum++;
+      uart_ring_skip(r, 1);
+      st->skipped++;
+      continue;
+    }
+
+    if(avail < ZB_FRAME_NODE_LEN)
+      return 0;
+
+    node_eof = ring_at(r, ZB_FRAME_NODE_LEN - 1) == ZB_FRAME_EOF;
+    if(node_eof &&
+       ring_xor(r, 1, ZB_FRAME_SLOT_LEN) == ring_at(r, ZB_FRAME_NODE_LEN - 2))
+    {
+      frame_view(r, f, ZB_FRAME_NODE_LEN, ZB_FRAME_NODE);
+      st->frames++;
+      return 1;
+    }
+
+    /* Could still be the start of a table frame. */
+    if(avail < ZB_FRAME_TABLE_LEN)
+      return 0;
+
+    if(ring_at(r, ZB_FRAME_TABLE_LEN - 1) == ZB_FRAME_EOF)
+    {
+      frame_view(r, f, ZB_FRAME_TABLE_LEN, ZB_FRAME_TABLE);
+      st->frames++;
+      return 1;
+    }
+
+    /* Not a frame: resynchronize on the next start byte. */
+    if(node_eof)
+      st->bad_checksum++;
+    uart_ring_skip(r, 1);
+    st->skipped++;
+  }
+}
+
+void zb_frame_release(uart_ring_t *r, const zb_frame_t *f)
+{
+  uart_ring_skip(r, f->length);
+}
+
+uint8_t zb_frame_byte(const zb_frame_t *f, uint16_t off)
+{
+  if(off >= f->length)
+    return 0;
+  if(off < f->seg_len[0])
+    return f->seg[0][off];
+  return f->seg[1][off - f->seg_len[0]];
+}
+
+float zb_frame_float(const zb_frame_t *f, uint16_t off)
+{
+  uint8_t raw[4];
+  float   value;
+
+  if((uint32_t)off + sizeof(value) > f->length)
+    return 0;
+  raw[0] = zb_frame_byte(f, off);
+  raw[1] = zb_frame_byte(f, off + 1);
+  raw[2] = zb_frame_byte(f, off + 2);
+  raw[3] = zb_frame_byte(f, off + 3);
+  memcpy(&value, raw, sizeof(value));
+  return value;
+}
+
+uint16_t zb_frame_slots(const zb_frame_t *f)
+{
+  switch(f->type)
+  {
+  case ZB_FRAME_TABLE:
+    return ZB_FRAME_TABLE_SLOTS;
+  case ZB_FRAME_KEY:
+  case ZB_FRAME_DELTA:
+    return zb_frame_byte(f, 4);
+  case ZB_FRAME_REPORT:
+    return zb_frame_byte(f, 2);
+  default:
+    return 1;
+  }
+}
+
+uint16_t zb_frame_slot_addr(const zb_frame_t *f, uint16_t slot)
+{
+  uint16_t off = bound_off(f, 1 + (uint32_t)slot * ZB_FRAME_SLOT_LEN);
+
+  if(f->type == ZB_FRAME_KEY || f->type == ZB_FRAME_DELTA)
+    return zb_frame_byte(f, 3) + slot;
+  if(f->type == ZB_FRAME_REPORT)
+    return zb_frame_byte(f, report_off(f, slot));
+  return view_u16(f, off);
+}
+
+float zb_frame_slot_float(const zb_frame_t *f, uint16_t slot)
+{
+  if(f->type == ZB_FRAME_KEY)
+    return zb_frame_float(f, bound_off(f, ZB_FRAME_TAB_HDR + (uint32_t)slot * zb_frame_byte(f, 5) * 4));
+  if(f->type == ZB_FRAME_REPORT)
+    return zb_frame_float(f, report_off(f, slot) + 1);
+  if(f->type == ZB_FRAME_DELTA || f->type == ZB_FRAME_LINK)
+    return 0;
+  return zb_frame_float(f, bound_off(f, 1 + (uint32_t)slot * ZB_FRAME_SLOT_LEN + 2));
+}
+
+void zb_frame_pose(const zb_frame_t *f, float pose[ZB_FRAME_POSE_AXES])
+{
+  uint16_t i;
+
+  for(i = 0; i < ZB_FRAME_POSE_AXES; i++)
+    pose[i] = zb_frame_float(f, 3 + i * 4);
+}
+
+uint16_t zb_frame_put_node(uint8_t *buf, uint16_t addr, float value)
+{
+  uint8_t  x = 0;
+  uint16_t i;
+
+  buf[0] = ZB_FRAME_SOF;
+  buf[1] = (uint8_t)(addr >> 8);
+  buf[2] = (uint8_t)addr;
+  memcpy(&buf[3], &value, sizeof(value));
+  for(i = 1; i < 1 + ZB_FRAME_SLOT_LEN; i++)
+    x ^= buf[i];
+  buf[1 + ZB_FRAME_SLOT_LEN]     = x;
+  buf[1 + ZB_FRAME_SLOT_LEN + 1] = ZB_FRAME_EOF;
+  return ZB_FRAME_NODE_LEN;
+}
+
+void zb_frame_link(const zb_frame_t *f, zb_frame_link_t *link)
+{
+  link->addr    = view_u16(f, 1);
+  link->rx      = view_u16(f, 3);
+  link->lost    = view_u16(f, 5);
+  link->dup     = view_u16(f, 7);
+  link->reorder = view_u16(f, 9);
+}
+
+int zb_frame_find(const zb_frame_t *f, uint16_t addr, float *value)
+{
+  uint16_t slot;
+
+  if(f->type == ZB_FRAME_KEY || f->type == ZB_FRAME_DELTA || f->type == ZB_FRAME_LINK ||
+     f->type == ZB_FRAME_REPORT)
+    return 0;
+  for(slot = 0; slot < zb_frame_slots(f); slot++)
+  {
+    if(zb_frame_slot_addr(f, slot) == addr)
+    {
+      *value = zb_frame_slot_float(f, slot);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,189 @@
+/**
+  ******************************************************************************
+  * @file           : control_test.c
+  * @brief          : PC unit test for the PID + slew limited output stage (Src/control.c)
+  ******************************************************************************
+  * Built against the reference C CMSIS-DSP sources, as on the Cortex-M3.
+  * Checks the unlimited output against the textbook PID difference
+  * equation, the clamp and slew limits, settling on a first-order plant,
+  * recovery from a long saturation (anti-windup), control_hold() and the
+  * loop-time statistics.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -DARM_MATH_CM3 -I../Inc -I../Drivers/CMSIS/Include -o control_test \
+  *      control_test.c ../Src/control.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/ControllerFunctions/arm_pid_init_f32.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/ControllerFunctions/arm_pid_reset_f32.c -lm
+  *
+  * Usage:
+  *   control_test
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "control.h"
+
+/* Private define ------------------------------------------------------------*/
+#define TRIM          150.0f      /* TIM3 Pulse of MX_TIM3_Init */
+#define OUT_MIN       0.0f
+#define OUT_MAX       300.0f
+
+#define CHECK(c)                                                      \
+  do {                                                                \
+    if(!(c))                                                          \
+    {                                                                 \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c);             \
+      failures++;                                                     \
+    }                                                                 \
+  } while(0)
+
+/* Private types -------------------------------------------------------------*/
+
+/* First-order plant driven by the output around trim. */
+typedef struct
+{
+  float y;
+  float gain;
+  float alpha;                    /* dt / tau */
+} plant_t;
+
+/* Private variables ---------------------------------------------------------*/
+static unsigned failures;
+
+/* Private functions ---------------------------------------------------------*/
+
+static float plant_step(plant_t *p, float out)
+{
+  p->y += p->alpha * (p->gain * (out - TRIM) - p->y);
+  return p->y;
+}
+
+/* Unlimited output is trim + u[n], u[n] = u[n-1] + A0 e[n] + A1 e[n-1] + A2 e[n-2]. */
+static void test_reference(void)
+{
+  const double kp = 2.0, ki = 0.5, kd = 0.25;
+  control_chan_t c;
+  double u = 0, e1 = 0, e2 = 0, e, want;
+  float out;
+  int i;
+
+  control_init(&c, TRIM, -1e9f, 1e9f, 0.0f);
+  control_gains(&c, (float)kp, (float)ki, (float)kd);
+  for(i = 0; i < 200; i++)
+  {
+    e = sin(i * 0.1) * 10.0;
+    u += (kp + ki + kd) * e - (kp + 2 * kd) * e1 + kd * e2;
+    e2 = e1;
+    e1 = e;
+    want = TRIM + u;
+    out = control_step(&c, (float)e, 0.0f);
+    if(fabs(out - want) > 1e-3 * (1.0 + fabs(want)))
+    {
+      printf("FAIL step %d: out %f want %f\n", i, out, want);
+      failures++;
+      break;
+    }
+  }
+}
+
+static void test_limits(void)
+{
+  control_chan_t c;
+  float prev = TRIM, out;
+  int i;
+
+  control_init(&c, TRIM, OUT_MIN, OUT_MAX, 5.0f);
+  control_gains(&c, 50.0f, 10.0f, 0.0f);
+  for(i = 0; i < 400; i++)
+  {
+    out = control_step(&c, i < 200 ? 100.0f : -100.0f, 0.0f);
+    CHECK(out >= OUT_MIN && out <= OUT_MAX);
+    CHECK(fabsf(out - prev) <= 5.0f + 1e-4f);
+    prev = out;
+  }
+  CHECK(out == OUT_MIN);
+
+  /* Back to trim at the slew rate. */
+  for(i = 0; i < 29; i++)
+    CHECK(control_hold(&c) < TRIM);
+  CHECK(control_hold(&c) == TRIM);
+  CHECK(c.pid.state[0] == 0.0f && c.pid.state[2] == 0.0f);
+}
+
+/* PI control of the plant settles on the setpoint. */
+static void test_settle(void)
+{
+  control_chan_t c;
+  plant_t p = { 0.0f, 0.02f, 0.05f };
+  float y = 0.0f;
+  int i;
+
+  control_init(&c, TRIM, OUT_MIN, OUT_MAX, 10.0f);
+  control_gains(&c, 20.0f, 2.0f, 0.0f);
+  for(i = 0; i < 2000; i++)
+    y = plant_step(&p, control_step(&c, 1.0f, y));
+  CHECK(fabsf(y - 1.0f) < 1e-3f);
+}
+
+/* A setpoint out of reach saturates the output; once it is reachable again
+   the loop settles as fast as from rest, because the integrator did not
+   wind up. */
+static void test_windup(void)
+{
+  control_chan_t c;
+  plant_t p = { 0.0f, 0.02f, 0.05f };
+  float y = 0.0f;
+  int i, settled = -1;
+
+  control_init(&c, TRIM, OUT_MIN, OUT_MAX, 0.0f);
+  control_gains(&c, 20.0f, 2.0f, 0.0f);
+  for(i = 0; i < 2000; i++)
+    y = plant_step(&p, control_step(&c, 100.0f, y));
+  CHECK(c.out == OUT_MAX);
+
+  for(i = 0; i < 2000; i++)
+  {
+    y = plant_step(&p, control_step(&c, 1.0f, y));
+    if(settled < 0 && fabsf(y - 1.0f) < 0.01f)
+      settled = i;
+  }
+  CHECK(settled >= 0 && settled < 200);
+  CHECK(fabsf(y - 1.0f) < 1e-3f);
+  printf("windup: settled after %d steps\n", settled);
+}
+
+static void test_stats(void)
+{
+  control_stats_t s;
+
+  control_stats_init(&s);
+  control_stats_add(&s, 1000, 1012);
+  control_stats_add(&s, 2000, 2020);
+  control_stats_add(&s, 2990, 2998);
+  CHECK(s.steps == 3);
+  CHECK(s.period_min == 990 && s.period_max == 1000);
+  CHECK(s.exec_min == 8 && s.exec_max == 20 && s.exec_sum == 40);
+
+  /* The microsecond clock wraps. */
+  control_stats_init(&s);
+  control_stats_add(&s, 0xFFFFFF00u, 0xFFFFFF10u);
+  control_stats_add(&s, 0x00000300u, 0x00000305u);
+  CHECK(s.period_min == 0x400 && s.exec_max == 0x10);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(void)
+{
+  test_reference();
+  test_limits();
+  test_settle();
+  test_windup();
+  test_stats();
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file           : event_test.c
+  * @brief          : PC unit test for the main loop event scheduler (Src/event.c)
+  ******************************************************************************
+  * A fake event_port_t models the interrupt mask: an interrupt raised while
+  * the mask is set stays pending and its handler runs when unlock() lifts
+  * the mask, and the fake idle hook returns at once while an interrupt is
+  * pending, as __WFI does. Idling with the mask clear or with no interrupt
+  * left to wake the core is a failure.
+  *
+  * Checks that handlers run lowest event first, that an event posted by a
+  * handler runs on the next pass, that an interrupt raised between the
+  * pending check and the idle hook is not slept through, and the wakeup,
+  * sleep time, dispatch and per-event counters against a model of random
+  * posts and timer wakeups.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -g -fsanitize=address,undefined -I../Inc -o event_test \
+  *      event_test.c ../Src/event.c
+  *
+  * Usage:
+  *   event_test [passes] [seed]
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK(c)                                                      \
+  do {                                                                \
+    if(!(c))                                                          \
+    {                                                                 \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c);             \
+      failures++;                                                     \
+    }                                                                 \
+  } while(0)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t fake_masked;          /* interrupts masked                  */
+static uint32_t fake_now;             /* clock                              */
+static uint32_t fake_irq;             /* events of raised interrupts        */
+static uint32_t fake_on_lock;         /* raised at the next lock()          */
+static uint32_t fake_timer_at;        /* clock of the timer interrupt       */
+static uint32_t fake_timer_events;    /* its events, 0 if not armed         */
+static unsigned fake_idles;
+
+static uint8_t  order[EVENT_MAX];     /* handlers in the order they ran     */
+static uint8_t  order_len;
+static uint32_t post_from[EVENT_MAX]; /* posted by the handler of an event  */
+static unsigned failures;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* The interrupt handlers, run as soon as the mask is clear. */
+static void fake_service(void)
+{
+  uint32_t events;
+
+  if(!fake_masked && fake_irq != 0)
+  {
+    events   = fake_irq;
+    fake_irq = 0;
+    event_post(events);
+  }
+}
+
+static uint32_t fake_lock(void)
+{
+  uint32_t key = fake_masked;
+
+  fake_masked = 1;
+  fake_irq     |= fake_on_lock;
+  fake_on_lock  = 0;
+  return key;
+}
+
+static void fake_unlock(uint32_t key)
+{
+  fake_masked = key;
+  fake_service();
+}
+
+/* __WFI: returns at once if an interrupt is pending, else at the timer. */
+static void fake_idle(void)
+{
+  fake_idles++;
+  CHECK(fake_masked);
+  if(fake_irq != 0)
+    return;
+  if(fake_timer_events == 0)
+  {
+    printf("FAIL idle with no interrupt to wake it\n");
+    failures++;
+    return;
+  }
+  fake_now          = fake_timer_at;
+  fake_irq         |= fake_timer_events;
+  fake_timer_events = 0;
+}
+
+static uint32_t fake_clock(void)
+{
+  return fake_now;
+}
+
+static const event_port_t fake_port = { fake_lock, fake_unlock, fake_idle, fake_clock };
+
+/* An interrupt from the main loop's point of view, mask clear. */
+static void fake_interrupt(uint32_t events)
+{
+  CHECK(!fake_masked);
+  fake_irq |= events;
+  fake_service();
+}
+
+static void fake_timer(uint32_t after, uint32_t events)
+{
+  fake_timer_at     = fake_now + after;
+  fake_timer_events = events;
+}
+
+#define HANDLER(id)                                                   \
+  static void handler_##id(void)                                      \
+  {                                                                   \
+    CHECK(!fake_masked);                                              \
+    order[order_len++] = id;                                          \
+    if(post_from[id] != 0)                                            \
+      event_post(post_from[id]);                                      \
+  }
+HANDLER(0)  HANDLER(1)  HANDLER(2)  HANDLER(3)  HANDLER(5)  HANDLER(17)
+HANDLER(30) HANDLER(31)
+
+static void setup(void)
+{
+  fake_masked = fake_now = fake_irq = fake_on_lock = fake_timer_events = 0;
+  fake_idles  = 0;
+  order_len   = 0;
+  memset(post_from, 0, sizeof(post_from));
+
+  event_init(&fake_port);
+  event_register(0, handler_0);
+  event_register(1, handler_1);
+  event_register(2, handler_2);
+  event_register(3, handler_3);
+  event_register(5, handler_5);
+  event_register(17, handler_17);
+  event_register(30, handler_30);
+  event_register(31, handler_31);
+  event_register(EVENT_MAX, handler_0);       /* out of range, ignored */
+}
+
+/* Lowest event first, once per pass however often it was posted. */
+static void test_order(void)
+{
+  setup();
+  fake_interrupt(EVENT(31) | EVENT(5));
+  fake_interrupt(EVENT(17) | EVENT(0) | EVENT(5));
+  fake_interrupt(EVENT(9));                   /* no handler */
+  CHECK(event_run_once() == 4);
+  CHECK(order_len == 4);
+  CHECK(order[0] == 0 && order[1] == 5 && order[2] == 17 && order[3] == 31);
+  CHECK(event_stats.count[5] == 1 && event_stats.count[9] == 1);
+  CHECK(event_stats.dispatched == 4);
+  CHECK(fake_idles == 0);
+
+  /* Posted by a handler: next pass, even for a lower event or itself. */
+  order_len = 0;
+  post_from[3] = EVENT(1) | EVENT(3);
+  fake_interrupt(EVENT(3) | EVENT(30));
+  CHECK(event_run_once() == 2);
+  CHECK(order_len == 2 && order[0] == 3 && order[1] == 30);
+  post_from[3] = 0;
+  CHECK(event_run_once() == 2);
+  CHECK(order_len == 4 && order[2] == 1 && order[3] == 3);
+  CHECK(event_stats.count[3] == 2 && event_stats.count[1] == 1);
+  CHECK(event_stats.dispatched == 8);
+}
+
+/* An interrupt raised after the pending word was read, before the idle hook. */
+static void test_race(void)
+{
+  setup();
+  fake_on_lock = EVENT(2);
+  CHECK(event_run_once() == 0);
+  CHECK(fake_idles == 1);
+  CHECK(event_stats.wakeups == 1 && event_stats.sleep_time == 0);
+  CHECK(fake_irq == 0);
+  CHECK(event_run_once() == 1);
+  CHECK(order_len == 1 && order[0] == 2);
+
+  /* The same while handlers run: it waits for the next pass. */
+  fake_interrupt(EVENT(17));
+  fake_on_lock = EVENT(0);
+  CHECK(event_run_once() == 1);
+  CHECK(order[1] == 17);
+  CHECK(event_run_once() == 1);
+  CHECK(order[2] == 0);
+  CHECK(fake_idles == 1);
+}
+
+/* Random interrupts and timer wakeups against a model of the counters. */
+static void test_random(unsigned long passes)
+{
+  const uint32_t handled = EVENT(0) | EVENT(1) | EVENT(2) | EVENT(3) | EVENT(5) |
+                           EVENT(17) | EVENT(30) | EVENT(31);
+  uint32_t pending = 0, raised, expect, events;
+  uint32_t wakeups = 0, sleep_time = 0, dispatched = 0, count[EVENT_MAX];
+  unsigned long n;
+  uint16_t calls;
+  uint8_t  id;
+
+  setup();
+  memset(count, 0, sizeof(count));
+  for(n = 0; n < passes && failures == 0; n++)
+  {
+    if(rand() % 3 == 0)
+    {
+      events = EVENT(rand() % EVENT_MAX) | EVENT(rand() % EVENT_MAX);
+      fake_interrupt(events);
+      pending |= events;
+    }
+    raised = 0;
+    if(rand() % 4 == 0)
+    {
+      raised = EVENT(rand() % EVENT_MAX);
+      fake_on_lock = raised;
+    }
+    if(fake_timer_events == 0)
+      fake_timer(1 + rand() % 1000, EVENT(rand() % EVENT_MAX));
+
+    order_len = 0;
+    expect    = 0;
+    if(pending != 0)
+    {
+      for(id = 0; id < EVENT_MAX; id++)
+      {
+        if(pending & EVENT(id))
+        {
+          count[id]++;
+          if(handled & EVENT(id))
+            expect++;
+        }
+      }
+      dispatched += expect;
+      pending = raised;
+    }
+    else
+    {
+      wakeups++;
+      if(raised == 0)
+      {
+        sleep_time += fake_timer_at - fake_now;
+        pending = fake_timer_events;
+      }
+      else
+        pending = raised;
+    }
+
+    calls = event_run_once();
+    if(calls != expect)
+    {
+      printf("FAIL pass %lu: %u handlers, expected %lu\n", n, calls, (unsigned long)expect);
+      failures++;
+    }
+    for(id = 1; id < order_len; id++)
+      CHECK(order[id - 1] < order[id]);
+  }
+
+  CHECK(event_stats.wakeups == wakeups);
+  CHECK(event_stats.sleep_time == sleep_time);
+  CHECK(event_stats.dispatched == dispatched);
+  CHECK(memcmp(event_stats.count, count, sizeof(count)) == 0);
+  printf("random: %lu passes, %lu wakeups, %lu clock asleep, %lu handlers\n", n,
+         (unsigned long)wakeups, (unsigned long)sleep_time, (unsigned long)dispatched);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+  unsigned long passes = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000;
+
+  srand(argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1);
+
+  test_order();
+  test_race();
+  test_random(passes);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
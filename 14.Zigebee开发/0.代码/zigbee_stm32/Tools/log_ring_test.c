@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * @file           : log_ring_test.c
+  * @brief          : PC unit test for the USART1 log transmit ring (Src/log_ring.c)
+  ******************************************************************************
+  * The main loop side writes random-length messages, a simulated TX DMA
+  * claims blocks and completes them after a random delay, and everything
+  * it sends is compared with what was accepted. The test checks that
+  * blocks never run past the end of the ring, that a block in flight is
+  * never overwritten, and that every byte not accepted is counted in
+  * dropped.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -I../Inc -o log_ring_test log_ring_test.c ../Src/log_ring.c
+  *
+  * Usage:
+  *   log_ring_test [iterations] [seed]
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_ring.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RING_SIZE     128
+
+#define CHECK(c)                                                      \
+  do {                                                                \
+    if(!(c))                                                          \
+    {                                                                 \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c);             \
+      failures++;                                                     \
+    }                                                                 \
+  } while(0)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  *data;             /* block in flight, NULL when idle          */
+  uint16_t  len;
+  uint8_t   copy[RING_SIZE];  /* its bytes when it was claimed            */
+  uint32_t  accepted;         /* stream position of the next byte to send */
+  uint32_t  sent;
+} sim_dma_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t storage[RING_SIZE];
+static unsigned failures;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Byte of the accepted stream at a position. */
+static uint8_t pattern(uint32_t pos)
+{
+  return (uint8_t)(pos * 13u + (pos >> 8) + 1);
+}
+
+/* Write len bytes of the stream, as printf would; returns the number taken. */
+static uint16_t log_write(log_ring_t *r, sim_dma_t *d, uint16_t len)
+{
+  uint8_t  msg[2 * RING_SIZE];
+  uint32_t dropped = r->dropped;
+  uint16_t i, n;
+
+  for(i = 0; i < len; i++)
+    msg[i] = pattern(d->accepted + i);
+  n = log_ring_write(r, msg, len);
+  CHECK(n <= len);
+  CHECK(r->dropped - dropped == (uint32_t)(len - n));
+  CHECK(log_ring_pending(r) <= RING_SIZE);
+  d->accepted += n;
+  return n;
+}
+
+/* Start a transfer if the DMA is idle. */
+static void dma_start(log_ring_t *r, sim_dma_t *d)
+{
+  uint8_t *p;
+  uint16_t len;
+
+  if(d->data != NULL)
+  {
+    CHECK(log_ring_claim(r, &p) == 0);
+    return;
+  }
+  len = log_ring_claim(r, &p);
+  if(len == 0)
+    return;
+  CHECK(p >= storage && p + len <= storage + RING_SIZE);
+  CHECK(log_ring_busy(r));
+  d->data = p;
+  d->len  = len;
+  memcpy(d->copy, p, len);
+}
+
+/* The transfer completes: its bytes must be the stream, unchanged. */
+static void dma_complete(log_ring_t *r, sim_dma_t *d)
+{
+  uint16_t i;
+
+  if(d->data == NULL)
+    return;
+  for(i = 0; i < d->len; i++)
+  {
+    if(d->data[i] != d->copy[i] || d->copy[i] != pattern(d->sent + i))
+    {
+      printf("FAIL byte %lu: sent 0x%02x, ring 0x%02x, want 0x%02x\n",
+             (unsigned long)(d->sent + i), d->copy[i], d->data[i], pattern(d->sent + i));
+      failures++;
+      break;
+    }
+  }
+  d->sent += d->len;
+  d->data  = NULL;
+  log_ring_done(r);
+  CHECK(!log_ring_busy(r));
+}
+
+static void sim_init(log_ring_t *r, sim_dma_t *d)
+{
+  log_ring_init(r, storage, RING_SIZE);
+  memset(d, 0, sizeof(*d));
+}
+
+/* The claim stops at the end of the ring; the rest follows in a second block. */
+static void test_wrap(void)
+{
+  log_ring_t r;
+  sim_dma_t d;
+
+  sim_init(&r, &d);
+  log_write(&r, &d, RING_SIZE - 10);
+  dma_start(&r, &d);
+  dma_complete(&r, &d);
+  CHECK(log_write(&r, &d, 30) == 30);
+  dma_start(&r, &d);
+  CHECK(d.len == 10);
+  dma_complete(&r, &d);
+  dma_start(&r, &d);
+  CHECK(d.len == 20 && d.data == storage);
+  dma_complete(&r, &d);
+  CHECK(log_ring_pending(&r) == 0 && r.dropped == 0);
+}
+
+/* Drop-newest: a full ring keeps what it has, including the block in flight. */
+static void test_overflow(void)
+{
+  log_ring_t r;
+  sim_dma_t d;
+
+  sim_init(&r, &d);
+  CHECK(log_write(&r, &d, 100) == 100);
+  dma_start(&r, &d);
+  CHECK(log_write(&r, &d, 50) == RING_SIZE - 100);
+  CHECK(r.dropped == 50 - (RING_SIZE - 100));
+  CHECK(log_write(&r, &d, 7) == 0);
+  CHECK(r.dropped == 57 - (RING_SIZE - 100));
+  dma_complete(&r, &d);
+  CHECK(log_ring_pending(&r) == RING_SIZE - 100);
+  CHECK(log_write(&r, &d, 100) == 100);
+  while(log_ring_pending(&r))
+  {
+    dma_start(&r, &d);
+    dma_complete(&r, &d);
+  }
+  CHECK(d.sent == d.accepted);
+}
+
+/* Random writes against a DMA that completes at random times. */
+static void test_random(unsigned long iterations)
+{
+  log_ring_t r;
+  sim_dma_t d;
+  unsigned long i, offered = 0;
+
+  sim_init(&r, &d);
+  for(i = 0; i < iterations && failures == 0; i++)
+  {
+    uint16_t len = (uint16_t)(rand() % (RING_SIZE / 2));
+
+    offered += len;
+    log_write(&r, &d, len);
+    if(rand() % 3 == 0)
+      dma_complete(&r, &d);
+    dma_start(&r, &d);
+  }
+  while(log_ring_pending(&r) && failures == 0)
+  {
+    dma_complete(&r, &d);
+    dma_start(&r, &d);
+  }
+  CHECK(d.sent == d.accepted);
+  CHECK(offered == d.accepted + r.dropped);
+  printf("random: %lu writes, %lu bytes offered, %lu sent, %lu dropped\n",
+         i, offered, (unsigned long)d.sent, (unsigned long)r.dropped);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000;
+
+  srand(argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1);
+
+  test_wrap();
+  test_overflow();
+  test_random(iterations);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : pose_bench.c
+  * @brief          : PC benchmark for the pose filter (Src/pose.c)
+  ******************************************************************************
+  * Feeds a noisy synthetic trajectory through pose_update() and reports the
+  * time per update and how much the filter reduces the position error, and
+  * how well it estimates the rate. A last pass spins the angles through
+  * +-pi to check the wrapped innovation. The generic C CMSIS-DSP kernels are
+  * used, as on the Cortex-M3 (no FPU, no SIMD); on x86 the time is also
+  * given in TSC cycles.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -DARM_MATH_CM3 -I../Inc -I../Drivers/CMSIS/Include -o pose_bench \
+  *      pose_bench.c ../Src/pose.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/MatrixFunctions/arm_mat_init_f32.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/MatrixFunctions/arm_mat_mult_f32.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/MatrixFunctions/arm_mat_add_f32.c \
+  *      ../Drivers/CMSIS/DSP_Lib/Source/MatrixFunctions/arm_mat_trans_f32.c -lm
+  *
+  * Usage:
+  *   pose_bench [updates]
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "pose.h"
+
+/* Private define ------------------------------------------------------------*/
+#define DT            0.01f       /* 100 Hz, the default request rate */
+#define NOISE         0.05f
+#define ACCEL         100.0f      /* process noise, covers the test motion */
+
+/* Private functions ---------------------------------------------------------*/
+
+static float noise(void)
+{
+  /* Sum of uniforms, roughly gaussian with unit variance. */
+  float s = 0.0f;
+  int i;
+
+  for(i = 0; i < 12; i++)
+    s += (float)rand() / RAND_MAX;
+  return s - 6.0f;
+}
+
+/* Difference of two angles in (-pi, pi]. */
+static float angle_diff(float a, float b)
+{
+  float d = fmodf(a - b, 2.0f * (float)M_PI);
+
+  if(d > (float)M_PI)
+    d -= 2.0f * (float)M_PI;
+  if(d <= -(float)M_PI)
+    d += 2.0f * (float)M_PI;
+  return d;
+}
+
+static double now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+  long n = argc > 1 ? atol(argv[1]) : 100000;
+  float32_t (*z)[POSE_AXES];
+  float32_t truth[POSE_AXES], truth_rate[POSE_AXES];
+  float32_t pose[POSE_AXES], rate[POSE_AXES];
+  double raw_err = 0, pose_err = 0, rate_err = 0, wrap_err = 0, wrap_rate = 0, t0, t1;
+  pose_filter_t f;
+  long i;
+  int a;
+#ifdef HAVE_TSC
+  unsigned long long c0, c1;
+#endif
+
+  z = malloc(sizeof(*z) * n);
+  if(z == NULL || n < 2)
+    return 1;
+
+  /* Measurements of a slow sine on every axis. */
+  for(i = 0; i < n; i++)
+    for(a = 0; a < POSE_AXES; a++)
+      z[i][a] = sinf(i * DT * (a + 1) * 0.5f) + NOISE * noise();
+
+  pose_init(&f, ACCEL, NOISE * NOISE, ACCEL, NOISE * NOISE);
+  t0 = now_ns();
+#ifdef HAVE_TSC
+  c0 = __rdtsc();
+#endif
+  for(i = 0; i < n; i++)
+    pose_update(&f, z[i], DT);
+#ifdef HAVE_TSC
+  c1 = __rdtsc();
+#endif
+  t1 = now_ns();
+
+  /* Accuracy pass, skipping the settling time. */
+  pose_init(&f, ACCEL, NOISE * NOISE, ACCEL, NOISE * NOISE);
+  for(i = 0; i < n; i++)
+  {
+    pose_update(&f, z[i], DT);
+    if(i < 100)
+      continue;
+    pose_get(&f, pose, rate);
+    for(a = 0; a < POSE_AXES; a++)
+    {
+      truth[a]      = sinf(i * DT * (a + 1) * 0.5f);
+      truth_rate[a] = (a + 1) * 0.5f * cosf(i * DT * (a + 1) * 0.5f);
+      raw_err  += (z[i][a] - truth[a]) * (z[i][a] - truth[a]);
+      pose_err += (pose[a] - truth[a]) * (pose[a] - truth[a]);
+      rate_err += (rate[a] - truth_rate[a]) * (rate[a] - truth_rate[a]);
+    }
+  }
+
+  /* Angles turning at 1 rad/s, measured wrapped into (-pi, pi]. */
+  pose_init(&f, ACCEL, NOISE * NOISE, ACCEL, NOISE * NOISE);
+  for(i = 0; i < n; i++)
+  {
+    for(a = 0; a < POSE_AXES; a++)
+      z[i][a] = angle_diff(i * DT + NOISE * noise(), 0.0f);
+    pose_update(&f, z[i], DT);
+    if(i < 100)
+      continue;
+    pose_get(&f, pose, rate);
+    for(a = POSE_AXES / 2; a < POSE_AXES; a++)
+    {
+      wrap_err  += angle_diff(pose[a], i * DT) * angle_diff(pose[a], i * DT);
+      wrap_rate += (rate[a] - 1.0f) * (rate[a] - 1.0f);
+    }
+  }
+
+  printf("updates      %ld\n", n);
+  printf("time/update  %.1f ns\n", (t1 - t0) / n);
+#ifdef HAVE_TSC
+  printf("cycles/update %.0f (TSC)\n", (double)(c1 - c0) / n);
+#endif
+  i = (n - 100) * POSE_AXES;
+  printf("rms error    raw %.4f filtered %.4f rate %.4f\n",
+         sqrt(raw_err / i), sqrt(pose_err / i), sqrt(rate_err / i));
+  i = (n - 100) * (POSE_AXES / 2);
+  printf("spinning angles rms error %.4f rate %.4f\n", sqrt(wrap_err / i), sqrt(wrap_rate / i));
+  free(z);
+  return 0;
+}
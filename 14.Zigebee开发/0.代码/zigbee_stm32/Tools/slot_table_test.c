@@ -0,0 +1,315 @@
+/**
+  ******************************************************************************
+  * @file           : slot_table_test.c
+  * @brief          : PC unit test for the slot-table decoder (Src/slot_table.c)
+  ******************************************************************************
+  * Encodes random node tables as keyframes and 16-bit delta frames laid out
+  * as SerialApp SlotFrame.h sends them, passes them through the receive
+  * ring and zb_frame_next(), and checks that every decoded delta value is
+  * within half a quantum (plus float rounding) of the value sent.
+  *
+  * Also checks the length checks: a header whose count x m wraps the frame
+  * length in 16 bits must be rejected, and slot_table_update() must stay
+  * inside frames, key, delta or report, that claim more slots than they
+  * hold, as must the zb_frame_slot_*() accessors. Frames are handed to
+  * the decoder in buffers of exactly their length, so with
+  * -fsanitize=address a read past the end is caught.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -g -fsanitize=address,undefined -I../Inc -o slot_table_test \
+  *      slot_table_test.c ../Src/slot_table.c ../Src/zb_frame.c ../Src/uart_ring.c -lm
+  *
+  * Usage:
+  *   slot_table_test [rounds] [seed]
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slot_table.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RING_SIZE     256
+#define EXP           (-4)        /* quantum 1/16, SERIAL_APP_DELTA_EXP      */
+
+#define CHECK(c)                                                      \
+  do {                                                                \
+    if(!(c))                                                          \
+    {                                                                 \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c);             \
+      failures++;                                                     \
+    }                                                                 \
+  } while(0)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t  storage[RING_SIZE];
+static uint16_t ndtr = RING_SIZE;
+static unsigned failures;
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t seal(uint8_t *buf, uint16_t n)
+{
+  uint8_t  x = 0;
+  uint16_t i;
+
+  for(i = 1; i < n; i++)
+    x ^= buf[i];
+  buf[n]     = x;
+  buf[n + 1] = ZB_FRAME_EOF;
+  return n + 2;
+}
+
+static uint16_t put_key(uint8_t *buf, uint8_t id, uint8_t first, uint8_t count,
+                        uint8_t m, const float *v)
+{
+  buf[0] = ZB_FRAME_KEY_SOF;
+  buf[1] = 0;
+  buf[2] = id;
+  buf[3] = first;
+  buf[4] = count;
+  buf[5] = m;
+  memcpy(&buf[ZB_FRAME_TAB_HDR], v, count * m * sizeof(float));
+  return seal(buf, ZB_FRAME_TAB_HDR + count * m * sizeof(float));
+}
+
+/* As SlotFrame_BuildDelta: round to the nearest quantum, little-endian. */
+static uint16_t put_delta(uint8_t *buf, uint8_t id, uint8_t first, uint8_t count,
+                          uint8_t m, const float *v, const float *key)
+{
+  uint16_t n = ZB_FRAME_TAB_HDR, i;
+  int16_t  d;
+
+  buf[0] = ZB_FRAME_DELTA_SOF;
+  buf[1] = 0;
+  buf[2] = id;
+  buf[3] = first;
+  buf[4] = count;
+  buf[5] = m;
+  for(i = 0; i < m; i++)
+    buf[n++] = (uint8_t)(int8_t)EXP;
+  for(i = 0; i < count * m; i++)
+  {
+    d = (int16_t)lrintf(ldexpf(v[i] - key[i], -EXP));
+    buf[n++] = (uint8_t)d;
+    buf[n++] = (uint8_t)(d >> 8);
+  }
+  return seal(buf, n);
+}
+
+/* Receive bytes as the DMA would. */
+static void dma_receive(uart_ring_t *r, const uint8_t *p, uint16_t n)
+{
+  while(n--)
+  {
+    storage[RING_SIZE - ndtr] = *p++;
+    if(--ndtr == 0)
+      ndtr = RING_SIZE;
+  }
+  uart_ring_dma_update(r, ndtr);
+}
+
+/* A view of exactly len bytes. */
+static void view(zb_frame_t *f, const uint8_t *buf, uint16_t len, uint8_t type)
+{
+  f->seg[0]     = buf;
+  f->seg_len[0] = len;
+  f->seg[1]     = buf + len;
+  f->seg_len[1] = 0;
+  f->length     = len;
+  f->type       = type;
+}
+
+/* Decode one frame from the ring into an exact-length copy and apply it. */
+static uint16_t apply(uart_ring_t *r, slot_table_t *t, const uint8_t *buf, uint16_t len)
+{
+  zb_frame_stats_t st = { 0 };
+  zb_frame_t f, c;
+  uint8_t *copy;
+  uint16_t i, done;
+
+  dma_receive(r, buf, len);
+  if(!zb_frame_next(r, &f, &st))
+  {
+    printf("FAIL frame of %u bytes not decoded\n", len);
+    failures++;
+    return 0;
+  }
+  CHECK(f.length == len);
+  copy = malloc(f.length);
+  for(i = 0; i < f.length; i++)
+    copy[i] = zb_frame_byte(&f, i);
+  view(&c, copy, f.length, f.type);
+  done = slot_table_update(t, &c);
+  free(copy);
+  zb_frame_release(r, &f);
+  return done;
+}
+
+/* count x m = 128 x 128 floats is 65544 bytes, 8 in 16 bits. */
+static void test_wrapped_length(void)
+{
+  uart_ring_t r;
+  zb_frame_stats_t st = { 0 };
+  zb_frame_t f;
+  uint8_t buf[8] = { ZB_FRAME_KEY_SOF, 0, 0, 0, 128, 128 };
+  uint8_t pad[16];
+
+  uart_ring_init(&r, storage, RING_SIZE);
+  ndtr = RING_SIZE;
+  seal(buf, 6);
+  dma_receive(&r, buf, sizeof(buf));
+  memset(pad, 0, sizeof(pad));
+  dma_receive(&r, pad, sizeof(pad));
+  CHECK(!zb_frame_next(&r, &f, &st));
+  CHECK(st.bad_checksum == 1);
+
+  /* The same for a delta frame and a report frame. */
+  buf[0] = ZB_FRAME_DELTA_SOF;
+  buf[4] = 255;
+  buf[5] = 128;
+  seal(buf, 6);
+  dma_receive(&r, buf, sizeof(buf));
+  dma_receive(&r, pad, sizeof(pad));
+  CHECK(!zb_frame_next(&r, &f, &st));
+
+  buf[0] = ZB_FRAME_REPORT_SOF;
+  buf[2] = 255;
+  buf[3] = 64;
+  seal(buf, 4);
+  dma_receive(&r, buf, 6);
+  dma_receive(&r, pad, sizeof(pad));
+  CHECK(!zb_frame_next(&r, &f, &st));
+}
+
+/* Frames that claim more slots than they hold decode only what is there. */
+static void test_short_frames(void)
+{
+  slot_table_t t;
+  zb_frame_t f;
+  float    v[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t  buf[64], *copy;
+  uint16_t len;
+
+  slot_table_init(&t);
+  len  = put_key(buf, 1, 0, 2, 2, v);
+  buf[4] = 200;                         /* count */
+  copy = malloc(len);
+  memcpy(copy, buf, len);
+  view(&f, copy, len, ZB_FRAME_KEY);
+  CHECK(slot_table_update(&t, &f) == 2);
+  CHECK(t.slot[1].value[1] == 4.0f);
+  free(copy);
+
+  len  = put_delta(buf, 1, 0, 2, 2, v, v);
+  buf[4] = 200;
+  buf[5] = 200;                         /* m, exponents run past the end */
+  copy = malloc(len);
+  memcpy(copy, buf, len);
+  view(&f, copy, len, ZB_FRAME_DELTA);
+  CHECK(slot_table_update(&t, &f) == 0);
+  free(copy);
+
+  /* A report of two entries, slots 3 and 5, that claims 200. */
+  buf[0] = ZB_FRAME_REPORT_SOF;
+  buf[1] = 0;
+  buf[2] = 2;
+  buf[3] = 2;
+  buf[4] = 3;
+  memcpy(&buf[5], &v[0], 8);
+  buf[13] = 5;
+  memcpy(&buf[14], &v[2], 8);
+  len  = seal(buf, 22);
+  buf[2] = 200;
+  copy = malloc(len);
+  memcpy(copy, buf, len);
+  view(&f, copy, len, ZB_FRAME_REPORT);
+  CHECK(slot_table_update(&t, &f) == 2);
+  CHECK(t.slot[5].value[0] == 3.0f && t.slot[5].value[1] == 4.0f);
+  CHECK(zb_frame_slot_addr(&f, 1) == 5 && zb_frame_slot_float(&f, 1) == 3.0f);
+  CHECK(zb_frame_slot_addr(&f, 199) == 0 && zb_frame_slot_float(&f, 199) == 0.0f);
+  CHECK(zb_frame_slot_float(&f, 0xFFFF) == 0.0f);
+  free(copy);
+
+  /* Too short for a header. */
+  copy = malloc(3);
+  memcpy(copy, buf, 3);
+  view(&f, copy, 3, ZB_FRAME_KEY);
+  CHECK(slot_table_update(&t, &f) == 0);
+  CHECK(zb_frame_float(&f, 0) == 0.0f && zb_frame_byte(&f, 3) == 0);
+  free(copy);
+}
+
+/* Keyframe, then deltas of random walks; every value within the bound. */
+static void test_error_bound(unsigned long rounds)
+{
+  uart_ring_t r;
+  slot_table_t t;
+  float    key[8 * 4], v[8 * 4], err, max_err = 0, bound;
+  uint8_t  buf[ZB_FRAME_TAB_MAX];
+  uint16_t len, i, s, j;
+  uint8_t  m, count, first, id = 0;
+  unsigned long n, values = 0;
+
+  uart_ring_init(&r, storage, RING_SIZE);
+  ndtr = RING_SIZE;
+  slot_table_init(&t);
+
+  for(n = 0; n < rounds && failures == 0; n++)
+  {
+    m     = 1 + rand() % SLOT_TABLE_M;
+    count = 1 + rand() % ((ZB_FRAME_TAB_MAX - ZB_FRAME_TAB_HDR - m - 2) / (m * 4));
+    first = rand() % (SLOT_TABLE_SLOTS - count + 1);
+    id++;
+    for(i = 0; i < count * m; i++)
+      key[i] = ((float)rand() / RAND_MAX - 0.5f) * 2000.0f;
+    CHECK(apply(&r, &t, buf, put_key(buf, id, first, count, m, key)) == count);
+
+    for(j = 0; j < 8; j++)
+    {
+      /* Deltas up to 2000 quanta, well inside 16 bits. */
+      for(i = 0; i < count * m; i++)
+        v[i] = key[i] + ((float)rand() / RAND_MAX - 0.5f) * 2000.0f * ldexpf(1.0f, EXP);
+      len = put_delta(buf, id, first, count, m, v, key);
+      CHECK(apply(&r, &t, buf, len) == count);
+      for(s = 0; s < count; s++)
+      {
+        for(i = 0; i < m; i++)
+        {
+          err   = fabsf(t.slot[first + s].value[i] - v[s * m + i]);
+          bound = ldexpf(1.0f, EXP - 1) + 2.0f * ldexpf(fabsf(v[s * m + i]), -23);
+          if(err > bound)
+          {
+            printf("FAIL slot %u ch %u: sent %f decoded %f\n",
+                   first + s, i, v[s * m + i], t.slot[first + s].value[i]);
+            failures++;
+          }
+          if(err > max_err)
+            max_err = err;
+          values++;
+        }
+      }
+    }
+  }
+  printf("deltas: %lu values, max error %g, half quantum %g\n",
+         values, max_err, ldexpf(1.0f, EXP - 1));
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+  unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+
+  srand(argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1);
+
+  test_wrapped_length();
+  test_short_frames();
+  test_error_bound(rounds);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
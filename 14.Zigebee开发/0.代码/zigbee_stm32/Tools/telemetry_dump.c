@@ -0,0 +1,172 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry_dump.c
+  * @brief          : PC decoder for USART1 binary telemetry captures
+  ******************************************************************************
+  * Reads a raw capture of the USART1 stream (e.g. saved by a serial terminal
+  * or "cat /dev/ttyUSB0 > capture.bin") and reports throughput, sequence
+  * gaps and the per-node update interval, i.e. the worst-case age of a
+  * value seen by the STM32.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -I../Inc -o telemetry_dump telemetry_dump.c ../Src/telemetry.c
+  *
+  * Usage:
+  *   telemetry_dump [-v] capture.bin
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+/* Private define ------------------------------------------------------------*/
+#define MAX_NODES   64
+#define MAX_FRAME   64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint16_t node;
+  uint32_t count;
+  uint32_t last_tick;
+  uint32_t min_gap;
+  uint32_t max_gap;
+  uint64_t sum_gap;
+} node_stats_t;
+
+/* Private variables ---------------------------------------------------------*/
+static node_stats_t nodes[MAX_NODES];
+static int          node_count;
+
+/* Private functions ---------------------------------------------------------*/
+
+static node_stats_t *node_get(uint16_t node)
+{
+  int i;
+
+  for(i = 0; i < node_count; i++)
+  {
+    if(nodes[i].node == node)
+      return &nodes[i];
+  }
+  if(node_count == MAX_NODES)
+    return NULL;
+  memset(&nodes[node_count], 0, sizeof(nodes[0]));
+  nodes[node_count].node    = node;
+  nodes[node_count].min_gap = 0xFFFFFFFFu;
+  return &nodes[node_count++];
+}
+
+int main(int argc, char **argv)
+{
+  const char *path = NULL;
+  int verbose = 0;
+  FILE *fp;
+  uint8_t frame[MAX_FRAME];
+  uint8_t raw[MAX_FRAME];
+  uint16_t frame_len = 0;
+  uint16_t raw_len;
+  uint32_t bytes = 0, records = 0, bad = 0, lost = 0;
+  uint32_t first_tick = 0, last_tick = 0;
+  uint16_t next_seq = 0;
+  telemetry_record_t rec;
+  node_stats_t *ns;
+  double secs;
+  int c, i;
+
+  for(i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-v") == 0)
+      verbose = 1;
+    else
+      path = argv[i];
+  }
+  if(path == NULL)
+  {
+    fprintf(stderr, "usage: %s [-v] capture.bin\n", argv[0]);
+    return 2;
+  }
+  fp = fopen(path, "rb");
+  if(fp == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+
+  while((c = fgetc(fp)) != EOF)
+  {
+    bytes++;
+    if(c != 0)
+    {
+      if(frame_len < MAX_FRAME)
+        frame[frame_len] = (uint8_t)c;
+      frame_len++;
+      continue;
+    }
+
+    /* 0x00 ends a frame. */
+    if(frame_len == 0)
+      continue;
+    raw_len = frame_len <= MAX_FRAME ? cobs_decode(frame, frame_len, raw) : 0;
+    frame_len = 0;
+    if(!telemetry_unpack(raw, raw_len, &rec))
+    {
+      bad++;
+      continue;
+    }
+
+    if(records == 0)
+      first_tick = rec.tick;
+    else if(rec.seq != next_seq)
+      lost += (uint16_t)(rec.seq - next_seq);
+    next_seq  = rec.seq + 1;
+    last_tick = rec.tick;
+    records++;
+
+    ns = node_get(rec.node);
+    if(ns != NULL)
+    {
+      if(ns->count != 0)
+      {
+        uint32_t gap = rec.tick - ns->last_tick;
+
+        if(gap < ns->min_gap)
+          ns->min_gap = gap;
+        if(gap > ns->max_gap)
+          ns->max_gap = gap;
+        ns->sum_gap += gap;
+      }
+      ns->last_tick = rec.tick;
+      ns->count++;
+    }
+
+    if(verbose)
+      printf("%5u %10lu node 0x%04X %g\n", rec.seq, (unsigned long)rec.tick,
+             rec.node, (double)rec.value);
+  }
+  fclose(fp);
+
+  secs = (last_tick - first_tick) / 1000.0;
+  printf("bytes      %lu\n", (unsigned long)bytes);
+  printf("records    %lu (bad %lu, lost %lu)\n", (unsigned long)records,
+         (unsigned long)bad, (unsigned long)lost);
+  printf("duration   %.3f s\n", secs);
+  if(secs > 0)
+    printf("throughput %.1f records/s, %.1f B/s\n", records / secs, bytes / secs);
+
+  printf("node    count  interval min/avg/max (ms)\n");
+  for(i = 0; i < node_count; i++)
+  {
+    ns = &nodes[i];
+    if(ns->count > 1)
+      printf("0x%04X %6lu  %lu / %.1f / %lu\n", ns->node, (unsigned long)ns->count,
+             (unsigned long)ns->min_gap, (double)ns->sum_gap / (ns->count - 1),
+             (unsigned long)ns->max_gap);
+    else
+      printf("0x%04X %6lu  -\n", ns->node, (unsigned long)ns->count);
+  }
+  return 0;
+}
@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file           : uart_ring_test.c
+  * @brief          : PC unit test for the circular-DMA receive ring (Src/uart_ring.c)
+  ******************************************************************************
+  * A simulated DMA channel writes a known byte pattern into the ring storage
+  * and counts NDTR down as the STM32 does, wrapping in circular mode. The
+  * producer side is called at the half-transfer and transfer-complete
+  * points and at the end of each burst (IDLE), the consumer reads random
+  * amounts in place, and every byte it sees is checked against the pattern
+  * at its stream position. Overruns and DMA restarts must drop bytes, never
+  * hand out stale ones.
+  *
+  * Build on Linux from this directory:
+  *   cc -O2 -I../Inc -o uart_ring_test uart_ring_test.c ../Src/uart_ring.c
+  *
+  * Usage:
+  *   uart_ring_test [iterations] [seed]
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "uart_ring.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RING_SIZE     64
+
+#define CHECK(c)                                                      \
+  do {                                                                \
+    if(!(c))                                                          \
+    {                                                                 \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c);             \
+      failures++;                                                     \
+    }                                                                 \
+  } while(0)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uart_ring_t *r;
+  uint16_t     ndtr;          /* DMA transfers left before the reload       */
+  uint32_t     pos;           /* stream position of the next byte written   */
+} sim_dma_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t storage[RING_SIZE];
+static unsigned failures;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Byte the DMA writes at a stream position. */
+static uint8_t pattern(uint32_t pos)
+{
+  return (uint8_t)(pos * 7u + (pos >> 8));
+}
+
+static void sim_init(sim_dma_t *d, uart_ring_t *r)
+{
+  uart_ring_init(r, storage, RING_SIZE);
+  d->r    = r;
+  d->ndtr = RING_SIZE;
+  d->pos  = 0;
+}
+
+/* Receive n bytes, raising HT/TC on the way and IDLE at the end. */
+static void sim_receive(sim_dma_t *d, uint32_t n)
+{
+  while(n--)
+  {
+    storage[RING_SIZE - d->ndtr] = pattern(d->pos++);
+    if(--d->ndtr == 0)
+      d->ndtr = RING_SIZE;
+    if(d->ndtr == RING_SIZE || d->ndtr == RING_SIZE / 2)
+      uart_ring_dma_update(d->r, d->ndtr);
+  }
+  uart_ring_dma_update(d->r, d->ndtr);
+}
+
+/* UART error: the DMA is restarted at offset 0. */
+static void sim_restart(sim_dma_t *d)
+{
+  uart_ring_dma_restart(d->r);
+  d->ndtr = RING_SIZE;
+  d->pos  = d->r->head;
+}
+
+/* Consume up to n bytes in place; returns the number checked. */
+static uint32_t consume(uart_ring_t *r, uint32_t n)
+{
+  uint32_t done = 0;
+  uint16_t len, i;
+  uint8_t *p;
+
+  while(done < n && (len = uart_ring_peek(r, &p)) != 0)
+  {
+    if(len > n - done)
+      len = (uint16_t)(n - done);
+    for(i = 0; i < len; i++)
+    {
+      if(p[i] != pattern(r->tail + i))
+      {
+        printf("FAIL byte %lu: got 0x%02x want 0x%02x\n",
+               (unsigned long)(r->tail + i), p[i], pattern(r->tail + i));
+        failures++;
+        return done;
+      }
+    }
+    uart_ring_skip(r, len);
+    done += len;
+  }
+  return done;
+}
+
+static void test_wrap(void)
+{
+  uart_ring_t r;
+  sim_dma_t d;
+  uint8_t out[RING_SIZE];
+  uint16_t i, n;
+
+  sim_init(&d, &r);
+  for(i = 0; i < 3 * RING_SIZE / 5; i++)
+  {
+    sim_receive(&d, 5);
+    CHECK(uart_ring_count(&r) == 5);
+    n = uart_ring_read(&r, out, sizeof(out));
+    CHECK(n == 5);
+    CHECK(out[0] == pattern(d.pos - 5) && out[4] == pattern(d.pos - 1));
+  }
+  CHECK(r.overruns == 0);
+}
+
+static void test_full_and_overrun(void)
+{
+  uart_ring_t r;
+  sim_dma_t d;
+
+  /* Exactly one ring of unread bytes is still all valid. */
+  sim_init(&d, &r);
+  sim_receive(&d, 3);
+  consume(&r, 3);
+  sim_receive(&d, RING_SIZE);
+  CHECK(uart_ring_count(&r) == RING_SIZE);
+  CHECK(consume(&r, RING_SIZE) == RING_SIZE);
+  CHECK(r.overruns == 0);
+
+  /* One more and the oldest byte is gone: the ring drops everything. */
+  sim_receive(&d, RING_SIZE + 1);
+  CHECK(uart_ring_count(&r) == 0);
+  CHECK(r.overruns == 1);
+
+  /* Reception goes on from the current position. */
+  sim_receive(&d, 10);
+  CHECK(consume(&r, 100) == 10);
+  CHECK(r.overruns == 1);
+}
+
+static void test_restart(void)
+{
+  uart_ring_t r;
+  sim_dma_t d;
+
+  sim_init(&d, &r);
+  sim_receive(&d, 20);
+  consume(&r, 7);
+  sim_restart(&d);
+  CHECK(uart_ring_count(&r) == 0);
+  CHECK((r.head & (RING_SIZE - 1)) == 0);
+  sim_receive(&d, RING_SIZE / 2 + 3);
+  CHECK(consume(&r, RING_SIZE) == RING_SIZE / 2 + 3);
+  CHECK(r.overruns == 0);
+}
+
+/* Random bursts, reads and restarts; every byte handed out must match. */
+static void test_random(unsigned long iterations)
+{
+  uart_ring_t r;
+  sim_dma_t d;
+  unsigned long i, bytes = 0, restarts = 0;
+
+  sim_init(&d, &r);
+  for(i = 0; i < iterations && failures == 0; i++)
+  {
+    sim_receive(&d, (uint32_t)rand() % (RING_SIZE + RING_SIZE / 2));
+    if(rand() % 64 == 0)
+    {
+      sim_restart(&d);
+      restarts++;
+    }
+    bytes += consume(&r, (uint32_t)rand() % (2 * RING_SIZE));
+    CHECK(uart_ring_count(&r) <= RING_SIZE);
+  }
+  printf("random: %lu iterations, %lu bytes checked, %lu overruns, %lu restarts\n",
+         i, bytes, (unsigned long)r.overruns, restarts);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000;
+
+  srand(argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1);
+
+  test_wrap();
+  test_full_and_overrun();
+  test_restart();
+  test_random(iterations);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -57,6 +57,7 @@
 
 /* HAL */
 #include "hal_drivers.h"
+#include "hal_assert.h"
 
 
 /*********************************************************************
@@ -67,21 +68,43 @@
 
 #define OSAL_MSG_ID(msg_ptr)      ((osal_msg_hdr_t *) (msg_ptr) - 1)->dest_id
 
+// Task 0, the highest priority, is the most significant bit of the ready
+// map, so the number of leading zeros is the index of the task to run.
+#define OSAL_READY_BIT(idx)       ( 0x80000000UL >> (idx) )
+
 /*********************************************************************
  * CONSTANTS
  */
 
+// Most tasks the ready map can hold.
+#define OSAL_READY_MAX            32
+
+// Free-running time base of the task run-time accounting, in 320 usec
+// MAC backoff ticks. A finer counter can be supplied by the project.
+#if ( OSAL_TASK_METRICS ) && !defined ( OSAL_TASK_CLOCK )
+  #define OSAL_TASK_CLOCK()       macMcuPrecisionCount()
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Messages waiting for one task, oldest first. The tail pointer makes a
+// send O(1), and a receive never has to step over other tasks' messages.
+typedef struct
+{
+  void   *head;
+  void   *tail;
+#if ( OSAL_MSG_METRICS )
+  uint16 depth;     // Current number of messages queued.
+  uint16 depthMax;  // Max number of messages ever queued at once.
+#endif
+} osal_task_q_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
-// Message Pool Definitions
-osal_msg_q_t osal_qHead;
-
 #if defined( OSAL_TOTAL_MEM )
   uint16 osal_msg_cnt;
 #endif
@@ -93,14 +116,33 @@ osal_msg_q_t osal_qHead;
 /*********************************************************************
  * EXTERNAL FUNCTIONS
  */
+#if ( OSAL_TASK_METRICS )
+extern uint16 macMcuPrecisionCount(void);
+#endif
 
 /*********************************************************************
  * LOCAL VARIABLES
  */
 
+// Message Pool Definitions, one queue per task
+static osal_task_q_t *osal_taskQ;
+
+// Tasks with events pending, see OSAL_READY_BIT().
+static uint32 osal_readyMap;
+
+// Leading zeros of a nibble.
+static const uint8 CODE osalClzNibble[16] =
+  { 4, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+#if ( OSAL_TASK_METRICS )
+// Run-time accounting, one entry per task.
+static osalTaskStats_t *osal_taskStats;
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
+static uint8 osal_clz32( uint32 x );
 
 /*********************************************************************
  * HELPER FUNCTIONS
@@ -464,6 +506,9 @@ uint16 osal_num_msgs( void )
  */
 uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
 {
+  osal_task_q_t *q;
+  halIntState_t intState;
+
   if ( msg_ptr == NULL )
     return ( INVALID_MSG_POINTER );
 
@@ -483,8 +528,29 @@ uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
 
   OSAL_MSG_ID( msg_ptr ) = destination_task;
 
-  // queue message
-  osal_msg_enqueue( &osal_qHead, msg_ptr );
+  // queue message at the tail of the task's queue
+  q = &osal_taskQ[destination_task];
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
+  if ( q->head == NULL )
+  {
+    q->head = msg_ptr;
+  }
+  else
+  {
+    OSAL_MSG_NEXT( q->tail ) = msg_ptr;
+  }
+  q->tail = msg_ptr;
+
+#if ( OSAL_MSG_METRICS )
+  if ( ++q->depth > q->depthMax )
+  {
+    q->depthMax = q->depth;
+  }
+#endif
+
+  HAL_EXIT_CRITICAL_SECTION(intState);
 
   // Signal the task that a message is waiting
   osal_set_event( destination_task, SYS_EVENT_MSG );
@@ -507,43 +573,79 @@ uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
  */
 uint8 *osal_msg_receive( uint8 task_id )
 {
-  osal_msg_hdr_t *listHdr;
-  osal_msg_hdr_t *prevHdr=0;
+  osal_task_q_t  *q;
+  uint8          *msg_ptr;
   halIntState_t   intState;
 
-  // Hold off interrupts
-  HAL_ENTER_CRITICAL_SECTION(intState);
+  if ( task_id >= tasksCnt )
+    return NULL;
 
-  // Point to the top of the queue
-  listHdr = osal_qHead;
+  q = &osal_taskQ[task_id];
 
-  // Look through the queue for a message that belongs to the asking task
-  while ( listHdr != NULL )
-  {
-    if ( (listHdr - 1)->dest_id == task_id )
-    {
-      break;
-    }
-    prevHdr = listHdr;
-    listHdr = OSAL_MSG_NEXT( listHdr );
-  }
+  // Hold off interrupts
+  HAL_ENTER_CRITICAL_SECTION(intState);
 
-  // Did we find a message?
-  if ( listHdr == NULL )
+  // Only this task's messages are in its queue, take the oldest
+  msg_ptr = q->head;
+  if ( msg_ptr == NULL )
   {
     // Release interrupts
     HAL_EXIT_CRITICAL_SECTION(intState);
     return NULL;
   }
 
-  // Take out of the link list
-  osal_msg_extract( &osal_qHead, listHdr, prevHdr );
+  q->head = OSAL_MSG_NEXT( msg_ptr );
+  if ( q->head == NULL )
+  {
+    q->tail = NULL;
+  }
+#if ( OSAL_MSG_METRICS )
+  q->depth--;
+#endif
 
   // Release interrupts
   HAL_EXIT_CRITICAL_SECTION(intState);
 
-  return ( (uint8*) listHdr );
+  OSAL_MSG_NEXT( msg_ptr ) = NULL;
+  OSAL_MSG_ID( msg_ptr ) = TASK_NO_TASK;
+
+  return ( msg_ptr );
+}
+
+#if ( OSAL_MSG_METRICS )
+/*********************************************************************
+ * @fn      osal_msg_q_depth
+ *
+ * @brief
+ *
+ *    This function returns the number of messages waiting for a task.
+ *
+ * @param   uint8 task_id - task ID
+ *
+ * @return  uint16 - number of msgs queued, 0 for an invalid task
+ */
+uint16 osal_msg_q_depth( uint8 task_id )
+{
+  return ( task_id < tasksCnt ) ? osal_taskQ[task_id].depth : 0;
+}
+
+/*********************************************************************
+ * @fn      osal_msg_q_high_water
+ *
+ * @brief
+ *
+ *    This function returns the most messages ever waiting for a task
+ *    at once.
+ *
+ * @param   uint8 task_id - task ID
+ *
+ * @return  uint16 - max number of msgs queued, 0 for an invalid task
+ */
+uint16 osal_msg_q_high_water( uint8 task_id )
+{
+  return ( task_id < tasksCnt ) ? osal_taskQ[task_id].depthMax : 0;
 }
+#endif
 
 /*********************************************************************
  * @fn      osal_msg_enqueue
@@ -761,6 +863,8 @@ uint8 osal_set_event( uint8 task_id, uint16 event_flag )
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
     tasksEvents[task_id] |= event_flag;  // Stuff the event bit(s)
+    if ( tasksEvents[task_id] )
+      osal_readyMap |= OSAL_READY_BIT( task_id );  // Mark the task ready
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
   }
    else
@@ -866,8 +970,18 @@ uint8 osal_init_system( void )
   // Initialize the Memory Allocation System
   osal_mem_init();
 
-  // Initialize the message queue
-  osal_qHead = NULL;
+  // Initialize the message queues
+  osal_taskQ = (osal_task_q_t *)osal_mem_alloc( sizeof( osal_task_q_t ) * tasksCnt );
+  osal_memset( osal_taskQ, 0, sizeof( osal_task_q_t ) * tasksCnt );
+
+  // Every task needs a bit in the ready map
+  HAL_ASSERT( tasksCnt <= OSAL_READY_MAX );
+  osal_readyMap = 0;
+
+#if ( OSAL_TASK_METRICS )
+  osal_taskStats = (osalTaskStats_t *)osal_mem_alloc( sizeof( osalTaskStats_t ) * tasksCnt );
+  osal_memset( osal_taskStats, 0, sizeof( osalTaskStats_t ) * tasksCnt );
+#endif
 
 #if defined( OSAL_TOTAL_MEM )
   osal_msg_cnt = 0;
@@ -894,11 +1008,14 @@ uint8 osal_init_system( void )
  * @brief
  *
  *   This function is the main loop function of the task system.  It
- *   will look through all task events and call the task_event_processor()
- *   function for the task with the event.  If there are no events (for
+ *   will take the highest priority task from the ready map and call the
+ *   task_event_processor() function for it.  If there are no events (for
  *   all tasks), this function puts the processor into Sleep.
  *   This Function doesn't return.
  *
+ *   The clock and the HAL are still polled on every pass: the timers
+ *   and the UART only learn that time has passed from these calls.
+ *
  * @param   void
  *
  * @return  none
@@ -909,33 +1026,52 @@ void osal_start_system( void )
   for(;;)  // Forever Loop
 #endif
   {
-    uint8 idx = 0;
-    
+    uint8 idx = tasksCnt;
+    uint16 events;
+    halIntState_t intState;
+#if ( OSAL_TASK_METRICS )
+    uint16 taken;
+    uint16 start;
+#endif
+
     osalTimeUpdate();
     
     Hal_ProcessPoll();  // This replaces MT_SerialPoll() and osal_check_timer().
 
-    do {
-      if (tasksEvents[idx])  // Task is highest priority that is ready.
-      {
-        break;
-      }
-    } while (++idx < tasksCnt);
-
-    if (idx < tasksCnt)
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    if ( osal_readyMap )
     {
-      uint16 events;
-      halIntState_t intState;
-
-      HAL_ENTER_CRITICAL_SECTION(intState);
+      idx = osal_clz32( osal_readyMap );  // Task is highest priority that is ready.
+      osal_readyMap &= ~OSAL_READY_BIT( idx );
       events = tasksEvents[idx];
       tasksEvents[idx] = 0;  // Clear the Events for this task.
-      HAL_EXIT_CRITICAL_SECTION(intState);
+    }
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    if (idx < tasksCnt)
+    {
+#if ( OSAL_TASK_METRICS )
+      taken = events;
+      start = OSAL_TASK_CLOCK();
+#endif
 
       events = (tasksArr[idx])( idx, events );
 
+#if ( OSAL_TASK_METRICS )
+      start = OSAL_TASK_CLOCK() - start;
+      osal_taskStats[idx].runs++;
+      osal_taskStats[idx].ticks += start;
+      if ( start >= osal_taskStats[idx].maxTicks )
+      {
+        osal_taskStats[idx].maxTicks = start;
+        osal_taskStats[idx].maxEvents = taken;
+      }
+#endif
+
       HAL_ENTER_CRITICAL_SECTION(intState);
       tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
+      if ( tasksEvents[idx] )
+        osal_readyMap |= OSAL_READY_BIT( idx );
       HAL_EXIT_CRITICAL_SECTION(intState);
     }
 #if defined( POWER_SAVING )
@@ -947,6 +1083,66 @@ void osal_start_system( void )
   }
 }
 
+/*********************************************************************
+ * @fn      osal_clz32
+ *
+ * @brief
+ *
+ *   Count the leading zeros of a word a byte, then a nibble, at a time;
+ *   the 8051 has no instruction for it.
+ *
+ * @param   x - word, not 0
+ *
+ * @return  number of leading zero bits
+ */
+static uint8 osal_clz32( uint32 x )
+{
+  uint8 n = 0;
+  uint8 i = 3;
+  uint8 b;
+
+  while ( (b = BREAK_UINT32( x, i )) == 0 )
+  {
+    n += 8;
+    i--;
+  }
+
+  if ( b & 0xF0 )
+    return ( n + osalClzNibble[b >> 4] );
+  else
+    return ( n + 4 + osalClzNibble[b] );
+}
+
+#if ( OSAL_TASK_METRICS )
+/*********************************************************************
+ * @fn      osal_task_stats
+ *
+ * @brief
+ *
+ *   This function copies the run-time accounting of a task, e.g. to find
+ *   the event handler behind a latency spike.
+ *
+ * @param   uint8 task_id - task ID
+ * @param   osalTaskStats_t *stats - copy of the accounting
+ * @param   uint8 reset - TRUE to start counting again
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *stats, uint8 reset )
+{
+  if ( task_id >= tasksCnt )
+    return ( INVALID_TASK );
+
+  osal_memcpy( stats, &osal_taskStats[task_id], sizeof( osalTaskStats_t ) );
+  if ( reset )
+  {
+    osal_memset( &osal_taskStats[task_id], 0, sizeof( osalTaskStats_t ) );
+  }
+
+  return ( SUCCESS );
+}
+#endif
+
 /*********************************************************************
  * @fn      osal_buffer_uint32
  *
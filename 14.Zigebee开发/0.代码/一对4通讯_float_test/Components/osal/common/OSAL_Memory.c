@@ -76,6 +76,37 @@
   #define OSALMEM_REIN   'F'
 #endif
 
+/* Block size and count of each size class, smallest first. The defaults
+ * fit OSAL messages with a short body, ZCL parse buffers and short incoming
+ * AF packets, 544 bytes in all, sized for the 3 KB heap of a coordinator
+ * or router; an end device that enables the pools on its 2 KB heap should
+ * lower the counts to what osal_mem_slab_stats() shows it uses. The pools
+ * are carved out of the heap by osal_mem_init(); a class with a count of 0
+ * leaves its sizes to the heap. A block must be able to hold a pointer.
+ */
+#if ( OSALMEM_SLABS )
+  #if !defined ( OSALMEM_SLAB0_BLKSZ )
+    #define OSALMEM_SLAB0_BLKSZ  16
+  #endif
+  #if !defined ( OSALMEM_SLAB0_CNT )
+    #define OSALMEM_SLAB0_CNT    8
+  #endif
+
+  #if !defined ( OSALMEM_SLAB1_BLKSZ )
+    #define OSALMEM_SLAB1_BLKSZ  32
+  #endif
+  #if !defined ( OSALMEM_SLAB1_CNT )
+    #define OSALMEM_SLAB1_CNT    4
+  #endif
+
+  #if !defined ( OSALMEM_SLAB2_BLKSZ )
+    #define OSALMEM_SLAB2_BLKSZ  96
+  #endif
+  #if !defined ( OSALMEM_SLAB2_CNT )
+    #define OSALMEM_SLAB2_CNT    3
+  #endif
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -97,6 +128,10 @@
   #define OSALMEM_DEBUG( statement)    st( statement )
 #endif
 
+// Round a size-class block up so that every block stays aligned.
+#define OSALMEM_SLAB_ALIGN( sz ) \
+  ( (((sz) + sizeof( halDataAlign_t ) - 1) / sizeof( halDataAlign_t )) * sizeof( halDataAlign_t ) )
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -161,6 +196,26 @@ static osalMemHdr_t *ff2;  // First free block after the small-block bucket.
   static uint16 proSmallBlkMiss;
 #endif
 
+#if ( OSALMEM_SLABS )
+  static const uint16 CODE slabBlkSz[OSALMEM_SLAB_CNT] = {
+    OSALMEM_SLAB_ALIGN( OSALMEM_SLAB0_BLKSZ ),
+    OSALMEM_SLAB_ALIGN( OSALMEM_SLAB1_BLKSZ ),
+    OSALMEM_SLAB_ALIGN( OSALMEM_SLAB2_BLKSZ ) };
+  static const uint8 CODE slabBlkCnt[OSALMEM_SLAB_CNT] = {
+    OSALMEM_SLAB0_CNT, OSALMEM_SLAB1_CNT, OSALMEM_SLAB2_CNT };
+
+  static uint8 *slabBeg;                    // First block of the pools.
+  static uint8 *slabEnd[OSALMEM_SLAB_CNT];  // End of each pool.
+  static void *slabFree[OSALMEM_SLAB_CNT];  // First free block of each pool.
+
+  #if ( OSALMEM_METRICS )
+    static uint8  slabUse[OSALMEM_SLAB_CNT];   // Current cnt of blocks in use.
+    static uint8  slabMax[OSALMEM_SLAB_CNT];   // Max cnt ever in use at once.
+    static uint16 slabHit[OSALMEM_SLAB_CNT];   // Allocations from the pool.
+    static uint16 slabMiss[OSALMEM_SLAB_CNT];  // Allocations left to the heap.
+  #endif
+#endif
+
 // Memory Allocation Heap.
 #if defined( EXTERNAL_RAM )
   static byte *theHeap = (byte *)EXT_RAM_BEG;
@@ -173,6 +228,12 @@ static osalMemHdr_t *ff2;  // First free block after the small-block bucket.
  * LOCAL FUNCTIONS
  */
 
+#if ( OSALMEM_SLABS )
+static void osalMemSlabInit( void );
+static void *osalMemSlabAlloc( uint16 size );
+static void osalMemSlabFree( void *ptr );
+#endif
+
 /*********************************************************************
  * @fn      osal_mem_init
  *
@@ -214,6 +275,10 @@ void osal_mem_init( void )
    */
   blkCnt = blkFree = 2;
 #endif
+
+#if ( OSALMEM_SLABS )
+  osalMemSlabInit();
+#endif
 }
 
 /*********************************************************************
@@ -260,6 +325,15 @@ void *osal_mem_alloc( uint16 size )
 
   OSALMEM_ASSERT( size );
 
+#if ( OSALMEM_SLABS )
+  // The hot fixed sizes come from their pool as long as it has a block.
+  hdr = osalMemSlabAlloc( size );
+  if ( hdr != NULL )
+  {
+    return (void *)hdr;
+  }
+#endif
+
   size += HDRSZ;
 
   // Calculate required bytes to add to 'size' to align to halDataAlign_t.
@@ -437,6 +511,15 @@ void osal_mem_free( void *ptr )
   osalMemHdr_t *currHdr;
   halIntState_t intState;
 
+#if ( OSALMEM_SLABS )
+  // A block of a size-class pool goes back to its pool.
+  if ( ((uint8 *)ptr >= slabBeg) && ((uint8 *)ptr < slabEnd[OSALMEM_SLAB_CNT - 1]) )
+  {
+    osalMemSlabFree( ptr );
+    return;
+  }
+#endif
+
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   OSALMEM_ASSERT( ptr );
@@ -482,6 +565,166 @@ void osal_mem_free( void *ptr )
   HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
 }
 
+#if ( OSALMEM_SLABS )
+/*********************************************************************
+ * @fn      osalMemSlabInit
+ *
+ * @brief   Carve the size-class pools out of the heap as one long-lived
+ *          block and chain the blocks of each pool into its free list.
+ *          If the heap is too small, every allocation goes to the heap.
+ *
+ * @param   void
+ *
+ * @return  void
+ */
+static void osalMemSlabInit( void )
+{
+  uint16 total = 0;
+  uint8 *blk;
+  uint8 cls;
+  uint8 cnt;
+#if ( OSALMEM_METRICS )
+  uint16 alo = memAlo;
+#endif
+
+  // The heap was just reset; so are the pools.
+  slabBeg = NULL;
+  for ( cls = 0; cls < OSALMEM_SLAB_CNT; cls++ )
+  {
+    slabFree[cls] = NULL;
+    slabEnd[cls] = NULL;
+    total += slabBlkSz[cls] * slabBlkCnt[cls];
+  }
+
+  if ( total == 0 )
+  {
+    return;
+  }
+
+  blk = osal_mem_alloc( total );
+  if ( blk == NULL )
+  {
+    return;
+  }
+  slabBeg = blk;
+
+  for ( cls = 0; cls < OSALMEM_SLAB_CNT; cls++ )
+  {
+    for ( cnt = slabBlkCnt[cls]; cnt != 0; cnt-- )
+    {
+      *(void **)blk = slabFree[cls];
+      slabFree[cls] = blk;
+      blk += slabBlkSz[cls];
+    }
+    slabEnd[cls] = blk;
+
+#if ( OSALMEM_METRICS )
+    slabUse[cls] = slabMax[cls] = 0;
+    slabHit[cls] = slabMiss[cls] = 0;
+#endif
+  }
+
+#if ( OSALMEM_METRICS )
+  // Count the blocks in use, not the pools.
+  memAlo = memMax = alo;
+#endif
+}
+
+/*********************************************************************
+ * @fn      osalMemSlabAlloc
+ *
+ * @brief   Take a block from the smallest size class that fits.
+ *
+ * @param   size - number of bytes to allocate.
+ *
+ * @return  void * - pointer to the block; NULL if no class fits or the
+ *          pool of the class is empty.
+ */
+static void *osalMemSlabAlloc( uint16 size )
+{
+  halIntState_t intState;
+  void *blk;
+  uint8 cls;
+
+  for ( cls = 0; cls < OSALMEM_SLAB_CNT; cls++ )
+  {
+    if ( size <= slabBlkSz[cls] )
+    {
+      break;
+    }
+  }
+
+  if ( cls == OSALMEM_SLAB_CNT )
+  {
+    return NULL;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  blk = slabFree[cls];
+  if ( blk != NULL )
+  {
+    slabFree[cls] = *(void **)blk;
+
+#if ( OSALMEM_METRICS )
+    slabHit[cls]++;
+    if ( slabMax[cls] < ++slabUse[cls] )
+    {
+      slabMax[cls] = slabUse[cls];
+    }
+
+    memAlo += slabBlkSz[cls];
+    if ( memMax < memAlo )
+    {
+      memMax = memAlo;
+    }
+#endif
+  }
+#if ( OSALMEM_METRICS )
+  else
+  {
+    slabMiss[cls]++;
+  }
+#endif
+
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return blk;
+}
+
+/*********************************************************************
+ * @fn      osalMemSlabFree
+ *
+ * @brief   Return a block to the pool it lies in.
+ *
+ * @param   ptr - pointer to a block of the size-class pools.
+ *
+ * @return  void
+ */
+static void osalMemSlabFree( void *ptr )
+{
+  halIntState_t intState;
+  uint8 cls = 0;
+
+  while ( (uint8 *)ptr >= slabEnd[cls] )
+  {
+    cls++;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  *(void **)ptr = slabFree[cls];
+  slabFree[cls] = ptr;
+
+#if ( OSALMEM_METRICS )
+  slabUse[cls]--;
+  memAlo -= slabBlkSz[cls];
+#endif
+
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+}
+#endif
+
 #if ( OSALMEM_METRICS )
 /*********************************************************************
  * @fn      osal_heap_block_max
@@ -528,7 +771,8 @@ uint16 osal_heap_block_free( void )
 /*********************************************************************
  * @fn      osal_heap_mem_used
  *
- * @brief   Return the current number of bytes allocated.
+ * @brief   Return the current number of bytes allocated, counting the
+ *          blocks in use in the size-class pools rather than the pools.
  *
  * @param   none
  *
@@ -540,6 +784,42 @@ uint16 osal_heap_mem_used( void )
 }
 #endif
 
+#if ( OSALMEM_SLABS ) && ( OSALMEM_METRICS )
+/*********************************************************************
+ * @fn      osal_mem_slab_stats
+ *
+ * @brief   Return the usage of a size-class pool. A high miss count
+ *          next to a full pool says the class wants more blocks.
+ *
+ * @param   cls - size class, 0 to OSALMEM_SLAB_CNT - 1.
+ * @param   stats - returns the usage.
+ *
+ * @return  SUCCESS, INVALIDPARAMETER
+ */
+uint8 osal_mem_slab_stats( uint8 cls, osalMemSlabStats_t *stats )
+{
+  halIntState_t intState;
+
+  if ( cls >= OSALMEM_SLAB_CNT )
+  {
+    return INVALIDPARAMETER;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  stats->blkSz = slabBlkSz[cls];
+  stats->blkCnt = (slabBeg != NULL) ? slabBlkCnt[cls] : 0;
+  stats->blkUse = slabUse[cls];
+  stats->blkMax = slabMax[cls];
+  stats->hit = slabHit[cls];
+  stats->miss = slabMiss[cls];
+
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return SUCCESS;
+}
+#endif
+
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
 /*********************************************************************
  * @fn      osal_heap_high_water
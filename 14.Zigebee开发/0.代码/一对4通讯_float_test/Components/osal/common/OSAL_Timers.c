@@ -51,28 +51,94 @@
  * MACROS
  */
 
+// Lookup bucket of a task/event pair.
+#define OSAL_TIMER_BUCKET( task_id, event_flag ) \
+  ( ((task_id) ^ LO_UINT16( event_flag ) ^ HI_UINT16( event_flag )) & (OSAL_TIMER_HASH - 1) )
+
 /*********************************************************************
  * CONSTANTS
  */
 
+// Timer records are preallocated; a start fails with NO_TIMER_AVAIL when
+// they are all in use. A record takes 11 bytes, 14 with 16-bit links.
+//
+// Timers that can run at once in the SerialApp images, counted from the
+// sources: SerialApp 5 in either role, the HAL 2 (key poll, LED blink),
+// ZDApp and ZDSecMgr 5, ZDNwkMgr 4; 16 in all. The NWK and APS libraries
+// come without source, so 24 leaves them 8. Build with OSAL_TIMER_METRICS
+// and read osal_timer_high_water() on the target to check the margin.
+#if !defined ( OSAL_TIMER_POOL )
+  #define OSAL_TIMER_POOL  24
+#endif
+
+#if ( OSAL_TIMER_POOL > 0xFFFE )
+  #error OSAL_TIMER_POOL is too big for 16-bit timer links!
+#endif
+
+// Buckets of the task/event lookup, a power of 2.
+#if !defined ( OSAL_TIMER_HASH )
+  #define OSAL_TIMER_HASH  16
+#endif
+
+// Records are linked by index; pools of up to 254 records use 8-bit
+// links to save RAM.
+#if ( OSAL_TIMER_POOL < 0xFF )
+  #define OSAL_TIMER_NONE  0xFF
+#else
+  #define OSAL_TIMER_NONE  0xFFFF
+#endif
+
+// Slot of a free record.
+#define OSAL_TIMER_FREE    0xFF
+
+/* Timing wheel: 32 slots of 1 msec, 32 slots of 32 msec and 64 slots of
+ * 1024 msec cover the whole 16-bit timeout range. A record sits in the
+ * slot of its expiry time on the lowest level that reaches it and moves
+ * down a level when the wheel below wraps around to it.
+ */
+#define OSAL_TIMER_L0_BITS   5
+#define OSAL_TIMER_L1_BITS   5
+#define OSAL_TIMER_L2_BITS   6
+
+#define OSAL_TIMER_L0_SLOTS  ( 1 << OSAL_TIMER_L0_BITS )
+#define OSAL_TIMER_L1_SLOTS  ( 1 << OSAL_TIMER_L1_BITS )
+#define OSAL_TIMER_L2_SLOTS  ( 1 << OSAL_TIMER_L2_BITS )
+
+#define OSAL_TIMER_L1_SHIFT  OSAL_TIMER_L0_BITS
+#define OSAL_TIMER_L2_SHIFT  ( OSAL_TIMER_L0_BITS + OSAL_TIMER_L1_BITS )
+
+// Index of the first slot of each level in osalTimerWheel[].
+#define OSAL_TIMER_L0        0
+#define OSAL_TIMER_L1        ( OSAL_TIMER_L0 + OSAL_TIMER_L0_SLOTS )
+#define OSAL_TIMER_L2        ( OSAL_TIMER_L1 + OSAL_TIMER_L1_SLOTS )
+#define OSAL_TIMER_SLOTS     ( OSAL_TIMER_L2 + OSAL_TIMER_L2_SLOTS )
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Index of a timer record, OSAL_TIMER_NONE for none.
+#if ( OSAL_TIMER_POOL < 0xFF )
+typedef uint8 osalTimerIdx_t;
+#else
+typedef uint16 osalTimerIdx_t;
+#endif
+
 typedef struct
 {
-  void *next;
-  uint16 timeout;
+  uint32 expire;      // osal_systemClock at which the timer expires
   uint16 event_flag;
   uint8 task_id;
+  uint8 slot;         // wheel slot, OSAL_TIMER_FREE if the record is free
+  osalTimerIdx_t next;  // next and previous record in the slot, or the
+  osalTimerIdx_t prev;  // next free record
+  osalTimerIdx_t hnext; // next record in the lookup bucket
 } osalTimerRec_t;
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
-osalTimerRec_t *timerHead;
-
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -87,12 +153,29 @@ osalTimerRec_t *timerHead;
 // Milliseconds since last reboot
 static uint32 osal_systemClock;
 
+static osalTimerRec_t osalTimerPool[OSAL_TIMER_POOL];
+static osalTimerIdx_t osalTimerFree;                    // First free record.
+static osalTimerIdx_t osalTimerActive;                  // Records in use.
+#if ( OSAL_TIMER_METRICS )
+static osalTimerIdx_t osalTimerHigh;                    // Most records in use.
+#endif
+static osalTimerIdx_t osalTimerWheel[OSAL_TIMER_SLOTS]; // First record of each slot.
+static osalTimerIdx_t osalTimerHash[OSAL_TIMER_HASH];   // First record of each bucket.
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
-osalTimerRec_t  *osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout );
-osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag );
-void osalDeleteTimer( osalTimerRec_t *rmTimer );
+osalTimerIdx_t osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout );
+osalTimerIdx_t osalFindTimer( uint8 task_id, uint16 event_flag );
+void osalDeleteTimer( osalTimerIdx_t rmTimer );
+
+static void osalTimerLink( osalTimerIdx_t idx );
+static void osalTimerUnlink( osalTimerIdx_t idx );
+static void osalTimerCascade( uint8 slot );
+static void osalTimerRehash( void );
+#ifdef POWER_SAVING
+static uint16 osalTimerFirst( uint8 base, uint8 slots, uint8 shift );
+#endif
 
 /*********************************************************************
  * FUNCTIONS
@@ -109,124 +192,275 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer );
  */
 void osalTimerInit( void )
 {
+  osalTimerIdx_t idx;
+
   osal_systemClock = 0;
+
+  // Every link OSAL_TIMER_NONE, whatever its width
+  osal_memset( osalTimerWheel, 0xFF, sizeof( osalTimerWheel ) );
+  osal_memset( osalTimerHash, 0xFF, sizeof( osalTimerHash ) );
+
+  // Chain all records into the free list
+  for ( idx = 0; idx < OSAL_TIMER_POOL; idx++ )
+  {
+    osalTimerPool[idx].slot = OSAL_TIMER_FREE;
+    osalTimerPool[idx].next = idx + 1;
+  }
+  osalTimerPool[OSAL_TIMER_POOL - 1].next = OSAL_TIMER_NONE;
+  osalTimerFree = 0;
+  osalTimerActive = 0;
+#if ( OSAL_TIMER_METRICS )
+  osalTimerHigh = 0;
+#endif
 }
 
 /*********************************************************************
  * @fn      osalAddTimer
  *
- * @brief   Add a timer to the timer list.
+ * @brief   Add a timer to the timing wheel, or restart it if it is
+ *          already running.
  *          Ints must be disabled.
  *
  * @param   task_id
  * @param   event_flag
  * @param   timeout
  *
- * @return  osalTimerRec_t * - pointer to newly created timer
+ * @return  index of the timer record, OSAL_TIMER_NONE if none is free
  */
-osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout )
+osalTimerIdx_t osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout )
 {
   osalTimerRec_t *newTimer;
-  osalTimerRec_t *srchTimer;
+  osalTimerIdx_t idx;
+  uint8 bucket;
 
   // Look for an existing timer first
-  newTimer = osalFindTimer( task_id, event_flag );
-  if ( newTimer )
+  idx = osalFindTimer( task_id, event_flag );
+  if ( idx != OSAL_TIMER_NONE )
   {
-    // Timer is found - update it.
-    newTimer->timeout = timeout;
-
-    return ( newTimer );
+    // Timer is found - take it out of its slot to update it.
+    osalTimerUnlink( idx );
   }
   else
   {
     // New Timer
-    newTimer = osal_mem_alloc( sizeof( osalTimerRec_t ) );
-
-    if ( newTimer )
-    {
-      // Fill in new timer
-      newTimer->task_id = task_id;
-      newTimer->event_flag = event_flag;
-      newTimer->timeout = timeout;
-      newTimer->next = (void *)NULL;
-
-      // Does the timer list already exist
-      if ( timerHead == NULL )
-      {
-        // Start task list
-        timerHead = newTimer;
-      }
-      else
-      {
-        // Add it to the end of the timer list
-        srchTimer = timerHead;
-
-        // Stop at the last record
-        while ( srchTimer->next )
-          srchTimer = srchTimer->next;
+    idx = osalTimerFree;
+    if ( idx == OSAL_TIMER_NONE )
+      return ( OSAL_TIMER_NONE );
+
+    newTimer = &osalTimerPool[idx];
+    osalTimerFree = newTimer->next;
+    osalTimerActive++;
+#if ( OSAL_TIMER_METRICS )
+    if ( osalTimerActive > osalTimerHigh )
+      osalTimerHigh = osalTimerActive;
+#endif
+
+    // Fill in new timer
+    newTimer->task_id = task_id;
+    newTimer->event_flag = event_flag;
+
+    bucket = OSAL_TIMER_BUCKET( task_id, event_flag );
+    newTimer->hnext = osalTimerHash[bucket];
+    osalTimerHash[bucket] = idx;
+  }
 
-        // Add to the list
-        srchTimer->next = newTimer;
-      }
+  // A timeout of 0 goes into the slot of the current tick and expires on
+  // the next update.
+  osalTimerPool[idx].expire = osal_systemClock + timeout;
+  osalTimerLink( idx );
 
-      return ( newTimer );
-    }
-    else
-      return ( (osalTimerRec_t *)NULL );
-  }
+  return ( idx );
 }
 
 /*********************************************************************
  * @fn      osalFindTimer
  *
- * @brief   Find a timer in a timer list.
+ * @brief   Find a timer in the lookup bucket of its task and event.
  *          Ints must be disabled.
  *
  * @param   task_id
  * @param   event_flag
  *
- * @return  osalTimerRec_t *
+ * @return  index of the timer record, OSAL_TIMER_NONE if not running
  */
-osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
+osalTimerIdx_t osalFindTimer( uint8 task_id, uint16 event_flag )
 {
-  osalTimerRec_t *srchTimer;
+  osalTimerIdx_t idx;
 
-  // Head of the timer list
-  srchTimer = timerHead;
+  // Head of the bucket
+  idx = osalTimerHash[OSAL_TIMER_BUCKET( task_id, event_flag )];
 
   // Stop when found or at the end
-  while ( srchTimer )
+  while ( idx != OSAL_TIMER_NONE )
   {
-    if ( srchTimer->event_flag == event_flag &&
-         srchTimer->task_id == task_id )
+    if ( osalTimerPool[idx].event_flag == event_flag &&
+         osalTimerPool[idx].task_id == task_id )
       break;
 
     // Not this one, check another
-    srchTimer = srchTimer->next;
+    idx = osalTimerPool[idx].hnext;
   }
 
-  return ( srchTimer );
+  return ( idx );
 }
 
 /*********************************************************************
  * @fn      osalDeleteTimer
  *
- * @brief   Delete a timer from a timer list.
+ * @brief   Take a timer out of the wheel and its lookup bucket and
+ *          return the record to the free list.
+ *          Ints must be disabled.
+ *
+ * @param   rmTimer - index of the timer record
+ *
+ * @return  none
+ */
+void osalDeleteTimer( osalTimerIdx_t rmTimer )
+{
+  osalTimerRec_t *tmr = &osalTimerPool[rmTimer];
+  osalTimerIdx_t *link;
+
+  osalTimerUnlink( rmTimer );
+
+  // Unchain from the lookup bucket
+  link = &osalTimerHash[OSAL_TIMER_BUCKET( tmr->task_id, tmr->event_flag )];
+  while ( *link != rmTimer )
+  {
+    link = &osalTimerPool[*link].hnext;
+  }
+  *link = tmr->hnext;
+
+  tmr->slot = OSAL_TIMER_FREE;
+  tmr->next = osalTimerFree;
+  osalTimerFree = rmTimer;
+  osalTimerActive--;
+}
+
+/*********************************************************************
+ * @fn      osalTimerLink
+ *
+ * @brief   Put a record into the slot of its expiry time, on the lowest
+ *          level that reaches that far. A record already due goes into
+ *          the slot of the current tick.
+ *          Ints must be disabled.
+ *
+ * @param   idx - index of the timer record
+ *
+ * @return  none
+ */
+static void osalTimerLink( osalTimerIdx_t idx )
+{
+  osalTimerRec_t *tmr = &osalTimerPool[idx];
+  int32 delta = (int32)( tmr->expire - osal_systemClock );
+  uint8 slot;
+
+  if ( delta <= 0 )
+  {
+    slot = OSAL_TIMER_L0 + (uint8)( osal_systemClock & (OSAL_TIMER_L0_SLOTS - 1) );
+  }
+  else if ( delta < OSAL_TIMER_L0_SLOTS )
+  {
+    slot = OSAL_TIMER_L0 + (uint8)( tmr->expire & (OSAL_TIMER_L0_SLOTS - 1) );
+  }
+  else if ( delta < ((int32)OSAL_TIMER_L1_SLOTS << OSAL_TIMER_L1_SHIFT) )
+  {
+    slot = OSAL_TIMER_L1 +
+           (uint8)( (tmr->expire >> OSAL_TIMER_L1_SHIFT) & (OSAL_TIMER_L1_SLOTS - 1) );
+  }
+  else
+  {
+    slot = OSAL_TIMER_L2 +
+           (uint8)( (tmr->expire >> OSAL_TIMER_L2_SHIFT) & (OSAL_TIMER_L2_SLOTS - 1) );
+  }
+
+  tmr->slot = slot;
+  tmr->prev = OSAL_TIMER_NONE;
+  tmr->next = osalTimerWheel[slot];
+  if ( tmr->next != OSAL_TIMER_NONE )
+  {
+    osalTimerPool[tmr->next].prev = idx;
+  }
+  osalTimerWheel[slot] = idx;
+}
+
+/*********************************************************************
+ * @fn      osalTimerUnlink
+ *
+ * @brief   Take a record out of its slot.
+ *          Ints must be disabled.
  *
- * @param   table
- * @param   rmTimer
+ * @param   idx - index of the timer record
  *
  * @return  none
  */
-void osalDeleteTimer( osalTimerRec_t *rmTimer )
+static void osalTimerUnlink( osalTimerIdx_t idx )
 {
-  // Does the timer list really exist
-  if ( rmTimer )
+  osalTimerRec_t *tmr = &osalTimerPool[idx];
+
+  if ( tmr->prev == OSAL_TIMER_NONE )
+  {
+    osalTimerWheel[tmr->slot] = tmr->next;
+  }
+  else
   {
-    // Clear the event flag and osalTimerUpdate() will delete 
-    // the timer from the list.
-    rmTimer->event_flag = 0;
+    osalTimerPool[tmr->prev].next = tmr->next;
+  }
+
+  if ( tmr->next != OSAL_TIMER_NONE )
+  {
+    osalTimerPool[tmr->next].prev = tmr->prev;
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerCascade
+ *
+ * @brief   The wheel below has come round to a slot of a higher level:
+ *          move its records down to where they expire now.
+ *          Ints must be disabled.
+ *
+ * @param   slot - slot of level 1 or 2
+ *
+ * @return  none
+ */
+static void osalTimerCascade( uint8 slot )
+{
+  osalTimerIdx_t idx = osalTimerWheel[slot];
+  osalTimerIdx_t next;
+
+  osalTimerWheel[slot] = OSAL_TIMER_NONE;
+
+  while ( idx != OSAL_TIMER_NONE )
+  {
+    next = osalTimerPool[idx].next;
+    osalTimerLink( idx );
+    idx = next;
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerRehash
+ *
+ * @brief   Put every record back in the wheel after the clock jumped
+ *          further than the first level reaches, e.g. after sleep.
+ *          Ints must be disabled.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void osalTimerRehash( void )
+{
+  osalTimerIdx_t idx;
+
+  osal_memset( osalTimerWheel, 0xFF, sizeof( osalTimerWheel ) );
+
+  for ( idx = 0; idx < OSAL_TIMER_POOL; idx++ )
+  {
+    if ( osalTimerPool[idx].slot != OSAL_TIMER_FREE )
+    {
+      osalTimerLink( idx );
+    }
   }
 }
 
@@ -247,7 +481,7 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer )
 uint8 osal_start_timerEx( uint8 taskID, uint16 event_id, uint16 timeout_value )
 {
   halIntState_t intState;
-  osalTimerRec_t *newTimer;
+  osalTimerIdx_t newTimer;
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
@@ -256,7 +490,7 @@ uint8 osal_start_timerEx( uint8 taskID, uint16 event_id, uint16 timeout_value )
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-  return ( (newTimer != NULL) ? SUCCESS : NO_TIMER_AVAIL );
+  return ( (newTimer != OSAL_TIMER_NONE) ? SUCCESS : NO_TIMER_AVAIL );
 }
 
 /*********************************************************************
@@ -276,20 +510,20 @@ uint8 osal_start_timerEx( uint8 taskID, uint16 event_id, uint16 timeout_value )
 uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
 {
   halIntState_t intState;
-  osalTimerRec_t *foundTimer;
+  osalTimerIdx_t foundTimer;
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   // Find the timer to stop
   foundTimer = osalFindTimer( task_id, event_id );
-  if ( foundTimer )
+  if ( foundTimer != OSAL_TIMER_NONE )
   {
     osalDeleteTimer( foundTimer );
   }
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-  return ( (foundTimer != NULL) ? SUCCESS : INVALID_EVENT_ID );
+  return ( (foundTimer != OSAL_TIMER_NONE) ? SUCCESS : INVALID_EVENT_ID );
 }
 
 /*********************************************************************
@@ -306,15 +540,15 @@ uint16 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
 {
   halIntState_t intState;
   uint16 rtrn = 0;
-  osalTimerRec_t *tmr;
+  osalTimerIdx_t tmr;
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   tmr = osalFindTimer( task_id, event_id );
 
-  if ( tmr )
+  if ( tmr != OSAL_TIMER_NONE )
   {
-    rtrn = tmr->timeout;
+    rtrn = (uint16)( osalTimerPool[tmr].expire - osal_systemClock );
   }
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
@@ -329,36 +563,39 @@ uint16 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
  *
  *   This function counts the number of active timers.
  *
- * @return  uint8 - number of timers
+ * @return  uint16 - number of timers
  */
-uint8 osal_timer_num_active( void )
+uint16 osal_timer_num_active( void )
 {
-  halIntState_t intState;
-  uint8 num_timers = 0;
-  osalTimerRec_t *srchTimer;
-
-  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-
-  // Head of the timer list
-  srchTimer = timerHead;
-
-  // Count timers in the list
-  while ( srchTimer != NULL )
-  {
-    num_timers++;
-    srchTimer = srchTimer->next;
-  }
-
-  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+  return osalTimerActive;
+}
 
-  return num_timers;
+#if ( OSAL_TIMER_METRICS )
+/*********************************************************************
+ * @fn      osal_timer_high_water
+ *
+ * @brief
+ *
+ *   This function returns the most timers ever active at once since
+ *   osalTimerInit(), to size OSAL_TIMER_POOL against.
+ *
+ * @return  uint16 - number of timers
+ */
+uint16 osal_timer_high_water( void )
+{
+  return osalTimerHigh;
 }
+#endif
 
 /*********************************************************************
  * @fn      osalTimerUpdate
  *
  * @brief   Update the timer structures for a timer tick.
  *
+ *          The wheel steps one slot per msec, so only the records that
+ *          expire, or move down a level, are touched. A longer update
+ *          relinks every record once instead.
+ *
  * @param   none
  *
  * @return  none
@@ -366,70 +603,70 @@ uint8 osal_timer_num_active( void )
 void osalTimerUpdate( uint16 updateTime )
 {
   halIntState_t intState;
-  osalTimerRec_t *srchTimer;
-  osalTimerRec_t *prevTimer;
+  uint8 slot;
+  osalTimerIdx_t idx;
+  uint8 task_id;
+  uint16 event_flag;
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-  // Update the system time
-  osal_systemClock += updateTime;
+  if ( osalTimerActive == 0 || updateTime >= OSAL_TIMER_L0_SLOTS )
+  {
+    // Update the system time, the records that are due now go into the
+    // slot of this tick.
+    osal_systemClock += updateTime;
+    if ( osalTimerActive != 0 )
+    {
+      osalTimerRehash();
+    }
+    updateTime = 0;
+  }
+  slot = OSAL_TIMER_L0 + (uint8)( osal_systemClock & (OSAL_TIMER_L0_SLOTS - 1) );
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-  // Look for open timer slot
-  if ( timerHead != NULL )
+  for ( ;; )
   {
-    // Add it to the end of the timer list
-    srchTimer = timerHead;
-    prevTimer = (void *)NULL;
-
-    // Look for open timer slot
-    while ( srchTimer )
+    // Every record in the slot of this tick has timed out
+    for ( ;; )
     {
-      osalTimerRec_t *freeTimer = NULL;
-     
       HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-      
-      if (srchTimer->timeout <= updateTime)
+      idx = osalTimerWheel[slot];
+      if ( idx != OSAL_TIMER_NONE )
       {
-        srchTimer->timeout = 0;
+        task_id = osalTimerPool[idx].task_id;
+        event_flag = osalTimerPool[idx].event_flag;
+        osalDeleteTimer( idx );
       }
-      else
-      {
-        srchTimer->timeout = srchTimer->timeout - updateTime;
-      }
-      
-      // When timeout or delete (event_flag == 0)
-      if ( srchTimer->timeout == 0 || srchTimer->event_flag == 0 )
-      {
-        // Take out of list
-        if ( prevTimer == NULL )
-          timerHead = srchTimer->next;
-        else
-          prevTimer->next = srchTimer->next;
+      HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-        // Setup to free memory
-        freeTimer = srchTimer;
+      if ( idx == OSAL_TIMER_NONE )
+        break;
 
-        // Next
-        srchTimer = srchTimer->next;
-      }
-      else
-      {
-        // Get next
-        prevTimer = srchTimer;
-        srchTimer = srchTimer->next;
-      }
-      
-      HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
-      
-      if ( freeTimer )
+      osal_set_event( task_id, event_flag );
+    }
+
+    if ( updateTime == 0 )
+      break;
+    updateTime--;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    // Update the system time
+    osal_systemClock++;
+
+    // Move the records of the next 32 (and 1024) msec down a level
+    if ( (osal_systemClock & (OSAL_TIMER_L0_SLOTS - 1)) == 0 )
+    {
+      if ( (osal_systemClock & ((1UL << OSAL_TIMER_L2_SHIFT) - 1)) == 0 )
       {
-        if ( freeTimer->timeout == 0 )
-        {
-          osal_set_event( freeTimer->task_id, freeTimer->event_flag );
-        }
-        osal_mem_free( freeTimer );
+        osalTimerCascade( OSAL_TIMER_L2 + (uint8)( (osal_systemClock >> OSAL_TIMER_L2_SHIFT) &
+                                                   (OSAL_TIMER_L2_SLOTS - 1) ) );
       }
+      osalTimerCascade( OSAL_TIMER_L1 + (uint8)( (osal_systemClock >> OSAL_TIMER_L1_SHIFT) &
+                                                 (OSAL_TIMER_L1_SLOTS - 1) ) );
     }
+    slot = OSAL_TIMER_L0 + (uint8)( osal_systemClock & (OSAL_TIMER_L0_SLOTS - 1) );
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
   }
 }
 
@@ -447,7 +684,7 @@ void osal_adjust_timers( void )
 {
   uint16 eTime;
 
-  if ( timerHead != NULL )
+  if ( osalTimerActive != 0 )
   {
     // Compute elapsed time (msec)
     eTime = TimerElapsed() /  TICK_COUNT;
@@ -465,6 +702,9 @@ void osal_adjust_timers( void )
  *   Search timer table to return the lowest timeout value. If the
  *   timer list is empty, then the returned timeout will be zero.
  *
+ *   Only the first occupied slot of each wheel level can hold the
+ *   earliest timer, so at most one slot per level is searched.
+ *
  * @param   none
  *
  * @return  none
@@ -472,24 +712,19 @@ void osal_adjust_timers( void )
 uint16 osal_next_timeout( void )
 {
   uint16 nextTimeout;
-  osalTimerRec_t *srchTimer;
+  uint16 levelTimeout;
 
-  if ( timerHead != NULL )
+  if ( osalTimerActive != 0 )
   {
-    // Head of the timer list
-    srchTimer = timerHead;
-    nextTimeout = OSAL_TIMERS_MAX_TIMEOUT;
+    nextTimeout = osalTimerFirst( OSAL_TIMER_L0, OSAL_TIMER_L0_SLOTS, 0 );
 
-    // Look for the next timeout timer
-    while ( srchTimer != NULL )
-    {
-      if (srchTimer->timeout < nextTimeout)
-      {
-        nextTimeout = srchTimer->timeout;
-      }
-      // Check next timer
-      srchTimer = srchTimer->next;
-    }
+    levelTimeout = osalTimerFirst( OSAL_TIMER_L1, OSAL_TIMER_L1_SLOTS, OSAL_TIMER_L1_SHIFT );
+    if ( levelTimeout < nextTimeout )
+      nextTimeout = levelTimeout;
+
+    levelTimeout = osalTimerFirst( OSAL_TIMER_L2, OSAL_TIMER_L2_SLOTS, OSAL_TIMER_L2_SHIFT );
+    if ( levelTimeout < nextTimeout )
+      nextTimeout = levelTimeout;
   }
   else
   {
@@ -499,6 +734,45 @@ uint16 osal_next_timeout( void )
 
   return ( nextTimeout );
 }
+
+/*********************************************************************
+ * @fn      osalTimerFirst
+ *
+ * @brief   Lowest timeout in the first occupied slot of a wheel level.
+ *
+ * @param   base  - first slot of the level in osalTimerWheel[]
+ * @param   slots - number of slots of the level
+ * @param   shift - msec per slot, as a power of 2
+ *
+ * @return  lowest timeout, OSAL_TIMERS_MAX_TIMEOUT if the level is empty
+ *********************************************************************/
+static uint16 osalTimerFirst( uint8 base, uint8 slots, uint8 shift )
+{
+  uint16 first = OSAL_TIMERS_MAX_TIMEOUT;
+  uint32 timeout;
+  uint8 cur = (uint8)( osal_systemClock >> shift );
+  uint8 i;
+  osalTimerIdx_t idx;
+
+  // The current slot of level 0 holds the timers due now, that of the
+  // other levels those furthest away: look at it first or last.
+  for ( i = 0; i < slots; i++ )
+  {
+    idx = osalTimerWheel[base + ((cur + i + (shift != 0)) & (slots - 1))];
+    if ( idx != OSAL_TIMER_NONE )
+    {
+      for ( ; idx != OSAL_TIMER_NONE; idx = osalTimerPool[idx].next )
+      {
+        timeout = osalTimerPool[idx].expire - osal_systemClock;
+        if ( timeout < first )
+          first = (uint16)timeout;
+      }
+      break;
+    }
+  }
+
+  return ( first );
+}
 #endif // POWER_SAVING
 
 /*********************************************************************
@@ -75,6 +75,16 @@ extern "C"
 /*** Interrupts ***/
 #define INTS_ALL    0xFF
 
+/*** Message queue depth metrics ***/
+#if !defined ( OSAL_MSG_METRICS )
+  #define OSAL_MSG_METRICS  FALSE
+#endif
+
+/*** Task run-time accounting ***/
+#if !defined ( OSAL_TASK_METRICS )
+  #define OSAL_TASK_METRICS  FALSE
+#endif
+
 
 /*********************************************************************
  * TYPEDEFS
@@ -94,6 +104,15 @@ typedef struct
 
 typedef void * osal_msg_q_t;
 
+// Run-time accounting of one task, times in OSAL_TASK_CLOCK() ticks.
+typedef struct
+{
+  uint32 runs;       // Event handler calls.
+  uint32 ticks;      // Total time spent in the event handler.
+  uint16 maxTicks;   // Longest event handler call.
+  uint16 maxEvents;  // Events passed to the longest call.
+} osalTaskStats_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -129,6 +148,18 @@ typedef void * osal_msg_q_t;
    */
   extern uint8 *osal_msg_receive( uint8 task_id );
 
+#if ( OSAL_MSG_METRICS )
+  /*
+   * Task Messages Queued
+   */
+  extern uint16 osal_msg_q_depth( uint8 task_id );
+
+  /*
+   * Most Task Messages Ever Queued
+   */
+  extern uint16 osal_msg_q_high_water( uint8 task_id );
+#endif
+
 
   /*
    * Enqueue a Task Message
@@ -163,6 +194,13 @@ typedef void * osal_msg_q_t;
    */
   extern uint8 osal_set_event( uint8 task_id, uint16 event_flag );
 
+#if ( OSAL_TASK_METRICS )
+  /*
+   * Copy (and reset) the run-time accounting of a task
+   */
+  extern uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *stats, uint8 reset );
+#endif
+
 
 /*** Interrupt Management  ***/
 
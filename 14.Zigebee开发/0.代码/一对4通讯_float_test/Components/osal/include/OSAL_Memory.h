@@ -58,6 +58,20 @@ extern "C"
   #define OSALMEM_METRICS  FALSE
 #endif
 
+// Serve the hot fixed sizes from size-class pools ahead of the heap. The
+// default pools reserve 544 bytes, too much of the 2 KB end-device heap,
+// so they are on by default only for coordinators and routers.
+#if !defined ( OSALMEM_SLABS )
+  #if defined ( ZDO_COORDINATOR ) || defined ( RTR_NWK )
+    #define OSALMEM_SLABS  TRUE
+  #else
+    #define OSALMEM_SLABS  FALSE
+  #endif
+#endif
+
+// Number of size classes.
+#define OSALMEM_SLAB_CNT   3
+
 /*********************************************************************
  * MACROS
  */
@@ -66,6 +80,18 @@ extern "C"
  * TYPEDEFS
  */
 
+#if ( OSALMEM_SLABS ) && ( OSALMEM_METRICS )
+typedef struct
+{
+  uint16 blkSz;   // Bytes per block.
+  uint8  blkCnt;  // Blocks in the pool.
+  uint8  blkUse;  // Blocks now allocated.
+  uint8  blkMax;  // Max blocks ever allocated at once.
+  uint16 hit;     // Allocations served by the pool.
+  uint16 miss;    // Allocations of this class left to the heap.
+} osalMemSlabStats_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -116,6 +142,13 @@ extern "C"
   uint16 osal_heap_mem_used( void );
 #endif
 
+#if ( OSALMEM_SLABS ) && ( OSALMEM_METRICS )
+ /*
+  * Return the usage of a size-class pool.
+  */
+  uint8 osal_mem_slab_stats( uint8 cls, osalMemSlabStats_t *stats );
+#endif
+
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
  /*
   * Return the highest number of bytes ever used in the heap.
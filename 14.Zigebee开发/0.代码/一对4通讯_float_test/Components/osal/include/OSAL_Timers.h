@@ -58,6 +58,11 @@ extern "C"
  */
 #define OSAL_TIMERS_MAX_TIMEOUT 0xFFFF
 
+/*** Timer pool high-water metrics ***/
+#if !defined ( OSAL_TIMER_METRICS )
+  #define OSAL_TIMER_METRICS  FALSE
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -109,7 +114,14 @@ extern "C"
   /*
    * Count active timers
    */
-  extern uint8 osal_timer_num_active( void );
+  extern uint16 osal_timer_num_active( void );
+
+#if ( OSAL_TIMER_METRICS )
+  /*
+   * Most Timers Ever Active
+   */
+  extern uint16 osal_timer_high_water( void );
+#endif
 
   /*
    * Set the hardware timer interrupts for sleep mode.
@@ -0,0 +1,336 @@
+/**************************************************************************************************
+  Filename:       AF_Linux.c
+
+  Description:    Fake AF layer of the Linux host port, in place of AF.c
+                  and the network layer below it.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "OSAL.h"
+#include "AF.h"
+#include "aps_groups.h"
+#include "NLMEDE.h"
+#include "AF_Linux.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+uint16 afLinuxShortAddr = 0x0000;
+uint8 afLinuxExtAddr[Z_EXTADDR_LEN] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x4B, 0x12, 0x00 };
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static endPointDesc_t *afLinuxEP[AF_LINUX_EP_MAX];
+static afLinuxTx_t afLinuxTx;
+
+/*********************************************************************
+ * @fn      afRegister
+ *
+ * @brief   Register an Application's EndPoint description.
+ *
+ * @param   epDesc - pointer to the Application's endpoint descriptor.
+ *
+ * NOTE:  The memory that epDesc is pointing to must exist after this call.
+ *
+ * @return  afStatus_SUCCESS - Registered
+ *          afStatus_MEM_FAIL - no room for another endpoint
+ *          afStatus_INVALID_PARAMETER - duplicate endpoint
+ */
+afStatus_t afRegister( endPointDesc_t *epDesc )
+{
+  uint8 i;
+
+  if ( afFindEndPointDesc( epDesc->endPoint ) )
+  {
+    return ( afStatus_INVALID_PARAMETER );
+  }
+
+  for ( i = 0; i < AF_LINUX_EP_MAX; i++ )
+  {
+    if ( afLinuxEP[i] == NULL )
+    {
+      afLinuxEP[i] = epDesc;
+      return ( afStatus_SUCCESS );
+    }
+  }
+  return ( afStatus_MEM_FAIL );
+}
+
+/*********************************************************************
+ * @fn      afFindEndPointDesc
+ *
+ * @brief   Find the endpoint description entry from the endpoint
+ *          number.
+ *
+ * @param   EndPoint - Application Endpoint to look for
+ *
+ * @return  the address to the endpoint/interface description entry
+ */
+endPointDesc_t *afFindEndPointDesc( byte EndPoint )
+{
+  uint8 i;
+
+  for ( i = 0; i < AF_LINUX_EP_MAX; i++ )
+  {
+    if ( afLinuxEP[i] && afLinuxEP[i]->endPoint == EndPoint )
+    {
+      return ( afLinuxEP[i] );
+    }
+  }
+  return ( (endPointDesc_t *)NULL );
+}
+
+/*********************************************************************
+ * @fn      afDataConfirm
+ *
+ * @brief   Send a data confirm to the task of an endpoint.
+ *
+ * @param   endPoint - source endpoint of the request
+ * @param   transID  - transaction id of the request
+ * @param   status   - status of the request
+ *
+ * @return  none
+ */
+void afDataConfirm( uint8 endPoint, uint8 transID, ZStatus_t status )
+{
+  endPointDesc_t *epDesc;
+  afDataConfirm_t *msgPtr;
+
+  epDesc = afFindEndPointDesc( endPoint );
+  if ( epDesc == NULL )
+    return;
+
+  msgPtr = (afDataConfirm_t *)osal_msg_allocate( sizeof(afDataConfirm_t) );
+  if ( msgPtr )
+  {
+    msgPtr->hdr.event = AF_DATA_CONFIRM_CMD;
+    msgPtr->hdr.status = status;
+    msgPtr->endpoint = endPoint;
+    msgPtr->transID = transID;
+
+    osal_msg_send( *(epDesc->task_id), (byte *)msgPtr );
+  }
+}
+
+/*********************************************************************
+ * @fn      AF_DataRequest
+ *
+ * @brief   Hand the frame to the Tx hook and confirm it.
+ *
+ * @param  *dstAddr - Full ZB destination address: Nwk Addr + End Point.
+ * @param  *srcEP - Origination (i.e. respond to or ack to) End Point Descr.
+ * @param   cID - A valid cluster ID as specified by the Profile.
+ * @param   len - Number of bytes of data pointed to by next param.
+ * @param  *buf - A pointer to the data bytes to send.
+ * @param  *transID - A pointer to a byte which can be modified and which will
+ *                    be used as the transaction sequence number of the msg.
+ * @param   options - Valid bit mask of Tx options.
+ * @param   radius - Normally set to AF_DEFAULT_RADIUS.
+ *
+ * @return  afStatus_SUCCESS if the request was taken,
+ *          afStatus_INVALID_PARAMETER if it is longer than the MTU.
+ */
+afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                           uint16 cID, uint16 len, uint8 *buf, uint8 *transID,
+                           uint8 options, uint8 radius )
+{
+  ZStatus_t status = ZSuccess;
+
+  (void)options;
+  (void)radius;
+
+  if ( len > AF_LINUX_MTU )
+  {
+    return afStatus_INVALID_PARAMETER;
+  }
+
+  if ( afLinuxTx )
+  {
+    status = afLinuxTx( dstAddr, srcEP->endPoint, cID, len, buf );
+  }
+
+  afDataConfirm( srcEP->endPoint, *transID, status );
+  (*transID)++;
+
+  return afStatus_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      afDataReqMTU
+ *
+ * @brief   Get the Data Request MTU(Max Transport Unit).
+ *
+ * @param   fields - afDataReqMTU_t
+ *
+ * @return  AF_LINUX_MTU
+ */
+uint8 afDataReqMTU( afDataReqMTU_t* fields )
+{
+  (void)fields;
+  return AF_LINUX_MTU;
+}
+
+/*********************************************************************
+ * @fn      aps_AddGroup
+ *
+ * @brief   Groups are not filtered on the host; every frame is delivered.
+ *
+ * @param   endpoint - endpoint of the group
+ * @param   group    - group id and name
+ *
+ * @return  ZSuccess
+ */
+ZStatus_t aps_AddGroup( uint8 endpoint, aps_Group_t *group )
+{
+  (void)endpoint;
+  (void)group;
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * @fn      NLME_GetShortAddr
+ *
+ * @brief   Short address of the simulated device.
+ *
+ * @return  afLinuxShortAddr
+ */
+uint16 NLME_GetShortAddr( void )
+{
+  return afLinuxShortAddr;
+}
+
+/*********************************************************************
+ * @fn      NLME_GetExtAddr
+ *
+ * @brief   Extended address of the simulated device.
+ *
+ * @return  afLinuxExtAddr
+ */
+byte *NLME_GetExtAddr( void )
+{
+  return afLinuxExtAddr;
+}
+
+/*********************************************************************
+ * @fn      afLinuxTxHook
+ *
+ * @brief   Set the function that gets the data requests.
+ *
+ * @param   hook - function, NULL to confirm every request with ZSuccess
+ *
+ * @return  none
+ */
+void afLinuxTxHook( afLinuxTx_t hook )
+{
+  afLinuxTx = hook;
+}
+
+/*********************************************************************
+ * @fn      afLinuxReceive
+ *
+ * @brief   Deliver a frame to an endpoint, built as afBuildMSGIncoming()
+ *          builds it: the data follows the message in one allocation,
+ *          unless AF_LINUX_RX_IN_PLACE.
+ *
+ * @param   srcAddr      - short address of the sender
+ * @param   srcEP        - endpoint of the sender
+ * @param   dstEP        - endpoint it is for
+ * @param   clusterID    - cluster
+ * @param   len          - length of the data
+ * @param   buf          - data
+ * @param   wasBroadcast - TRUE for a broadcast
+ *
+ * @return  afStatus_SUCCESS, afStatus_INVALID_PARAMETER for an endpoint
+ *          not registered, afStatus_MEM_FAIL when the heap is full.
+ */
+afStatus_t afLinuxReceive( uint16 srcAddr, uint8 srcEP, uint8 dstEP, uint16 clusterID,
+                           uint16 len, uint8 *buf, uint8 wasBroadcast )
+{
+  endPointDesc_t *epDesc;
+  afIncomingMSGPacket_t *MSGpkt;
+
+  epDesc = afFindEndPointDesc( dstEP );
+  if ( epDesc == NULL )
+  {
+    return afStatus_INVALID_PARAMETER;
+  }
+
+#if ( AF_LINUX_RX_IN_PLACE )
+  MSGpkt = (afIncomingMSGPacket_t *)osal_msg_allocate( sizeof( afIncomingMSGPacket_t ) );
+#else
+  MSGpkt = (afIncomingMSGPacket_t *)osal_msg_allocate( sizeof( afIncomingMSGPacket_t ) + len );
+#endif
+  if ( MSGpkt == NULL )
+  {
+    return afStatus_MEM_FAIL;
+  }
+
+  osal_memset( MSGpkt, 0, sizeof( afIncomingMSGPacket_t ) );
+  MSGpkt->hdr.event = AF_INCOMING_MSG_CMD;
+  MSGpkt->clusterId = clusterID;
+  MSGpkt->srcAddr.addr.shortAddr = srcAddr;
+  MSGpkt->srcAddr.addrMode = afAddr16Bit;
+  MSGpkt->srcAddr.endPoint = srcEP;
+  MSGpkt->endPoint = dstEP;
+  MSGpkt->wasBroadcast = wasBroadcast;
+  MSGpkt->LinkQuality = 0xFF;
+  MSGpkt->macDestAddr = wasBroadcast ? 0xFFFF : afLinuxShortAddr;
+  MSGpkt->cmd.DataLength = len;
+
+  if ( len )
+  {
+#if ( AF_LINUX_RX_IN_PLACE )
+    MSGpkt->cmd.Data = buf;
+#else
+    MSGpkt->cmd.Data = (byte *)(MSGpkt + 1);
+    osal_memcpy( MSGpkt->cmd.Data, buf, len );
+#endif
+  }
+  else
+  {
+    MSGpkt->cmd.Data = NULL;
+  }
+
+  osal_msg_send( *(epDesc->task_id), (uint8 *)MSGpkt );
+  return afStatus_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      afLinuxStateChange
+ *
+ * @brief   Tell every endpoint task the new network state, as ZDApp
+ *          does once the device has started.
+ *
+ * @param   state - devStates_t
+ *
+ * @return  none
+ */
+void afLinuxStateChange( uint8 state )
+{
+  osal_event_hdr_t *msgPtr;
+  uint8 i;
+
+  for ( i = 0; i < AF_LINUX_EP_MAX; i++ )
+  {
+    if ( afLinuxEP[i] == NULL )
+    {
+      continue;
+    }
+    msgPtr = (osal_event_hdr_t *)osal_msg_allocate( sizeof(osal_event_hdr_t) );
+    if ( msgPtr )
+    {
+      msgPtr->event = ZDO_STATE_CHANGE;
+      msgPtr->status = state;
+      osal_msg_send( *(afLinuxEP[i]->task_id), (uint8 *)msgPtr );
+    }
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,93 @@
+/**************************************************************************************************
+  Filename:       AF_Linux.h
+
+  Description:    Fake AF layer of the Linux host port.
+
+                  Applications run against it unchanged: they register
+                  their endpoints and call AF_DataRequest() as on the
+                  target. Every request goes to a hook, and its data
+                  confirm comes back as an AF_DATA_CONFIRM_CMD with the
+                  status the hook returns. The simulation plays the rest of
+                  the network through afLinuxReceive() and
+                  afLinuxStateChange().
+**************************************************************************************************/
+
+#ifndef AF_LINUX_H
+#define AF_LINUX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "AF.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Endpoints that can be registered.
+#if !defined( AF_LINUX_EP_MAX )
+#define AF_LINUX_EP_MAX     4
+#endif
+
+// Value of afDataReqMTU(); longer requests are refused.
+#if !defined( AF_LINUX_MTU )
+#define AF_LINUX_MTU        80
+#endif
+
+// TRUE to deliver received data in the caller's buffer rather than in a
+// copy on the OSAL heap, so that a host sanitizer sees reads past its end.
+// The buffer must then stay valid until the message has been processed.
+#if !defined( AF_LINUX_RX_IN_PLACE )
+#define AF_LINUX_RX_IN_PLACE  FALSE
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Gets every data request; returns the status of its data confirm.
+typedef ZStatus_t (*afLinuxTx_t)( afAddrType_t *dstAddr, uint8 srcEP, uint16 clusterID,
+                                  uint16 len, uint8 *buf );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Short and extended address of the simulated device.
+extern uint16 afLinuxShortAddr;
+extern uint8 afLinuxExtAddr[Z_EXTADDR_LEN];
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Set the hook that gets the data requests.
+ */
+extern void afLinuxTxHook( afLinuxTx_t hook );
+
+/*
+ * Deliver a frame to an endpoint as AF_INCOMING_MSG_CMD.
+ */
+extern afStatus_t afLinuxReceive( uint16 srcAddr, uint8 srcEP, uint8 dstEP, uint16 clusterID,
+                                  uint16 len, uint8 *buf, uint8 wasBroadcast );
+
+/*
+ * Tell every endpoint task the new network state as ZDO_STATE_CHANGE.
+ */
+extern void afLinuxStateChange( uint8 state );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AF_LINUX_H */
@@ -0,0 +1,230 @@
+/**************************************************************************************************
+  Filename:       OSAL_Nv.c
+
+  Description:    OSAL non-volatile memory functions of the Linux host port.
+
+                  Items live in one RAM image, each as a header followed by
+                  its data, in the order they were created. Nothing survives
+                  the process, which is what a regression run wants: every
+                  run starts from erased NV.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "hal_types.h"
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Nv.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Size of the RAM image; two CC2530 flash pages.
+#if !defined( OSAL_NV_RAM_SIZE )
+#define OSAL_NV_RAM_SIZE        4096
+#endif
+
+#define OSAL_NV_ITEM_NULL       0xFFFF
+#define OSAL_NV_HDR_SIZE        sizeof( osalNvHdr_t )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint16 id;
+  uint16 len;
+} osalNvHdr_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8 nvRam[OSAL_NV_RAM_SIZE];
+static uint16 nvEnd;   // Offset of the first free byte.
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint16 findItem( uint16 id, osalNvHdr_t *hdr );
+
+/*********************************************************************
+ * @fn      findItem
+ *
+ * @brief   Find an item by walking the headers.
+ *
+ * @param   id   - Valid NV item Id.
+ * @param   hdr  - Returns the header of the item.
+ *
+ * @return  Offset of the data of the item; OSAL_NV_ITEM_NULL if not found.
+ */
+static uint16 findItem( uint16 id, osalNvHdr_t *hdr )
+{
+  uint16 off = 0;
+
+  while ( off < nvEnd )
+  {
+    osal_memcpy( hdr, &nvRam[off], OSAL_NV_HDR_SIZE );
+    off += OSAL_NV_HDR_SIZE;
+    if ( hdr->id == id )
+    {
+      return off;
+    }
+    off += hdr->len;
+  }
+
+  return OSAL_NV_ITEM_NULL;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_init
+ *
+ * @brief   Initialize NV service: erase the RAM image.
+ *
+ * @param   p - Not used.
+ *
+ * @return  none
+ */
+void osal_nv_init( void *p )
+{
+  (void)p;
+  osal_memset( nvRam, 0xFF, OSAL_NV_RAM_SIZE );
+  nvEnd = 0;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_item_init
+ *
+ * @brief   If the NV item does not already exist, it is created and
+ *          initialized with the data passed to the function, if any.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   len - Item length.
+ * @param  *buf - Pointer to item initalization data. Set to NULL if none.
+ *
+ * @return  NV_ITEM_UNINIT - Id did not exist and was created successfully.
+ *          ZSUCCESS       - Id already existed, no action taken.
+ *          NV_OPER_FAILED - Failure to find or create Id.
+ */
+uint8 osal_nv_item_init( uint16 id, uint16 len, void *buf )
+{
+  osalNvHdr_t hdr;
+
+  if ( findItem( id, &hdr ) != OSAL_NV_ITEM_NULL )
+  {
+    return ZSUCCESS;
+  }
+
+  if ( (uint32)nvEnd + OSAL_NV_HDR_SIZE + len > OSAL_NV_RAM_SIZE )
+  {
+    return NV_OPER_FAILED;
+  }
+
+  hdr.id = id;
+  hdr.len = len;
+  osal_memcpy( &nvRam[nvEnd], &hdr, OSAL_NV_HDR_SIZE );
+  nvEnd += OSAL_NV_HDR_SIZE;
+  if ( buf != NULL )
+  {
+    osal_memcpy( &nvRam[nvEnd], buf, len );
+  }
+  nvEnd += len;
+
+  return NV_ITEM_UNINIT;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_item_len
+ *
+ * @brief   Get the data length of the item stored in NV memory.
+ *
+ * @param   id  - Valid NV item Id.
+ *
+ * @return  Item length, if found; zero otherwise.
+ */
+uint16 osal_nv_item_len( uint16 id )
+{
+  osalNvHdr_t hdr;
+
+  if ( findItem( id, &hdr ) == OSAL_NV_ITEM_NULL )
+  {
+    return 0;
+  }
+  return hdr.len;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_write
+ *
+ * @brief   Write a data item to NV. Function can write an entire item to NV or
+ *          an element of an item by indexing into the item with an offset.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   ndx - Index offset into item
+ * @param   len - Length of data to write.
+ * @param  *buf - Data to write.
+ *
+ * @return  ZSUCCESS if successful, NV_ITEM_UNINIT if item did not
+ *          exist in NV, NV_OPER_FAILED if it is too short.
+ */
+uint8 osal_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  osalNvHdr_t hdr;
+  uint16 off;
+
+  if ( len == 0 )
+  {
+    return ZSUCCESS;
+  }
+
+  off = findItem( id, &hdr );
+  if ( off == OSAL_NV_ITEM_NULL )
+  {
+    return NV_ITEM_UNINIT;
+  }
+  if ( hdr.len < (uint32)ndx + len )
+  {
+    return NV_OPER_FAILED;
+  }
+
+  osal_memcpy( &nvRam[off + ndx], buf, len );
+  return ZSUCCESS;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_read
+ *
+ * @brief   Read data from NV. This function can be used to read an entire item from NV or
+ *          an element of an item by indexing into the item with an offset.
+ *          Read data is copied into *buf.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   ndx - Index offset into item
+ * @param   len - Length of data to read.
+ * @param  *buf - Data is read into this buffer.
+ *
+ * @return  ZSUCCESS if NV data was copied to the parameter 'buf'.
+ *          Otherwise, NV_OPER_FAILED for failure.
+ */
+uint8 osal_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  osalNvHdr_t hdr;
+  uint16 off;
+
+  off = findItem( id, &hdr );
+  if ( off == OSAL_NV_ITEM_NULL || hdr.len < (uint32)ndx + len )
+  {
+    return NV_OPER_FAILED;
+  }
+
+  osal_memcpy( buf, &nvRam[off + ndx], len );
+  return ZSUCCESS;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,125 @@
+/**************************************************************************************************
+  Filename:       OnBoard.h
+
+  Description:    Board definitions of the Linux host port, in place of
+                  ZMain/TI2530DB/OnBoard.h. The heap sizes are those of the
+                  CC2530 build so that heap and pool behaviour carry over.
+**************************************************************************************************/
+
+#ifndef ONBOARD_H
+#define ONBOARD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "hal_uart.h"
+#include "OSAL.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/* OSAL timer defines */
+#define TICK_TIME   1000   // Timer per tick - in micro-sec
+#define TICK_COUNT  1
+
+// Reset the host node
+#define SystemReset()       HAL_SYSTEM_RESET()
+#define SystemResetSoft()   HAL_SYSTEM_RESET()
+
+// Wait for specified microseconds
+#define MicroWait(t) Onboard_wait(t)
+
+// Sleep is only simulated time passing
+#define OSAL_SET_CPU_INTO_SLEEP(timeout)
+
+// Internal (MCU) heap size
+#if !defined( INT_HEAP_LEN )
+  #if defined( ZDO_COORDINATOR )
+    #define INT_HEAP_LEN  3072
+  #elif defined( RTR_NWK )
+    #define INT_HEAP_LEN  3072
+  #else
+    #define INT_HEAP_LEN  2048
+  #endif
+#endif
+
+// Memory Allocation Heap
+#define MAXMEMHEAP INT_HEAP_LEN
+
+#define KEY_CHANGE_SHIFT_IDX 1
+#define KEY_CHANGE_KEYS_IDX  2
+
+// Eval board LCD emulation
+#define MAX_LCD_CHARS 16
+
+// Initialization levels
+#define OB_COLD  0
+#define OB_WARM  1
+#define OB_READY 2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8             state; // shift
+  uint8             keys;  // keys
+} keyChange_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+  /*
+   * Initialize the Peripherals
+   *    level: 0=cold, 1=warm, 2=ready
+   */
+  extern void InitBoard( uint8 level );
+
+ /*
+  * Get elapsed timer clock counts
+  */
+  extern uint32 TimerElapsed( void );
+
+  /*
+   * Register for all key events
+   */
+  extern uint8 RegisterForKeys( uint8 task_id );
+
+  /*
+   * Send "Key Pressed" message to application
+   */
+  extern uint8 OnBoard_SendKeys( uint8 keys, uint8 shift );
+
+  /*
+   * Convert an interger to an ascii string
+   */
+  extern void _itoa( uint16 num, uint8 *buf, uint8 radix );
+
+  /*
+   * Board specific random number generator
+   */
+  extern uint16 Onboard_rand( void );
+
+  /*
+   * Board specific micro-second wait
+   */
+  extern void Onboard_wait( uint16 timeout );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ONBOARD_H
@@ -0,0 +1,76 @@
+/**************************************************************************************************
+  Filename:       hal_board_cfg.h
+
+  Description:    Board configuration of the Linux host port. The host has
+                  no peripherals of its own; the port provides the UART,
+                  LCD, LED and key functions SerialApp uses as stand-ins.
+**************************************************************************************************/
+
+#ifndef HAL_BOARD_CFG_H
+#define HAL_BOARD_CFG_H
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_mcu.h"
+#include "hal_defs.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Board Indentifier
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_BOARD_LINUX
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Clock Speed
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_CPU_CLOCK_MHZ     32
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       LED Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_NUM_LEDS            3
+#define HAL_LED_BLINK_DELAY()
+
+/* ------------------------------------------------------------------------------------------------
+ *                                            Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_BOARD_INIT()
+
+#define HAL_PUSH_BUTTON1()        (0)
+#define HAL_PUSH_BUTTON2()        (0)
+#define HAL_PUSH_BUTTON3()        (0)
+#define HAL_PUSH_BUTTON4()        (0)
+#define HAL_PUSH_BUTTON5()        (0)
+#define HAL_PUSH_BUTTON6()        (0)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Driver Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Only the drivers the port stands in for */
+#define HAL_TIMER     FALSE
+#define HAL_ADC       FALSE
+#define HAL_DMA       FALSE
+#define HAL_FLASH     FALSE
+#define HAL_AES       FALSE
+#define HAL_AES_DMA   FALSE
+#define HAL_LCD       TRUE
+#define HAL_LED       TRUE
+#define HAL_KEY       TRUE
+
+#ifndef HAL_UART
+#define HAL_UART      TRUE
+#endif
+#define HAL_UART_DMA  0
+#define HAL_UART_ISR  0
+
+/*******************************************************************************************************
+*/
+#endif
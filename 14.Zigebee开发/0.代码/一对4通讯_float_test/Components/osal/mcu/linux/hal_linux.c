@@ -0,0 +1,655 @@
+/**************************************************************************************************
+  Filename:       hal_linux.c
+
+  Description:    HAL of the Linux host port: the critical section mutex,
+                  the simulated clock, a fake UART, and the LCD, LED, key
+                  and board functions the applications call.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal_mcu.h"
+#include "hal_drivers.h"
+#include "hal_assert.h"
+#include "hal_lcd.h"
+#include "hal_led.h"
+#include "hal_uart.h"
+#include "hal_linux.h"
+#include "ZComDef.h"
+#include "OnBoard.h"
+#include "OSAL.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_LINUX_BACKOFF_USEC    320
+
+/* Task ID not initialized */
+#define NO_TASK_ID                0xFF
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  halUARTCBack_t callBack;
+  uint8          open;
+  uint16         rxHead;                 // next byte to read
+  uint16         rxCnt;                  // bytes waiting
+  uint32         rxStamp;                // time of the last byte received
+  uint8          rxBuf[HAL_LINUX_UART_RX_MAX];
+} halLinuxUart_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                      Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+uint8 halLinuxVerbose = FALSE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static pthread_mutex_t halLinuxMutex;
+static pthread_once_t halLinuxOnce = PTHREAD_ONCE_INIT;
+
+static uint32 halLinuxUsec;
+static halLinuxUart_t halLinuxUart[HAL_UART_PORT_MAX];
+static halLinuxUartTx_t halLinuxTx;
+
+static uint8 registeredKeysTaskID = NO_TASK_ID;
+static uint8 halLinuxLeds;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void halLinuxMutexInit( void );
+
+/**************************************************************************************************
+ * @fn      halLinuxMutexInit
+ *
+ * @brief   Create the critical section mutex. It is recursive, as a critical section
+ *          may be entered again from a function called inside one.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+static void halLinuxMutexInit( void )
+{
+  pthread_mutexattr_t attr;
+
+  pthread_mutexattr_init( &attr );
+  pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+  pthread_mutex_init( &halLinuxMutex, &attr );
+  pthread_mutexattr_destroy( &attr );
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxLock
+ *
+ * @brief   Enter a critical section.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+void halLinuxLock( void )
+{
+  pthread_once( &halLinuxOnce, halLinuxMutexInit );
+  pthread_mutex_lock( &halLinuxMutex );
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxUnlock
+ *
+ * @brief   Leave a critical section.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+void halLinuxUnlock( void )
+{
+  pthread_mutex_unlock( &halLinuxMutex );
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxReset
+ *
+ * @brief   A reset ends the simulation; nothing on the host can restart the stack.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+void halLinuxReset( void )
+{
+  fprintf( stderr, "hal: system reset at %lu us\n", (unsigned long)halLinuxTime() );
+  exit( EXIT_FAILURE );
+}
+
+/**************************************************************************************************
+ * @fn      halAssertHandler
+ *
+ * @brief   Stop at the failed assert, leaving a core for the debugger.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+void halAssertHandler( void )
+{
+  fprintf( stderr, "hal: assert at %lu us\n", (unsigned long)halLinuxTime() );
+  abort();
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxAdvance
+ *
+ * @brief   Let simulated time pass. The OSAL timers see it on the next osalTimeUpdate().
+ *
+ * @param   usec - microseconds
+ *
+ * @return  none
+ **************************************************************************************************/
+void halLinuxAdvance( uint32 usec )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  halLinuxUsec += usec;
+  HAL_EXIT_CRITICAL_SECTION( intState );
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxTime
+ *
+ * @brief   Simulated time.
+ *
+ * @param   none
+ *
+ * @return  microseconds since start
+ **************************************************************************************************/
+uint32 halLinuxTime( void )
+{
+  halIntState_t intState;
+  uint32 usec;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  usec = halLinuxUsec;
+  HAL_EXIT_CRITICAL_SECTION( intState );
+
+  return usec;
+}
+
+/**************************************************************************************************
+ * @fn      macMcuPrecisionCount
+ *
+ * @brief   Free-running backoff count, as the MAC timer would keep it.
+ *
+ * @param   none
+ *
+ * @return  simulated time in 320 usec periods, modulo 2^16
+ **************************************************************************************************/
+uint16 macMcuPrecisionCount( void )
+{
+  return (uint16)( halLinuxTime() / HAL_LINUX_BACKOFF_USEC );
+}
+
+/**************************************************************************************************
+ * @fn      TimerElapsed
+ *
+ * @brief   Ticks slept; the host never sleeps.
+ *
+ * @param   none
+ *
+ * @return  0
+ **************************************************************************************************/
+uint32 TimerElapsed( void )
+{
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn      InitBoard
+ *
+ * @brief   Nothing to set up on the host.
+ *
+ * @param   level - OB_COLD, OB_WARM or OB_READY
+ *
+ * @return  none
+ **************************************************************************************************/
+void InitBoard( uint8 level )
+{
+  (void)level;
+}
+
+/**************************************************************************************************
+ * @fn      Hal_ProcessPoll
+ *
+ * @brief   Raise the UART Rx events with the thresholds of the DMA driver.
+ *
+ * @param   none
+ *
+ * @return  none
+ **************************************************************************************************/
+void Hal_ProcessPoll( void )
+{
+  halIntState_t intState;
+  halLinuxUart_t *u;
+  uint8 port;
+  uint8 evt;
+
+  for ( port = 0; port < HAL_UART_PORT_MAX; port++ )
+  {
+    u = &halLinuxUart[port];
+    evt = 0;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );
+    if ( u->rxCnt >= HAL_LINUX_UART_FULL )
+    {
+      evt = HAL_UART_RX_FULL;
+    }
+    else if ( u->rxCnt >= HAL_LINUX_UART_HIGH )
+    {
+      evt = HAL_UART_RX_ABOUT_FULL;
+    }
+    else if ( u->rxCnt && (uint32)(halLinuxUsec - u->rxStamp) >= HAL_LINUX_UART_IDLE )
+    {
+      evt = HAL_UART_RX_TIMEOUT;
+    }
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
+    if ( evt && u->open && u->callBack )
+    {
+      u->callBack( port, evt );
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn      HalUARTOpen
+ *
+ * @brief   Open a port. Baud rate and flow control mean nothing here.
+ *
+ * @param   port   - UART port
+ *          config - contains the callback function
+ *
+ * @return  HAL_UART_SUCCESS
+ **************************************************************************************************/
+uint8 HalUARTOpen( uint8 port, halUARTCfg_t *config )
+{
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return HAL_UART_NOT_SUPPORTED;
+  }
+
+  halLinuxUart[port].callBack = config->callBackFunc;
+  halLinuxUart[port].open = TRUE;
+
+  return HAL_UART_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn      HalUARTRead
+ *
+ * @brief   Read a buffer from the UART.
+ *
+ * @param   port - UART port
+ *          buf  - valid data buffer at least 'len' bytes in size
+ *          len  - max length number of bytes to copy to 'buf'
+ *
+ * @return  length of buffer that was read
+ **************************************************************************************************/
+uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len )
+{
+  halIntState_t intState;
+  halLinuxUart_t *u;
+  uint16 cnt = 0;
+
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+  u = &halLinuxUart[port];
+
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  while ( cnt < len && u->rxCnt )
+  {
+    buf[cnt++] = u->rxBuf[u->rxHead];
+    if ( ++u->rxHead >= HAL_LINUX_UART_RX_MAX )
+    {
+      u->rxHead = 0;
+    }
+    u->rxCnt--;
+  }
+  HAL_EXIT_CRITICAL_SECTION( intState );
+
+  return cnt;
+}
+
+/**************************************************************************************************
+ * @fn      HalUARTWrite
+ *
+ * @brief   Write a buffer to the UART; it goes to the Tx hook at once.
+ *
+ * @param   port - UART port
+ *          buf  - pointer to the buffer that will be written
+ *          len  - length of the buffer
+ *
+ * @return  length of the buffer that was sent
+ **************************************************************************************************/
+uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len )
+{
+  if ( port >= HAL_UART_PORT_MAX || !halLinuxUart[port].open )
+  {
+    return 0;
+  }
+
+  if ( halLinuxTx )
+  {
+    halLinuxTx( port, buf, len );
+  }
+  return len;
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxUartFeed
+ *
+ * @brief   Bytes arriving on a UART. May be called from any thread.
+ *
+ * @param   port - UART port
+ *          buf  - received bytes
+ *          len  - number of bytes
+ *
+ * @return  number of bytes that fitted in the Rx buffer
+ **************************************************************************************************/
+uint16 halLinuxUartFeed( uint8 port, const uint8 *buf, uint16 len )
+{
+  halIntState_t intState;
+  halLinuxUart_t *u;
+  uint16 tail;
+  uint16 cnt = 0;
+
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+  u = &halLinuxUart[port];
+
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  while ( cnt < len && u->rxCnt < HAL_LINUX_UART_RX_MAX )
+  {
+    tail = u->rxHead + u->rxCnt;
+    if ( tail >= HAL_LINUX_UART_RX_MAX )
+    {
+      tail -= HAL_LINUX_UART_RX_MAX;
+    }
+    u->rxBuf[tail] = buf[cnt++];
+    u->rxCnt++;
+  }
+  if ( cnt )
+  {
+    u->rxStamp = halLinuxUsec;
+  }
+  HAL_EXIT_CRITICAL_SECTION( intState );
+
+  return cnt;
+}
+
+/**************************************************************************************************
+ * @fn      halLinuxUartTxHook
+ *
+ * @brief   Set the function that gets the bytes written to the UARTs.
+ *
+ * @param   hook - function, NULL to drop the bytes
+ *
+ * @return  none
+ **************************************************************************************************/
+void halLinuxUartTxHook( halLinuxUartTx_t hook )
+{
+  halLinuxTx = hook;
+}
+
+/**************************************************************************************************
+ * @fn      HalLcdWriteString
+ *
+ * @brief   Write a string to the LCD, i.e. to stdout when verbose.
+ *
+ * @param   str    - pointer to the string that will be displayed
+ *          option - display options
+ *
+ * @return  none
+ **************************************************************************************************/
+void HalLcdWriteString( char *str, uint8 option )
+{
+  if ( halLinuxVerbose )
+  {
+    printf( "lcd%u: %s\n", (unsigned)option, str );
+  }
+}
+
+/**************************************************************************************************
+ * @fn      HalLcdWriteStringValue
+ *
+ * @brief   Write a string followed by a value to the LCD.
+ *
+ * @param   title  - Title that will be displayed before the value
+ *          value  - value
+ *          format - redix
+ *          line   - line number
+ *
+ * @return  none
+ **************************************************************************************************/
+void HalLcdWriteStringValue( char *title, uint16 value, uint8 format, uint8 line )
+{
+  if ( halLinuxVerbose )
+  {
+    printf( format == 16 ? "lcd%u: %s%X\n" : "lcd%u: %s%u\n",
+            (unsigned)line, title, (unsigned)value );
+  }
+}
+
+/**************************************************************************************************
+ * @fn      HalLcdWriteStringValueValue
+ *
+ * @brief   Write a string followed by two values to the LCD.
+ *
+ * @param   title   - Title that will be displayed before the value
+ *          value1  - value #1
+ *          format1 - redix of value #1
+ *          value2  - value #2
+ *          format2 - redix of value #2
+ *          line    - line number
+ *
+ * @return  none
+ **************************************************************************************************/
+void HalLcdWriteStringValueValue( char *title, uint16 value1, uint8 format1,
+                                  uint16 value2, uint8 format2, uint8 line )
+{
+  if ( halLinuxVerbose )
+  {
+    printf( "lcd%u: %s", (unsigned)line, title );
+    printf( format1 == 16 ? "%X " : "%u ", (unsigned)value1 );
+    printf( format2 == 16 ? "%X\n" : "%u\n", (unsigned)value2 );
+  }
+}
+
+/**************************************************************************************************
+ * @fn      HalLedSet
+ *
+ * @brief   Turn LEDs on, off or toggle them. Blink and flash only set them on.
+ *
+ * @param   led  - bit mask value of leds to be turned ON/OFF/TOGGLE
+ *          mode - BLINK, FLASH, TOGGLE, ON, OFF
+ *
+ * @return  LED state
+ **************************************************************************************************/
+uint8 HalLedSet( uint8 led, uint8 mode )
+{
+  switch ( mode )
+  {
+    case HAL_LED_MODE_OFF:
+      halLinuxLeds &= ~led;
+      break;
+
+    case HAL_LED_MODE_TOGGLE:
+      halLinuxLeds ^= led;
+      break;
+
+    default:
+      halLinuxLeds |= led;
+      break;
+  }
+
+  if ( halLinuxVerbose )
+  {
+    printf( "led: %02X\n", (unsigned)halLinuxLeds );
+  }
+  return halLinuxLeds;
+}
+
+/**************************************************************************************************
+ * @fn      HalLedBlink
+ *
+ * @brief   Blink the leds; on the host they just come on.
+ *
+ * @param   leds       - bit mask value of leds to be blinked
+ *          numBlinks  - number of blinks
+ *          percent    - the percentage in each period where the led
+ *                       will be on
+ *          period     - length of each cycle in milliseconds
+ *
+ * @return  none
+ **************************************************************************************************/
+void HalLedBlink( uint8 leds, uint8 numBlinks, uint8 percent, uint16 period )
+{
+  (void)numBlinks;
+  (void)percent;
+  (void)period;
+  (void)HalLedSet( leds, HAL_LED_MODE_ON );
+}
+
+/**************************************************************************************************
+ * @fn      RegisterForKeys
+ *
+ * @brief   The key handler will send key change messages to this task.
+ *
+ * @param   task_id - task to get the keys
+ *
+ * @return  TRUE for the first task only
+ **************************************************************************************************/
+uint8 RegisterForKeys( uint8 task_id )
+{
+  // Allow only the first task
+  if ( registeredKeysTaskID == NO_TASK_ID )
+  {
+    registeredKeysTaskID = task_id;
+    return ( TRUE );
+  }
+  return ( FALSE );
+}
+
+/**************************************************************************************************
+ * @fn      OnBoard_SendKeys
+ *
+ * @brief   Send "Key Pressed" message to application; the simulation presses the keys.
+ *
+ * @param   keys  - keys that were pressed
+ *          state - shifted
+ *
+ * @return  status
+ **************************************************************************************************/
+uint8 OnBoard_SendKeys( uint8 keys, uint8 state )
+{
+  keyChange_t *msgPtr;
+
+  if ( registeredKeysTaskID == NO_TASK_ID )
+  {
+    return ( ZFailure );
+  }
+
+  msgPtr = (keyChange_t *)osal_msg_allocate( sizeof(keyChange_t) );
+  if ( msgPtr )
+  {
+    msgPtr->hdr.event = KEY_CHANGE;
+    msgPtr->state = state;
+    msgPtr->keys = keys;
+
+    osal_msg_send( registeredKeysTaskID, (uint8 *)msgPtr );
+  }
+  return ( ZSuccess );
+}
+
+/**************************************************************************************************
+ * @fn      Onboard_rand
+ *
+ * @brief   Random number; the same sequence on every run.
+ *
+ * @param   none
+ *
+ * @return  16 bit random number
+ **************************************************************************************************/
+uint16 Onboard_rand( void )
+{
+  return (uint16)rand();
+}
+
+/**************************************************************************************************
+ * @fn      Onboard_wait
+ *
+ * @brief   Busy wait; simulated time just moves on.
+ *
+ * @param   timeout - microseconds
+ *
+ * @return  none
+ **************************************************************************************************/
+void Onboard_wait( uint16 timeout )
+{
+  halLinuxAdvance( timeout );
+}
+
+/**************************************************************************************************
+ * @fn      _itoa
+ *
+ * @brief   convert a 16bit number to ASCII
+ *
+ * @param   num -
+ *          buf -
+ *          radix -
+ *
+ * @return  void
+ **************************************************************************************************/
+void _itoa( uint16 num, uint8 *buf, uint8 radix )
+{
+  uint8 c, i;
+  uint8 *p, rst[5];
+
+  p = rst;
+  for ( i = 0; i < 5; i++, p++ )
+  {
+    c = num % radix;  // Isolate a digit
+    *p = c + (( c < 10 ) ? '0' : '7');  // Convert to Ascii
+    num /= radix;
+    if ( !num )
+      break;
+  }
+
+  for ( c = 0; c <= i; c++ )
+    *buf++ = *p--;  // Reverse character order
+
+  *buf = '\0';
+}
+
+/**************************************************************************************************
+*/
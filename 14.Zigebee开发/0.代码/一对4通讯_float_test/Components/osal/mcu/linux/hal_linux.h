@@ -0,0 +1,102 @@
+/**************************************************************************************************
+  Filename:       hal_linux.h
+
+  Description:    Simulation hooks of the Linux host port.
+
+                  Time on the host is simulated: it only moves when the
+                  simulation calls halLinuxAdvance(), and the 320 usec MAC
+                  backoff count that osalTimeUpdate() reads is derived from
+                  it. A run is therefore exactly repeatable, and as fast as
+                  the host can execute the tasks.
+
+                  UART bytes are fed in with halLinuxUartFeed(), from any
+                  thread, and polled out by Hal_ProcessPoll() with the same
+                  thresholds as the CC2530 DMA driver. Bytes written by the
+                  application go to a hook.
+**************************************************************************************************/
+
+#ifndef HAL_LINUX_H
+#define HAL_LINUX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Rx buffer of the fake UART; the thresholds follow _hal_uart_dma.c */
+#if !defined( HAL_LINUX_UART_RX_MAX )
+#define HAL_LINUX_UART_RX_MAX     128
+#endif
+#define HAL_LINUX_UART_FULL       (HAL_LINUX_UART_RX_MAX - 16)
+#define HAL_LINUX_UART_HIGH       (HAL_LINUX_UART_RX_MAX / 2 - 16)
+
+/* Rx idle time in usec before a HAL_UART_RX_TIMEOUT */
+#if !defined( HAL_LINUX_UART_IDLE )
+#define HAL_LINUX_UART_IDLE       6000
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Called with every HalUARTWrite() */
+typedef void (*halLinuxUartTx_t)( uint8 port, uint8 *buf, uint16 len );
+
+/* ------------------------------------------------------------------------------------------------
+ *                                      Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Print LCD writes and LED changes to stdout */
+extern uint8 halLinuxVerbose;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/*
+ * Let usec of simulated time pass.
+ */
+extern void halLinuxAdvance( uint32 usec );
+
+/*
+ * Simulated time in usec since start.
+ */
+extern uint32 halLinuxTime( void );
+
+/*
+ * Free-running count of 320 usec MAC backoff periods, read by osalTimeUpdate().
+ */
+extern uint16 macMcuPrecisionCount( void );
+
+/*
+ * Queue received bytes on a UART; returns the number that fitted.
+ */
+extern uint16 halLinuxUartFeed( uint8 port, const uint8 *buf, uint16 len );
+
+/*
+ * Set the hook that gets the bytes written to the UARTs.
+ */
+extern void halLinuxUartTxHook( halLinuxUartTx_t hook );
+
+/**************************************************************************************************
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_LINUX_H */
@@ -0,0 +1,80 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    MCU abstraction of the Linux host port.
+
+                  There are no interrupts on the host: whatever stands in
+                  for an ISR (the simulated clock, a test feeding the fake
+                  radio or UART from another thread) runs on a thread of
+                  its own. A critical section therefore holds one recursive
+                  mutex, shared by all threads, instead of clearing EA.
+**************************************************************************************************/
+
+#ifndef _HAL_MCU_H
+#define _HAL_MCU_H
+
+/*
+ *  Target : Linux host (simulation)
+ *
+ */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_defs.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Target Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_MCU_LINUX
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Compiler Abstraction
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_COMPILER_GCC
+#define HAL_MCU_LITTLE_ENDIAN()   (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define HAL_ISR_FUNC_DECLARATION(f,v)   void f(void)
+#define HAL_ISR_FUNC_PROTOTYPE(f,v)     void f(void)
+#define HAL_ISR_FUNCTION(f,v)           HAL_ISR_FUNC_PROTOTYPE(f,v); HAL_ISR_FUNC_DECLARATION(f,v)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Interrupt Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void halLinuxLock( void );
+extern void halLinuxUnlock( void );
+
+/* Nothing to mask globally on the host; the other threads are only held
+ * off for the length of a critical section.
+ */
+#define HAL_ENABLE_INTERRUPTS()
+#define HAL_DISABLE_INTERRUPTS()
+#define HAL_INTERRUPTS_ARE_ENABLED()    (1)
+
+typedef unsigned char halIntState_t;
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = 1;  halLinuxLock(); )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( (void)x;  halLinuxUnlock(); )
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s); )
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Reset Macro
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void halLinuxReset( void );
+
+#define WD_KICK()
+#define HAL_SYSTEM_RESET()  halLinuxReset()
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Sleep Macro
+ * ------------------------------------------------------------------------------------------------
+ */
+#define CLEAR_SLEEP_MODE()
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,71 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+
+  Description:    Types and memory attributes of the Linux host port, in
+                  place of the CC2530 target header. The widths match the
+                  8051 build so that OSAL code and its 16/32-bit arithmetic
+                  behave the same on the host.
+**************************************************************************************************/
+
+#ifndef _HAL_TYPES_H
+#define _HAL_TYPES_H
+
+/* Linux host */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                               Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+
+/* ------------------------------------------------------------------------------------------------
+ *                                               Types
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef int8_t          int8;
+typedef uint8_t         uint8;
+
+typedef int16_t         int16;
+typedef uint16_t        uint16;
+
+typedef int32_t         int32;
+typedef uint32_t        uint32;
+
+typedef unsigned char   bool;
+
+/* Blocks of the OSAL heap keep a 2-byte header as on the CC2530, so the
+ * memory osal_mem_alloc() returns is only 2-byte aligned whatever this type
+ * is. x86 and ARMv8 hosts access misaligned pointers and floats in normal
+ * memory; build with -fno-sanitize=alignment when using UBSan.
+ */
+typedef uint8           halDataAlign_t;
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Memory Attributes
+ * ------------------------------------------------------------------------------------------------
+ */
+#define  CODE
+#define  XDATA
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Standard Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,353 @@
+/**************************************************************************************************
+  Filename:       NodeReg_Test.c
+
+  Description:    Host test of the coordinator node registry (NodeReg.c).
+
+                  Fixed cases cover the slot hint, refresh after a rejoin,
+                  a full table, tombstones between colliding addresses and
+                  a restart with fewer slots. A random run then registers
+                  and removes nodes against a plain model of the registry,
+                  checks every lookup after each step and restarts the
+                  registry from NV now and then; nothing may change across
+                  a restart.
+
+                  Usage: nodereg_test [steps] [seed]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Nv.h"
+
+#include "NodeReg.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_SLOTS      8
+#define TEST_NODES      (TEST_SLOTS + 4)
+#define TEST_STEPS      20000
+
+#define CHECK( c )                                                      \
+  do {                                                                  \
+    if ( !(c) )                                                         \
+    {                                                                   \
+      printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #c );             \
+      testFailures++;                                                   \
+    }                                                                   \
+  } while ( 0 )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint8  ieee[Z_EXTADDR_LEN];
+  uint16 shortAddr;
+  uint8  slot;                           // NODE_REG_NONE if not registered
+} testNode_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// OSAL.c is linked in for osal_memcpy() and friends; it has no tasks here.
+const pTaskEventHandlerFn tasksArr[] = { NULL };
+const uint8 tasksCnt = 0;
+uint16 *tasksEvents;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static testNode_t testNode[TEST_NODES];
+static unsigned testFailures;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   No tasks.
+ */
+void osalInitTasks( void )
+{
+}
+
+/*********************************************************************
+ * @fn      testHash
+ *
+ * @brief   Same as NodeReg_Hash(), to build colliding addresses.
+ */
+static uint8 testHash( const uint8 *ieee )
+{
+  uint8 h = 0;
+  uint8 i;
+
+  for ( i = 0; i < Z_EXTADDR_LEN; i++ )
+  {
+    h = (uint8)((h << 1) | (h >> 7)) ^ ieee[i];
+  }
+  return h & (NODE_REG_SIZE - 1);
+}
+
+/*********************************************************************
+ * @fn      testIeee
+ *
+ * @brief   Address number n; addresses that hash to bucket are picked
+ *          when bucket is not NODE_REG_NONE.
+ */
+static void testIeee( uint8 *ieee, uint16 n, uint8 bucket )
+{
+  uint16 k = 0;
+
+  do
+  {
+    ieee[0] = LO_UINT16( n );
+    ieee[1] = HI_UINT16( n );
+    ieee[2] = LO_UINT16( k );
+    ieee[3] = HI_UINT16( k );
+    ieee[4] = 0x00;
+    ieee[5] = 0x4B;
+    ieee[6] = 0x12;
+    ieee[7] = 0x00;
+    k++;
+  } while ( bucket != NODE_REG_NONE && testHash( ieee ) != bucket );
+}
+
+/*********************************************************************
+ * @fn      testReset
+ *
+ * @brief   Erase NV and start an empty registry.
+ */
+static void testReset( uint8 slots )
+{
+  osal_nv_init( NULL );
+  NodeReg_Init( slots );
+}
+
+/*********************************************************************
+ * @fn      testFixed
+ *
+ * @brief   The hand-written cases.
+ */
+static void testFixed( void )
+{
+  uint8 ieee[6][Z_EXTADDR_LEN];
+  nodeRegEntry_t *e;
+  uint8 i;
+
+  // The hint is taken if it is free, else the lowest free slot.
+  testReset( 4 );
+  for ( i = 0; i < 6; i++ )
+  {
+    testIeee( ieee[i], i, NODE_REG_NONE );
+  }
+  CHECK( NodeReg_Register( ieee[0], 0x1001, 1, 2 ) == 2 );
+  CHECK( NodeReg_Register( ieee[1], 0x1002, 2, 2 ) == 0 );
+  CHECK( NodeReg_Register( ieee[2], 0x1003, 3, 9 ) == 1 );
+  CHECK( NodeReg_Register( ieee[3], 0x1004, 4, 0 ) == 3 );
+  CHECK( NodeReg_Count() == 4 );
+
+  // Full.
+  CHECK( NodeReg_Register( ieee[4], 0x1005, 5, 0 ) == NODE_REG_NONE );
+  CHECK( NodeReg_Find( ieee[4] ) == NULL );
+
+  // A rejoin keeps the slot and updates the short address.
+  CHECK( NodeReg_Register( ieee[0], 0x2001, 1, 0 ) == 2 );
+  e = NodeReg_Slot( 2 );
+  CHECK( e != NULL && e->shortAddr == 0x2001 && osal_memcmp( e->ieee, ieee[0], Z_EXTADDR_LEN ) );
+
+  // The slot of a removed node is reused.
+  CHECK( NodeReg_Remove( ieee[1] ) == TRUE );
+  CHECK( NodeReg_Remove( ieee[1] ) == FALSE );
+  CHECK( NodeReg_Slot( 0 ) == NULL );
+  CHECK( NodeReg_Register( ieee[4], 0x1005, 5, 3 ) == 0 );
+
+  // A restart with fewer slots drops the nodes beyond them.
+  NodeReg_Init( 2 );
+  CHECK( NodeReg_Count() == 2 );
+  CHECK( NodeReg_Find( ieee[0] ) == NULL );
+  CHECK( NodeReg_Find( ieee[3] ) == NULL );
+  CHECK( NodeReg_Find( ieee[4] ) != NULL && NodeReg_Find( ieee[4] )->slot == 0 );
+  CHECK( NodeReg_Find( ieee[2] ) != NULL && NodeReg_Find( ieee[2] )->slot == 1 );
+
+  // Colliding addresses: removing the first keeps the others reachable,
+  // and a new one fills the tombstone.
+  testReset( TEST_SLOTS );
+  for ( i = 0; i < 4; i++ )
+  {
+    testIeee( ieee[i], 100 + i, 5 );
+    CHECK( NodeReg_Register( ieee[i], 0x3000 + i, i, i ) == i );
+  }
+  CHECK( NodeReg_Remove( ieee[0] ) == TRUE );
+  for ( i = 1; i < 4; i++ )
+  {
+    CHECK( NodeReg_Find( ieee[i] ) != NULL && NodeReg_Find( ieee[i] )->slot == i );
+  }
+  testIeee( ieee[4], 200, 5 );
+  CHECK( NodeReg_Register( ieee[4], 0x3004, 4, 0 ) == 0 );
+  for ( i = 1; i < 5; i++ )
+  {
+    CHECK( NodeReg_Find( ieee[i] ) != NULL && NodeReg_Find( ieee[i] )->slot == (i & 3) );
+  }
+  CHECK( NodeReg_Count() == 4 );
+}
+
+/*********************************************************************
+ * @fn      testVerify
+ *
+ * @brief   Every lookup of the registry against the model.
+ */
+static void testVerify( void )
+{
+  nodeRegEntry_t *e;
+  uint8 count = 0;
+  uint8 i, s;
+
+  for ( i = 0; i < TEST_NODES; i++ )
+  {
+    e = NodeReg_Find( testNode[i].ieee );
+    if ( testNode[i].slot == NODE_REG_NONE )
+    {
+      CHECK( e == NULL );
+      continue;
+    }
+    count++;
+    CHECK( e != NULL && e->slot == testNode[i].slot && e->shortAddr == testNode[i].shortAddr );
+    CHECK( NodeReg_Slot( testNode[i].slot ) == e );
+  }
+  CHECK( NodeReg_Count() == count );
+
+  for ( s = 0; s < TEST_SLOTS; s++ )
+  {
+    e = NodeReg_Slot( s );
+    if ( e != NULL )
+    {
+      for ( i = 0; i < TEST_NODES && testNode[i].slot != s; i++ )
+      {
+      }
+      CHECK( i < TEST_NODES && osal_memcmp( e->ieee, testNode[i].ieee, Z_EXTADDR_LEN ) );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Random registrations, rejoins, removals and restarts. Half of
+ *          the addresses collide, so the probe sequences get long and
+ *          run over tombstones.
+ */
+static void testRandom( unsigned long steps )
+{
+  testNode_t *node;
+  uint8 used[TEST_SLOTS];
+  uint8 count = 0;
+  uint16 shortAddr;
+  uint8 hint, slot, want;
+  unsigned long n, restarts = 0, full = 0;
+  uint8 i;
+
+  testReset( TEST_SLOTS );
+  osal_memset( used, FALSE, sizeof( used ) );
+  for ( i = 0; i < TEST_NODES; i++ )
+  {
+    testIeee( testNode[i].ieee, 1000 + i, (i & 1) ? 3 : NODE_REG_NONE );
+    testNode[i].slot = NODE_REG_NONE;
+  }
+
+  for ( n = 0; n < steps && testFailures == 0; n++ )
+  {
+    node = &testNode[rand() % TEST_NODES];
+
+    if ( rand() % 3 == 0 )
+    {
+      CHECK( NodeReg_Remove( node->ieee ) == ( node->slot != NODE_REG_NONE ) );
+      if ( node->slot != NODE_REG_NONE )
+      {
+        used[node->slot] = FALSE;
+        node->slot = NODE_REG_NONE;
+        count--;
+      }
+    }
+    else
+    {
+      hint = (uint8)( rand() % (TEST_SLOTS + 2) );
+      want = node->slot;
+      if ( want == NODE_REG_NONE && count < TEST_SLOTS )
+      {
+        want = hint;
+        if ( want >= TEST_SLOTS || used[want] )
+        {
+          for ( want = 0; used[want]; want++ )
+          {
+          }
+        }
+      }
+      shortAddr = (uint16)rand();
+      slot = NodeReg_Register( node->ieee, shortAddr, 0, hint );
+      CHECK( slot == want );
+      if ( slot == NODE_REG_NONE )
+      {
+        full++;
+      }
+      else
+      {
+        node->shortAddr = shortAddr;
+        if ( node->slot == NODE_REG_NONE )
+        {
+          used[slot] = TRUE;
+          count++;
+        }
+        node->slot = slot;
+      }
+    }
+
+    if ( rand() % 64 == 0 )
+    {
+      NodeReg_Init( TEST_SLOTS );
+      restarts++;
+    }
+    testVerify();
+  }
+
+  printf( "random: %lu steps, %lu restarts, %lu registrations refused as full\n",
+          n, restarts, full );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the fixed cases and the random run.
+ *
+ * @param   argc, argv - [steps] [seed]
+ *
+ * @return  EXIT_SUCCESS if every check passed
+ */
+int main( int argc, char *argv[] )
+{
+  unsigned long steps = argc > 1 ? strtoul( argv[1], NULL, 0 ) : TEST_STEPS;
+
+  srand( argc > 2 ? (unsigned)strtoul( argv[2], NULL, 0 ) : 1 );
+
+  testFixed();
+  testRandom( steps );
+
+  printf( "%s\n", testFailures ? "FAILED" : "ok" );
+  return testFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,250 @@
+/**************************************************************************************************
+  Filename:       OSAL_MsgBench.c
+
+  Description:    Host benchmark of the OSAL message queues: receive and
+                  send latency against the number of messages queued.
+
+                  For each depth, that many messages wait in the queues of
+                  the other tasks while the last task is sent a batch and
+                  receives it back. With the single global list of the
+                  original OSAL every receive scanned the messages queued
+                  ahead of the task's own, so its time grew with the
+                  depth; with a queue per task it should not. The order of
+                  the messages received and the queue high-water marks are
+                  checked, so a wrong queue makes the exit status non-zero.
+
+                  Usage: osal_msg_bench [rounds]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Memory.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !( OSAL_MSG_METRICS )
+  #error "The benchmark checks the queue high-water marks; build with OSAL_MSG_METRICS."
+#endif
+
+#define BENCH_TASKS       8
+#define BENCH_DEPTH_MAX   512
+#define BENCH_BATCH       32
+#define BENCH_ROUNDS      2000
+
+#define CHECK( c )                                                      \
+  do {                                                                  \
+    if ( !(c) )                                                         \
+    {                                                                   \
+      printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #c );             \
+      benchFailures++;                                                  \
+    }                                                                   \
+  } while ( 0 )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint16 seq;
+} benchMsg_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+static uint16 benchEvent( uint8 task_id, uint16 events );
+
+// The tasks only own queues; the benchmark sends and receives for them.
+const pTaskEventHandlerFn tasksArr[BENCH_TASKS] = {
+  benchEvent, benchEvent, benchEvent, benchEvent,
+  benchEvent, benchEvent, benchEvent, benchEvent
+};
+const uint8 tasksCnt = BENCH_TASKS;
+uint16 *tasksEvents;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static unsigned benchFailures;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      benchEvent
+ *
+ * @brief   Never run.
+ */
+static uint16 benchEvent( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Only the event words.
+ */
+void osalInitTasks( void )
+{
+  tasksEvents = (uint16 *)osal_mem_alloc( sizeof( uint16 ) * tasksCnt );
+  osal_memset( tasksEvents, 0, sizeof( uint16 ) * tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      benchNow
+ *
+ * @brief   Monotonic time in ns.
+ */
+static double benchNow( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      benchSend
+ *
+ * @brief   Send a message numbered seq to a task.
+ */
+static void benchSend( uint8 task, uint16 seq )
+{
+  benchMsg_t *msg = (benchMsg_t *)osal_msg_allocate( sizeof( benchMsg_t ) );
+
+  if ( msg == NULL )
+  {
+    printf( "FAIL heap full\n" );
+    exit( EXIT_FAILURE );
+  }
+  msg->hdr.event = 0x01;
+  msg->seq = seq;
+  CHECK( osal_msg_send( task, (uint8 *)msg ) == SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      benchDepth
+ *
+ * @brief   Time send and receive of the last task with depth messages
+ *          queued for the others.
+ *
+ * @param   depth  - messages queued ahead
+ * @param   rounds - batches to time
+ *
+ * @return  none
+ */
+static void benchDepth( uint16 depth, unsigned long rounds )
+{
+  benchMsg_t *msg[BENCH_BATCH];
+  const uint8 last = BENCH_TASKS - 1;
+  double t0, tSend = 0, tRecv = 0;
+  unsigned long r;
+  uint16 seq = 0;
+  uint16 i;
+  uint8 task;
+
+  for ( i = 0; i < depth; i++ )
+  {
+    benchSend( i % last, i );
+  }
+
+  for ( r = 0; r < rounds; r++ )
+  {
+    // Allocation is not part of the send time.
+    for ( i = 0; i < BENCH_BATCH; i++ )
+    {
+      msg[i] = (benchMsg_t *)osal_msg_allocate( sizeof( benchMsg_t ) );
+      msg[i]->hdr.event = 0x01;
+      msg[i]->seq = (uint16)( seq + i );
+    }
+    t0 = benchNow();
+    for ( i = 0; i < BENCH_BATCH; i++ )
+    {
+      osal_msg_send( last, (uint8 *)msg[i] );
+    }
+    tSend += benchNow() - t0;
+
+    t0 = benchNow();
+    for ( i = 0; i < BENCH_BATCH; i++ )
+    {
+      msg[i] = (benchMsg_t *)osal_msg_receive( last );
+    }
+    tRecv += benchNow() - t0;
+
+    for ( i = 0; i < BENCH_BATCH; i++ )
+    {
+      CHECK( msg[i] != NULL && msg[i]->seq == (uint16)( seq + i ) );
+      osal_msg_deallocate( (uint8 *)msg[i] );
+    }
+    seq += BENCH_BATCH;
+  }
+  CHECK( osal_msg_receive( last ) == NULL );
+
+  // The others still hold theirs, in order.
+  for ( task = 0; task < last; task++ )
+  {
+    for ( i = task; i < depth; i += last )
+    {
+      msg[0] = (benchMsg_t *)osal_msg_receive( task );
+      CHECK( msg[0] != NULL && msg[0]->seq == i );
+      if ( msg[0] != NULL )
+      {
+        osal_msg_deallocate( (uint8 *)msg[0] );
+      }
+    }
+    CHECK( osal_msg_receive( task ) == NULL );
+    CHECK( osal_msg_q_high_water( task ) >= ( depth + last - 1 - task ) / last );
+  }
+  CHECK( osal_msg_q_high_water( last ) >= BENCH_BATCH );
+
+  printf( "%5u  %10.1f  %10.1f\n", depth,
+          tRecv / ( rounds * BENCH_BATCH ), tSend / ( rounds * BENCH_BATCH ) );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the depths from 0 to BENCH_DEPTH_MAX.
+ *
+ * @param   argc, argv - [rounds]
+ *
+ * @return  EXIT_SUCCESS if every check passed
+ */
+int main( int argc, char *argv[] )
+{
+  unsigned long rounds = argc > 1 ? strtoul( argv[1], NULL, 0 ) : BENCH_ROUNDS;
+  uint16 depth;
+
+  osal_init_system();
+
+  printf( "depth  ns/receive     ns/send\n" );
+  benchDepth( 0, rounds );
+  for ( depth = 1; depth <= BENCH_DEPTH_MAX; depth *= 2 )
+  {
+    benchDepth( depth, rounds );
+  }
+
+  printf( "%s\n", benchFailures ? "FAILED" : "ok" );
+  return benchFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,56 @@
+/**************************************************************************************************
+  Filename:       OSAL_SerialApp_Linux.c
+
+  Description:    Task table of the SerialApp simulation on the Linux host.
+                  The MAC, NWK, APS and ZDO tasks of OSAL_SerialApp.c are
+                  replaced by the fake AF layer, which needs no task, so
+                  SerialApp is the only one.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "SerialApp.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// The order in this table must be identical to the task initialization calls below in osalInitTask.
+const pTaskEventHandlerFn tasksArr[] = {
+  SerialApp_ProcessEvent
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents;
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   This function invokes the initialization function for each task.
+ *
+ * @param   void
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  uint8 taskID = 0;
+
+  tasksEvents = (uint16 *)osal_mem_alloc( sizeof( uint16 ) * tasksCnt);
+  osal_memset( tasksEvents, 0, (sizeof( uint16 ) * tasksCnt));
+
+  SerialApp_Init( taskID );
+}
+
+/*********************************************************************
+*********************************************************************/
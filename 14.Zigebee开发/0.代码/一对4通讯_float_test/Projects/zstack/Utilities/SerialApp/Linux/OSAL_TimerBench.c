@@ -0,0 +1,241 @@
+/**************************************************************************************************
+  Filename:       OSAL_TimerBench.c
+
+  Description:    Host benchmark of the OSAL timers with 1 to 256 running.
+
+                  For each count, that many task/event timers run with
+                  random timeouts of up to 2 s and are started again as
+                  soon as they fire, for BENCH_TICKS msec of osalTimerUpdate()
+                  ticks. The time per tick, per restart of a running timer
+                  and per lookup is reported. Every timer must fire on the
+                  very tick it was due, the pool must refuse one timer
+                  more than OSAL_TIMER_POOL and the high-water mark must
+                  match, so a wrong wheel makes the exit status non-zero.
+
+                  Usage: osal_timer_bench [ticks] [seed]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !( OSAL_TIMER_METRICS )
+  #error "The benchmark checks the timer high-water mark; build with OSAL_TIMER_METRICS."
+#endif
+
+#define BENCH_TASKS       16
+#define BENCH_EVENTS      16                       // one timer per event bit
+#define BENCH_TIMERS      (BENCH_TASKS * BENCH_EVENTS)
+#define BENCH_TIMEOUT     2000
+#define BENCH_TICKS       10000UL
+
+#if ( OSAL_TIMER_POOL != BENCH_TIMERS )
+  #error "Build with OSAL_TIMER_POOL=256."
+#endif
+
+#define CHECK( c )                                                      \
+  do {                                                                  \
+    if ( !(c) )                                                         \
+    {                                                                   \
+      printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #c );             \
+      benchFailures++;                                                  \
+    }                                                                   \
+  } while ( 0 )
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+static uint16 benchEvent( uint8 task_id, uint16 events );
+
+// The tasks only own events; the benchmark reads and clears them.
+const pTaskEventHandlerFn tasksArr[BENCH_TASKS] = {
+  benchEvent, benchEvent, benchEvent, benchEvent,
+  benchEvent, benchEvent, benchEvent, benchEvent,
+  benchEvent, benchEvent, benchEvent, benchEvent,
+  benchEvent, benchEvent, benchEvent, benchEvent
+};
+const uint8 tasksCnt = BENCH_TASKS;
+uint16 *tasksEvents;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32 benchDue[BENCH_TIMERS];    // clock at which timer k fires
+static unsigned benchFailures;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      benchEvent
+ *
+ * @brief   Never run.
+ */
+static uint16 benchEvent( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Only the event words.
+ */
+void osalInitTasks( void )
+{
+  tasksEvents = (uint16 *)osal_mem_alloc( sizeof( uint16 ) * tasksCnt );
+  osal_memset( tasksEvents, 0, sizeof( uint16 ) * tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      benchNow
+ *
+ * @brief   Monotonic time in ns.
+ */
+static double benchNow( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      benchStart
+ *
+ * @brief   Start timer k with a random timeout.
+ */
+static void benchStart( uint16 k )
+{
+  uint16 timeout = 1 + rand() % BENCH_TIMEOUT;
+
+  CHECK( osal_start_timerEx( k / BENCH_EVENTS, BV( k % BENCH_EVENTS ), timeout ) == SUCCESS );
+  benchDue[k] = osal_GetSystemClock() + timeout;
+}
+
+/*********************************************************************
+ * @fn      benchCount
+ *
+ * @brief   Run n timers for the given number of ticks.
+ *
+ * @param   n     - timers
+ * @param   ticks - msec to run
+ *
+ * @return  none
+ */
+static void benchCount( uint16 n, unsigned long ticks )
+{
+  double t0, tTick = 0, tStart = 0, tFind = 0;
+  unsigned long t, fired = 0;
+  uint32 now;
+  uint16 k, events;
+  uint8 task;
+
+  osalTimerInit();
+  osal_memset( tasksEvents, 0, sizeof( uint16 ) * tasksCnt );
+  for ( k = 0; k < n; k++ )
+  {
+    benchStart( k );
+  }
+  CHECK( osal_timer_num_active() == n );
+
+  for ( t = 0; t < ticks; t++ )
+  {
+    t0 = benchNow();
+    osalTimerUpdate( 1 );
+    tTick += benchNow() - t0;
+    now = osal_GetSystemClock();
+
+    for ( task = 0; task < BENCH_TASKS; task++ )
+    {
+      events = tasksEvents[task];
+      tasksEvents[task] = 0;
+      for ( k = task * BENCH_EVENTS; events != 0; k++, events >>= 1 )
+      {
+        if ( events & 1 )
+        {
+          if ( k >= n || benchDue[k] != now )
+          {
+            printf( "FAIL timer %u fired at %lu, due at %lu\n", k,
+                    (unsigned long)now, (unsigned long)benchDue[k] );
+            benchFailures++;
+          }
+          benchStart( k );
+          fired++;
+        }
+      }
+    }
+
+    // Restart a running timer, and look one up.
+    k = rand() % n;
+    t0 = benchNow();
+    (void)osal_start_timerEx( k / BENCH_EVENTS, BV( k % BENCH_EVENTS ), 1 + (uint16)( t % BENCH_TIMEOUT ) );
+    tStart += benchNow() - t0;
+    benchDue[k] = now + 1 + (uint16)( t % BENCH_TIMEOUT );
+
+    k = rand() % n;
+    t0 = benchNow();
+    CHECK( osal_get_timeoutEx( k / BENCH_EVENTS, BV( k % BENCH_EVENTS ) ) == benchDue[k] - now );
+    tFind += benchNow() - t0;
+  }
+
+  CHECK( osal_timer_num_active() == n );
+  CHECK( osal_timer_high_water() == n );
+  if ( n == BENCH_TIMERS )
+  {
+    // Every event of every task is running; a task past the table is
+    // the only new pair left, and it is never run since it is refused.
+    CHECK( osal_start_timerEx( BENCH_TASKS, 0x0001, 1 ) == NO_TIMER_AVAIL );
+  }
+
+  printf( "%5u  %8.1f  %9.1f  %8.1f  %8lu\n", n, tTick / ticks, tStart / ticks, tFind / ticks,
+          fired );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the counts from 1 to BENCH_TIMERS.
+ *
+ * @param   argc, argv - [ticks] [seed]
+ *
+ * @return  EXIT_SUCCESS if every check passed
+ */
+int main( int argc, char *argv[] )
+{
+  unsigned long ticks = argc > 1 ? strtoul( argv[1], NULL, 0 ) : BENCH_TICKS;
+  uint16 n;
+
+  srand( argc > 2 ? (unsigned)strtoul( argv[2], NULL, 0 ) : 1 );
+  osal_init_system();
+
+  printf( "timers  ns/tick  ns/start  ns/find     fired\n" );
+  for ( n = 1; n <= BENCH_TIMERS; n *= 2 )
+  {
+    benchCount( n, ticks );
+  }
+
+  printf( "%s\n", benchFailures ? "FAILED" : "ok" );
+  return benchFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,564 @@
+/**************************************************************************************************
+  Filename:       SerialApp_Fuzz.c
+
+  Description:    Fuzzes the receive path of a SerialApp end device on the
+                  Linux host port.
+
+                  The end device is built from the same SerialApp.c as on
+                  the target. It is fed random frames through
+                  afLinuxReceive(): slot assignments, beacons, key and
+                  delta frames built with SlotFrame.c, UART bridge data and
+                  garbage, most of them then mutated by bit flips,
+                  truncation or extension. Between frames simulated time
+                  advances a few ms and UART0 gets random bytes, so the
+                  uplink, announce and flush timers run too.
+
+                  The image is built with AF_LINUX_RX_IN_PLACE, so every
+                  frame is delivered in a buffer of exactly its length and
+                  a read past its end is caught by the sanitizers of a
+                  -fsanitize=address,undefined build. Every uplink the
+                  device sends must pass SlotFrame_Check() for a slot below
+                  MAX_NODE, every announce must carry the node number of
+                  the build, and the heap must hold no more blocks or
+                  bytes in use at the end than after start-up.
+
+                  Usage: serialapp_fuzz [-n frames] [-r seed] [-v]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Memory.h"
+#include "OSAL_Nv.h"
+#include "OnBoard.h"
+#include "ZDApp.h"
+#include "hal_uart.h"
+#include "hal_linux.h"
+#include "AF_Linux.h"
+
+#include "SerialApp.h"
+#include "SlotFrame.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if defined( ZDO_COORDINATOR )
+  #error "The fuzz target is an end device; build SerialApp without ZDO_COORDINATOR."
+#endif
+
+#if !( AF_LINUX_RX_IN_PLACE )
+  #error "Build with AF_LINUX_RX_IN_PLACE=TRUE so that over-reads are seen."
+#endif
+
+// Must match SerialApp.c.
+#if !defined( MAX_NODE )
+#define MAX_NODE  4
+#endif
+#if !defined( SUM_NUM )
+#define SUM_NUM  1
+#endif
+#if !defined( SERIAL_APP_NODE_ID )
+#define SERIAL_APP_NODE_ID  0
+#endif
+
+// Frames of SerialApp.c.
+#define FUZZ_ADDR_INFO        0x3B
+#define FUZZ_ADDR_INFO_LEN    13
+#define FUZZ_SLOT_ASSIGN      0x3D
+#define FUZZ_SLOT_ASSIGN_LEN  10
+#define FUZZ_BEACON_SOF       0x40
+#define FUZZ_BEACON_HDR_LEN   5
+#define FUZZ_MAP_LEN          ((MAX_NODE + 7) / 8)
+
+// Longest frame fed, past AF_LINUX_MTU on purpose.
+#define FUZZ_LEN_MAX          160
+
+// Defaults of the command line.
+#define FUZZ_FRAMES           200000UL
+#define FUZZ_SEED             1
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint32 frames;                         // frames fed
+  uint32 mutated;
+  uint32 bytes;
+  uint32 uplinks;                        // slot frames the device sent
+  uint32 announces;
+  uint32 bridged;                        // UART0 bytes the device sent OTA
+  uint32 uartIn;
+  uint32 uartOut;
+  uint32 bad;                            // checks failed
+} fuzzStats_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static fuzzStats_t fuzzStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static ZStatus_t fuzzAfTx( afAddrType_t *dstAddr, uint8 srcEP, uint16 clusterID,
+                           uint16 len, uint8 *buf );
+static void fuzzUartTx( uint8 port, uint8 *buf, uint16 len );
+static uint8 fuzzXor( const uint8 *buf, uint16 len );
+static uint16 fuzzFrame( uint8 *buf, uint16 *clusterID );
+static uint16 fuzzMutate( uint8 *buf, uint16 len );
+static void fuzzDeliver( uint16 srcAddr, uint16 clusterID, const uint8 *frame, uint16 len );
+static void fuzzUartFeed( void );
+static void fuzzRun( void );
+
+/*********************************************************************
+ * @fn      fuzzAfTx
+ *
+ * @brief   Every data request of the end device. Uplinks must be intact
+ *          slot frames of a slot in range. One confirm in eight fails,
+ *          so the rate controller backs off now and then.
+ *
+ * @param   dstAddr   - destination
+ * @param   srcEP     - source endpoint
+ * @param   clusterID - cluster
+ * @param   len       - frame length
+ * @param   buf       - frame
+ *
+ * @return  status of the data confirm
+ */
+static ZStatus_t fuzzAfTx( afAddrType_t *dstAddr, uint8 srcEP, uint16 clusterID,
+                           uint16 len, uint8 *buf )
+{
+  (void)dstAddr;
+  (void)srcEP;
+
+  if ( len > AF_LINUX_MTU )
+  {
+    printf( "FAIL request of %u bytes past the MTU\n", len );
+    fuzzStats.bad++;
+  }
+
+  if ( clusterID == SERIALAPP_CLUSTERID2 )
+  {
+    fuzzStats.bridged += len;
+  }
+  else if ( len != 0 && buf[0] == SLOT_FRAME_SOF )
+  {
+    fuzzStats.uplinks++;
+    if ( len < SLOT_FRAME_OVERHEAD || buf[3] >= MAX_NODE ||
+         !SlotFrame_Check( buf, len, buf[3] ) )
+    {
+      printf( "FAIL uplink of %u bytes for slot %u\n", len, len > 3 ? buf[3] : 0xFF );
+      fuzzStats.bad++;
+    }
+  }
+  else if ( len != 0 && buf[0] == FUZZ_ADDR_INFO )
+  {
+    // The preferred node number of the build, not one taken from a slot.
+    fuzzStats.announces++;
+    if ( len != FUZZ_ADDR_INFO_LEN ||
+         BUILD_UINT16( buf[12], buf[11] ) != SERIAL_APP_NODE_ID )
+    {
+      printf( "FAIL announce of %u bytes\n", len );
+      fuzzStats.bad++;
+    }
+  }
+
+  return ( rand() % 8 ) ? ZSuccess : ZFailure;
+}
+
+/*********************************************************************
+ * @fn      fuzzUartTx
+ *
+ * @brief   Count what the end device writes to UART0.
+ *
+ * @param   port - UART port
+ * @param   buf  - bytes written
+ * @param   len  - number of bytes
+ *
+ * @return  none
+ */
+static void fuzzUartTx( uint8 port, uint8 *buf, uint16 len )
+{
+  (void)port;
+  (void)buf;
+  fuzzStats.uartOut += len;
+}
+
+/*********************************************************************
+ * @fn      fuzzXor
+ *
+ * @brief   XOR of len bytes, as XorCheckSum() in SerialApp.c.
+ *
+ * @param   buf - bytes
+ * @param   len - number of bytes
+ *
+ * @return  checksum
+ */
+static uint8 fuzzXor( const uint8 *buf, uint16 len )
+{
+  uint8 x = 0;
+
+  while ( len-- )
+  {
+    x ^= *buf++;
+  }
+  return x;
+}
+
+/*********************************************************************
+ * @fn      fuzzFrame
+ *
+ * @brief   A random frame of a kind the end device understands, most of
+ *          them well formed.
+ *
+ * @param   buf       - at least FUZZ_LEN_MAX bytes
+ * @param   clusterID - cluster to send it on
+ *
+ * @return  frame length
+ */
+static uint16 fuzzFrame( uint8 *buf, uint16 *clusterID )
+{
+  float data[MAX_NODE * SLOT_FRAME_M_MAX];
+  float key[MAX_NODE * SLOT_FRAME_M_MAX];
+  int8 exp[SLOT_FRAME_M_MAX];
+  uint8 m, count, first, i;
+  uint16 len;
+
+  *clusterID = SERIALAPP_CLUSTERID;
+  m = 1 + rand() % SLOT_FRAME_M_MAX;
+  first = rand() % (MAX_NODE + 2);
+
+  switch ( rand() % 8 )
+  {
+    case 0:
+      buf[0] = FUZZ_SLOT_ASSIGN;
+      osal_memcpy( &buf[1], afLinuxExtAddr, Z_EXTADDR_LEN );
+      if ( rand() % 8 == 0 )
+      {
+        buf[1 + rand() % Z_EXTADDR_LEN] ^= 0x01;
+      }
+      buf[9] = first;
+      return FUZZ_SLOT_ASSIGN_LEN;
+
+    case 1:
+    case 2:
+      len = rand() % (FUZZ_MAP_LEN + 2);
+      buf[0] = FUZZ_BEACON_SOF;
+      buf[1] = (uint8)rand();
+      buf[2] = rand() % 32;              // guard, ms
+      buf[3] = rand() % 32;              // slot length, ms
+      buf[4] = (uint8)len;
+      for ( i = 0; i < len; i++ )
+      {
+        buf[FUZZ_BEACON_HDR_LEN + i] = (uint8)rand();
+      }
+      len += FUZZ_BEACON_HDR_LEN;
+      buf[len] = fuzzXor( &buf[1], len - 1 );
+      buf[len + 1] = SLOT_FRAME_EOF;
+      return len + 2;
+
+    case 3:
+    case 4:
+      count = 1 + rand() % SlotFrame_Capacity( AF_LINUX_MTU, m, FALSE );
+      if ( count > MAX_NODE )
+      {
+        count = MAX_NODE;
+      }
+      for ( i = 0; i < count * m; i++ )
+      {
+        data[i] = (float)( rand() % 20001 - 10000 ) / 8;
+      }
+      return SlotFrame_Build( buf, (uint8)rand(), rand() % 4, first, count, m, data );
+
+    case 5:
+      count = 1 + rand() % SlotFrame_Capacity( AF_LINUX_MTU, m, TRUE );
+      if ( count > MAX_NODE )
+      {
+        count = MAX_NODE;
+      }
+      for ( i = 0; i < m; i++ )
+      {
+        exp[i] = (int8)( -( rand() % 8 ) );
+      }
+      for ( i = 0; i < count * m; i++ )
+      {
+        key[i] = (float)( rand() % 20001 - 10000 ) / 8;
+        data[i] = key[i] + (float)( rand() % 2001 - 1000 ) / 64;
+      }
+      return SlotFrame_BuildDelta( buf, (uint8)rand(), rand() % 4, first, count, m,
+                                   data, key, exp );
+
+    case 6:
+      *clusterID = SERIALAPP_CLUSTERID2;
+      len = rand() % (AF_LINUX_MTU + 1);
+      for ( i = 0; i < len; i++ )
+      {
+        buf[i] = (uint8)rand();
+      }
+      return len;
+
+    default:
+      len = rand() % (FUZZ_LEN_MAX + 1);
+      for ( i = 0; i < len; i++ )
+      {
+        buf[i] = (uint8)rand();
+      }
+      if ( len != 0 )
+      {
+        static const uint8 sof[] = { SLOT_FRAME_SOF, SLOT_FRAME_DELTA_SOF,
+                                     FUZZ_SLOT_ASSIGN, FUZZ_BEACON_SOF };
+
+        buf[0] = sof[rand() % sizeof( sof )];
+      }
+      return len;
+  }
+}
+
+/*********************************************************************
+ * @fn      fuzzMutate
+ *
+ * @brief   Flip a few bits, cut the frame short or pad it out. Half the
+ *          time the checksum and end byte are then made right again, so
+ *          that the frame gets past them to the length checks.
+ *
+ * @param   buf - frame, FUZZ_LEN_MAX bytes of room
+ * @param   len - its length
+ *
+ * @return  new length
+ */
+static uint16 fuzzMutate( uint8 *buf, uint16 len )
+{
+  uint8 n;
+
+  switch ( rand() % 4 )
+  {
+    case 0:
+      for ( n = 1 + rand() % 3; n && len; n-- )
+      {
+        buf[rand() % len] ^= BV( rand() % 8 );
+      }
+      break;
+
+    case 1:
+      len = len ? rand() % len : 0;
+      break;
+
+    case 2:
+      for ( n = 1 + rand() % 16; n && len < FUZZ_LEN_MAX; n-- )
+      {
+        buf[len++] = (uint8)rand();
+      }
+      break;
+
+    default:
+      if ( len > 5 )
+      {
+        buf[2 + rand() % 4] = (uint8)rand();     // header fields
+      }
+      break;
+  }
+
+  if ( len >= 3 && rand() % 2 )
+  {
+    buf[len - 2] = fuzzXor( &buf[1], len - 3 );
+    buf[len - 1] = SLOT_FRAME_EOF;
+  }
+  return len;
+}
+
+/*********************************************************************
+ * @fn      fuzzDeliver
+ *
+ * @brief   Deliver a frame in a heap copy of exactly its length and
+ *          process it before the copy is freed.
+ *
+ * @param   srcAddr   - short address of the sender
+ * @param   clusterID - cluster
+ * @param   frame     - frame
+ * @param   len       - its length
+ *
+ * @return  none
+ */
+static void fuzzDeliver( uint16 srcAddr, uint16 clusterID, const uint8 *frame, uint16 len )
+{
+  uint8 *copy = malloc( len ? len : 1 );
+
+  if ( copy == NULL )
+  {
+    abort();
+  }
+  memcpy( copy, frame, len );
+  (void)afLinuxReceive( srcAddr, SERIALAPP_ENDPOINT, SERIALAPP_ENDPOINT, clusterID,
+                        len, copy, srcAddr != 0x0000 );
+  fuzzRun();
+  free( copy );
+
+  fuzzStats.frames++;
+  fuzzStats.bytes += len;
+}
+
+/*********************************************************************
+ * @fn      fuzzUartFeed
+ *
+ * @brief   A few random bytes on UART0 now and then.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void fuzzUartFeed( void )
+{
+  uint8 buf[16];
+  uint8 n, i;
+
+  if ( rand() % 4 )
+  {
+    return;
+  }
+  n = 1 + rand() % sizeof( buf );
+  for ( i = 0; i < n; i++ )
+  {
+    buf[i] = (uint8)rand();
+  }
+  fuzzStats.uartIn += halLinuxUartFeed( HAL_UART_PORT_0, buf, n );
+}
+
+/*********************************************************************
+ * @fn      fuzzRun
+ *
+ * @brief   Run OSAL passes until no task has an event left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void fuzzRun( void )
+{
+  uint8 busy;
+  uint8 i;
+
+  do
+  {
+    osal_start_system();
+
+    busy = FALSE;
+    for ( i = 0; i < tasksCnt; i++ )
+    {
+      if ( tasksEvents[i] )
+      {
+        busy = TRUE;
+      }
+    }
+  } while ( busy );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Start the end device and feed it the frames.
+ *
+ * @param   argc, argv - command line
+ *
+ * @return  EXIT_SUCCESS if every check passed
+ */
+int main( int argc, char *argv[] )
+{
+  uint8 buf[FUZZ_LEN_MAX];
+  unsigned long frames = FUZZ_FRAMES, n;
+  unsigned seed = FUZZ_SEED;
+  uint16 len, clusterID, blocks, bytes;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "n:r:v" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 'n':
+        frames = strtoul( optarg, NULL, 0 );
+        break;
+      case 'r':
+        seed = (unsigned)strtoul( optarg, NULL, 0 );
+        break;
+      case 'v':
+        halLinuxVerbose = TRUE;
+        break;
+      default:
+        fprintf( stderr, "usage: %s [-n frames] [-r seed] [-v]\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+  }
+  srand( seed );
+
+  halLinuxUartTxHook( fuzzUartTx );
+  afLinuxTxHook( fuzzAfTx );
+  afLinuxShortAddr = 0x1001;
+
+  osal_nv_init( NULL );
+  osal_init_system();
+  afLinuxStateChange( DEV_END_DEVICE );
+  fuzzRun();
+  // Free blocks split or merged by the run are not leaks; count those in use.
+  blocks = osal_heap_block_cnt() - osal_heap_block_free();
+  bytes = osal_heap_mem_used();
+
+  for ( n = 0; n < frames; n++ )
+  {
+    len = fuzzFrame( buf, &clusterID );
+    if ( rand() % 4 != 0 )
+    {
+      len = fuzzMutate( buf, len );
+      fuzzStats.mutated++;
+    }
+    fuzzDeliver( ( rand() % 4 ) ? 0x0000 : (uint16)( 1 + rand() % 3 ), clusterID, buf, len );
+
+    halLinuxAdvance( 1000UL * ( rand() % 8 ) );
+    fuzzUartFeed();
+    fuzzRun();
+  }
+
+  // Let every timer and confirm run out before the heap is counted.
+  for ( n = 0; n < 10000; n++ )
+  {
+    halLinuxAdvance( 1000 );
+    fuzzRun();
+  }
+  if ( osal_heap_block_cnt() - osal_heap_block_free() > blocks || osal_heap_mem_used() > bytes )
+  {
+    printf( "FAIL heap holds %u blocks, %u bytes in use, %u and %u after start-up\n",
+            osal_heap_block_cnt() - osal_heap_block_free(), osal_heap_mem_used(), blocks, bytes );
+    fuzzStats.bad++;
+  }
+
+  printf( "frames         %lu fed, %lu mutated, %lu bytes\n",
+          (unsigned long)fuzzStats.frames, (unsigned long)fuzzStats.mutated,
+          (unsigned long)fuzzStats.bytes );
+  printf( "sent           %lu uplinks, %lu announces, %lu bytes bridged OTA\n",
+          (unsigned long)fuzzStats.uplinks, (unsigned long)fuzzStats.announces,
+          (unsigned long)fuzzStats.bridged );
+  printf( "uart0          %lu in, %lu out\n",
+          (unsigned long)fuzzStats.uartIn, (unsigned long)fuzzStats.uartOut );
+#if ( OSALMEM_METRICS )
+  printf( "heap           %u blocks now, %u max, %u bytes used\n",
+          osal_heap_block_cnt(), osal_heap_block_max(), osal_heap_mem_used() );
+#endif
+  printf( "%s\n", fuzzStats.bad ? "FAILED" : "ok" );
+
+  return ( fuzzStats.bad == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*********************************************************************
+*********************************************************************/
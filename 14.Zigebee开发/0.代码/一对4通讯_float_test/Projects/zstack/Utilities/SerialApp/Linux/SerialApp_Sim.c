@@ -0,0 +1,564 @@
+/**************************************************************************************************
+  Filename:       SerialApp_Sim.c
+
+  Description:    Runs the SerialApp coordinator on the Linux host port
+                  against simulated end devices.
+
+                  The end devices live here, on top of the fake AF layer:
+                  each announces itself until the coordinator assigns it a
+                  slot, then answers every beacon with a keyframe in its
+                  uplink slot. Meanwhile UART0 is fed at a fixed rate, which
+                  the coordinator bridges OTA. Simulated time advances 1 ms
+                  at a time, and after each step OSAL runs until no task has
+                  an event left. Every report frame the coordinator writes
+                  to UART0 is checked against the values the devices sent.
+
+                  At the end the wall time per simulated ms and per OSAL
+                  pass, the traffic and the heap, pool and queue metrics
+                  are printed; a value reported wrong makes the exit status
+                  non-zero.
+
+                  Usage: serialapp_sim [-s seconds] [-u uart bytes/s] [-v]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Memory.h"
+#include "OSAL_Nv.h"
+#include "OnBoard.h"
+#include "ZDApp.h"
+#include "hal_key.h"
+#include "hal_uart.h"
+#include "hal_linux.h"
+#include "AF_Linux.h"
+
+#include "SerialApp.h"
+#include "SlotFrame.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined( ZDO_COORDINATOR )
+  #error "The simulation plays the end devices; build SerialApp as the coordinator."
+#endif
+
+// Must match SerialApp.c.
+#if !defined( MAX_NODE )
+#define MAX_NODE  4
+#endif
+#if !defined( SUM_NUM )
+#define SUM_NUM  1
+#endif
+
+// Frames of SerialApp.c the end devices understand.
+#define SIM_ADDR_INFO       0x3B
+#define SIM_ADDR_INFO_LEN   13
+#define SIM_SLOT_ASSIGN     0x3D
+#define SIM_SLOT_ASSIGN_LEN 10
+#define SIM_BEACON_SOF      0x40
+#define SIM_BEACON_HDR_LEN  5
+#define SIM_REPORT_SOF      0x41
+#define SIM_REPORT_HDR_LEN  4
+
+// Defaults of the command line.
+#define SIM_SECONDS         60
+#define SIM_UART_RATE       1000      // bytes per second
+
+// When the key that starts the superframes is pressed, in ms.
+#define SIM_KEY_MS          100
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint16 shortAddr;
+  uint16 id;
+  uint8  ieee[Z_EXTADDR_LEN];
+  uint8  slot;                           // SLOT_FRAME_NONE until assigned
+  uint8  seq;                            // sequence of the last beacon
+  uint32 announceAt;                     // usec, 0 if none is due
+  uint32 uplinkAt;                       // usec, 0 if none is due
+  float  value;                          // last value sent
+} simNode_t;
+
+typedef struct
+{
+  uint32 passes;                         // osal_start_system() calls
+  uint32 beacons;
+  uint32 tables;                         // slot-table frames sent OTA
+  uint32 uplinks;
+  uint32 reports;                        // report frames on UART0
+  uint32 slots;                          // slots reported right
+  uint32 bad;                            // slots reported wrong
+  uint32 uartIn;                         // bytes fed to UART0
+  uint32 uartDrop;                       // bytes that did not fit
+  uint32 uartOut;                        // bytes written to UART0
+  uint32 airBytes;                       // UART0 bytes bridged OTA
+} simStats_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static simNode_t simNode[MAX_NODE];
+static simStats_t simStats;
+static uint32 simUartRate = SIM_UART_RATE;
+static uint32 simUartCredit;
+static uint8 simUartByte;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static ZStatus_t simAfTx( afAddrType_t *dstAddr, uint8 srcEP, uint16 clusterID,
+                          uint16 len, uint8 *buf );
+static void simUartTx( uint8 port, uint8 *buf, uint16 len );
+static void simBeacon( uint8 *buf, uint16 len );
+static void simAnnounce( simNode_t *node );
+static void simUplink( simNode_t *node );
+static void simUartFeed( void );
+static void simRun( void );
+static void simPrintStats( uint32 ms, double wall );
+
+/*********************************************************************
+ * @fn      simAfTx
+ *
+ * @brief   Every data request of the coordinator: the end devices pick
+ *          up their slot assignments and the beacons.
+ *
+ * @param   dstAddr   - destination
+ * @param   srcEP     - source endpoint
+ * @param   clusterID - cluster
+ * @param   len       - frame length
+ * @param   buf       - frame
+ *
+ * @return  ZSuccess, the status of the data confirm
+ */
+static ZStatus_t simAfTx( afAddrType_t *dstAddr, uint8 srcEP, uint16 clusterID,
+                          uint16 len, uint8 *buf )
+{
+  uint8 i;
+
+  (void)dstAddr;
+  (void)srcEP;
+
+  if ( clusterID == SERIALAPP_CLUSTERID2 )
+  {
+    simStats.airBytes += len;
+    return ZSuccess;
+  }
+  if ( len == 0 )
+  {
+    return ZSuccess;
+  }
+
+  switch ( buf[0] )
+  {
+    case SIM_SLOT_ASSIGN:
+      if ( len < SIM_SLOT_ASSIGN_LEN || buf[9] >= MAX_NODE )
+      {
+        break;
+      }
+      for ( i = 0; i < MAX_NODE; i++ )
+      {
+        if ( osal_memcmp( simNode[i].ieee, &buf[1], Z_EXTADDR_LEN ) )
+        {
+          simNode[i].slot = buf[9];
+          simNode[i].announceAt = 0;
+        }
+      }
+      break;
+
+    case SIM_BEACON_SOF:
+      simBeacon( buf, len );
+      break;
+
+    case SLOT_FRAME_SOF:
+    case SLOT_FRAME_DELTA_SOF:
+      simStats.tables++;
+      break;
+
+    default:
+      break;
+  }
+
+  return ZSuccess;
+}
+
+/*********************************************************************
+ * @fn      simBeacon
+ *
+ * @brief   Schedule the uplink of every device in the bitmap at its
+ *          rank, as SerialApp_Beacon() does; a device missing from it
+ *          announces itself again.
+ *
+ * @param   buf - beacon frame
+ * @param   len - its length
+ *
+ * @return  none
+ */
+static void simBeacon( uint8 *buf, uint16 len )
+{
+  uint32 now = halLinuxTime();
+  simNode_t *node;
+  uint8 i, j, rank;
+
+  if ( len < SIM_BEACON_HDR_LEN + 2 || len != SIM_BEACON_HDR_LEN + 2 + buf[4] )
+  {
+    return;
+  }
+  simStats.beacons++;
+
+  for ( i = 0; i < MAX_NODE; i++ )
+  {
+    node = &simNode[i];
+    if ( node->slot == SLOT_FRAME_NONE )
+    {
+      continue;
+    }
+    if ( (node->slot >> 3) >= buf[4] ||
+         !( buf[SIM_BEACON_HDR_LEN + (node->slot >> 3)] & BV( node->slot & 7 ) ) )
+    {
+      node->slot = SLOT_FRAME_NONE;
+      node->announceAt = now + 1000;
+      continue;
+    }
+
+    for ( j = 0, rank = 0; j < node->slot; j++ )
+    {
+      if ( buf[SIM_BEACON_HDR_LEN + (j >> 3)] & BV( j & 7 ) )
+      {
+        rank++;
+      }
+    }
+    node->seq = buf[1];
+    node->uplinkAt = now + 1000UL * ( buf[2] + (uint16)rank * buf[3] );
+  }
+}
+
+/*********************************************************************
+ * @fn      simAnnounce
+ *
+ * @brief   Send the address information of a device, and again after
+ *          SERIALAPP_ANNOUNCE_TIMEOUT unless a slot is assigned by then.
+ *
+ * @param   node - device
+ *
+ * @return  none
+ */
+static void simAnnounce( simNode_t *node )
+{
+  uint8 buf[SIM_ADDR_INFO_LEN];
+
+  buf[0] = SIM_ADDR_INFO;
+  buf[1] = HI_UINT16( node->shortAddr );
+  buf[2] = LO_UINT16( node->shortAddr );
+  osal_memcpy( &buf[3], node->ieee, Z_EXTADDR_LEN );
+  buf[11] = HI_UINT16( node->id );
+  buf[12] = LO_UINT16( node->id );
+
+  node->announceAt = halLinuxTime() + 1000UL * SERIALAPP_ANNOUNCE_TIMEOUT;
+  (void)afLinuxReceive( node->shortAddr, SERIALAPP_ENDPOINT, SERIALAPP_ENDPOINT,
+                        SERIALAPP_CLUSTERID, sizeof( buf ), buf, FALSE );
+}
+
+/*********************************************************************
+ * @fn      simUplink
+ *
+ * @brief   Send a new value of a device as a one-slot keyframe.
+ *
+ * @param   node - device
+ *
+ * @return  none
+ */
+static void simUplink( simNode_t *node )
+{
+  uint8 buf[SLOT_FRAME_OVERHEAD + SUM_NUM * sizeof( float )];
+  float value[SUM_NUM];
+  uint8 len, i;
+
+  node->value = 100.0f * node->id + node->seq;
+  for ( i = 0; i < SUM_NUM; i++ )
+  {
+    value[i] = node->value;
+  }
+
+  len = SlotFrame_Build( buf, node->seq, 0, node->slot, 1, SUM_NUM, value );
+  if ( afLinuxReceive( node->shortAddr, SERIALAPP_ENDPOINT, SERIALAPP_ENDPOINT,
+                       SERIALAPP_CLUSTERID, len, buf, FALSE ) == afStatus_SUCCESS )
+  {
+    simStats.uplinks++;
+  }
+}
+
+/*********************************************************************
+ * @fn      simUartTx
+ *
+ * @brief   Check the slots in every report frame against the value the
+ *          owner of the slot sent last.
+ *
+ * @param   port - UART port
+ * @param   buf  - bytes written
+ * @param   len  - number of bytes
+ *
+ * @return  none
+ */
+static void simUartTx( uint8 port, uint8 *buf, uint16 len )
+{
+  float value;
+  uint8 *p;
+  uint8 n, m, i;
+
+  (void)port;
+  simStats.uartOut += len;
+
+  if ( len < SIM_REPORT_HDR_LEN + 2 || buf[0] != SIM_REPORT_SOF )
+  {
+    return;
+  }
+  simStats.reports++;
+
+  n = buf[2];
+  m = buf[3];
+  p = &buf[SIM_REPORT_HDR_LEN];
+  if ( len != SIM_REPORT_HDR_LEN + 2 + (uint16)n * (1 + m * sizeof( float )) )
+  {
+    simStats.bad += n;
+    return;
+  }
+
+  while ( n-- )
+  {
+    osal_memcpy( &value, p + 1, sizeof( float ) );
+    for ( i = 0; i < MAX_NODE && simNode[i].slot != p[0]; i++ )
+    {
+    }
+    if ( i < MAX_NODE && value == simNode[i].value )
+    {
+      simStats.slots++;
+    }
+    else
+    {
+      simStats.bad++;
+    }
+    p += 1 + m * sizeof( float );
+  }
+}
+
+/*********************************************************************
+ * @fn      simUartFeed
+ *
+ * @brief   Feed UART0 its share of bytes for one ms.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void simUartFeed( void )
+{
+  uint8 buf[HAL_LINUX_UART_RX_MAX];
+  uint16 n, fed, i;
+
+  simUartCredit += simUartRate;
+  n = (uint16)( simUartCredit / 1000 );
+  simUartCredit %= 1000;
+  if ( n > sizeof( buf ) )
+  {
+    simStats.uartDrop += n - sizeof( buf );
+    n = sizeof( buf );
+  }
+
+  for ( i = 0; i < n; i++ )
+  {
+    buf[i] = simUartByte++;
+  }
+  fed = halLinuxUartFeed( HAL_UART_PORT_0, buf, n );
+  simStats.uartIn += fed;
+  simStats.uartDrop += n - fed;
+}
+
+/*********************************************************************
+ * @fn      simRun
+ *
+ * @brief   Run OSAL passes until no task has an event left. There is
+ *          always one pass, so the clock and the HAL are polled.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void simRun( void )
+{
+  uint8 busy;
+  uint8 i;
+
+  do
+  {
+    osal_start_system();
+    simStats.passes++;
+
+    busy = FALSE;
+    for ( i = 0; i < tasksCnt; i++ )
+    {
+      if ( tasksEvents[i] )
+      {
+        busy = TRUE;
+      }
+    }
+  } while ( busy );
+}
+
+/*********************************************************************
+ * @fn      simPrintStats
+ *
+ * @brief   Print the results of a run.
+ *
+ * @param   ms   - simulated time
+ * @param   wall - wall time in seconds
+ *
+ * @return  none
+ */
+static void simPrintStats( uint32 ms, double wall )
+{
+#if ( OSALMEM_SLABS ) && ( OSALMEM_METRICS )
+  osalMemSlabStats_t slab;
+  uint8 cls;
+#endif
+
+  printf( "simulated      %lu ms in %.3f s wall\n", (unsigned long)ms, wall );
+  printf( "cost           %.0f ns/ms, %.0f ns/pass, %lu passes\n",
+          wall * 1e9 / ms, wall * 1e9 / simStats.passes, (unsigned long)simStats.passes );
+  printf( "superframes    %lu beacons, %lu table frames, %lu uplinks\n",
+          (unsigned long)simStats.beacons, (unsigned long)simStats.tables,
+          (unsigned long)simStats.uplinks );
+  printf( "reports        %lu frames, %lu slots ok, %lu bad\n",
+          (unsigned long)simStats.reports, (unsigned long)simStats.slots,
+          (unsigned long)simStats.bad );
+  printf( "uart0          %lu in, %lu dropped, %lu bridged OTA, %lu out\n",
+          (unsigned long)simStats.uartIn, (unsigned long)simStats.uartDrop,
+          (unsigned long)simStats.airBytes, (unsigned long)simStats.uartOut );
+
+#if ( OSALMEM_METRICS )
+  printf( "heap           %u blocks now, %u max, %u bytes used\n",
+          osal_heap_block_cnt(), osal_heap_block_max(), osal_heap_mem_used() );
+#endif
+#if ( OSALMEM_SLABS ) && ( OSALMEM_METRICS )
+  for ( cls = 0; osal_mem_slab_stats( cls, &slab ) == SUCCESS; cls++ )
+  {
+    printf( "pool %3u B     %u/%u blocks max, %u hits, %u misses\n",
+            slab.blkSz, slab.blkMax, slab.blkCnt, slab.hit, slab.miss );
+  }
+#endif
+#if ( OSAL_MSG_METRICS )
+  printf( "queue          %u messages max\n", osal_msg_q_high_water( SerialApp_TaskID ) );
+#endif
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Start the coordinator and run the network for the given time.
+ *
+ * @param   argc, argv - command line
+ *
+ * @return  EXIT_SUCCESS if every slot was reported right
+ */
+int main( int argc, char *argv[] )
+{
+  struct timespec t0, t1;
+  uint32 ms = SIM_SECONDS * 1000UL;
+  uint32 t, now;
+  uint8 i;
+  int opt;
+
+  while ( (opt = getopt( argc, argv, "s:u:v" )) != -1 )
+  {
+    switch ( opt )
+    {
+      case 's':
+        ms = strtoul( optarg, NULL, 0 ) * 1000UL;
+        break;
+      case 'u':
+        simUartRate = strtoul( optarg, NULL, 0 );
+        break;
+      case 'v':
+        halLinuxVerbose = TRUE;
+        break;
+      default:
+        fprintf( stderr, "usage: %s [-s seconds] [-u uart bytes/s] [-v]\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+  }
+  if ( ms == 0 )
+  {
+    ms = 1000;
+  }
+
+  for ( i = 0; i < MAX_NODE; i++ )
+  {
+    simNode[i].shortAddr = 0x1001 + i;
+    simNode[i].id = i + 1;
+    osal_memcpy( simNode[i].ieee, afLinuxExtAddr, Z_EXTADDR_LEN );
+    simNode[i].ieee[0] = 0x10 + i;
+    simNode[i].slot = SLOT_FRAME_NONE;
+    simNode[i].announceAt = 10000UL * (i + 1);
+  }
+
+  halLinuxUartTxHook( simUartTx );
+  afLinuxTxHook( simAfTx );
+
+  osal_nv_init( NULL );
+  osal_init_system();
+  afLinuxStateChange( DEV_ZB_COORD );
+  simRun();
+
+  clock_gettime( CLOCK_MONOTONIC, &t0 );
+  for ( t = 1; t <= ms; t++ )
+  {
+    halLinuxAdvance( 1000 );
+    now = halLinuxTime();
+
+    if ( t == SIM_KEY_MS )
+    {
+      (void)OnBoard_SendKeys( HAL_KEY_SW_6, 0 );
+    }
+
+    for ( i = 0; i < MAX_NODE; i++ )
+    {
+      if ( simNode[i].announceAt && now >= simNode[i].announceAt )
+      {
+        simAnnounce( &simNode[i] );
+      }
+      if ( simNode[i].uplinkAt && now >= simNode[i].uplinkAt )
+      {
+        simNode[i].uplinkAt = 0;
+        simUplink( &simNode[i] );
+      }
+    }
+
+    simUartFeed();
+    simRun();
+  }
+  clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+  simPrintStats( ms, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9 );
+
+  return ( simStats.bad == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*********************************************************************
+*********************************************************************/
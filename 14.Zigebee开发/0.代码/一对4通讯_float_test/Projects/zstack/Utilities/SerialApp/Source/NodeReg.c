@@ -0,0 +1,288 @@
+/*********************************************************************
+* INCLUDES
+*/
+#include "OSAL.h"
+#include "OSAL_Nv.h"
+#include "NodeReg.h"
+
+/*********************************************************************
+* MACROS
+*/
+#if ( NODE_REG_SIZE & (NODE_REG_SIZE - 1) ) || ( NODE_REG_SIZE > 128 )
+#error "NODE_REG_SIZE must be a power of two, at most 128"
+#endif
+
+/*********************************************************************
+* LOCAL VARIABLES
+*/
+static nodeRegEntry_t NodeReg_Arena[NODE_REG_SIZE];
+static uint8 NodeReg_BySlot[NODE_REG_SIZE];     // slot -> arena index
+static uint8 NodeReg_Slots;
+static uint8 NodeReg_Used;
+
+/*********************************************************************
+* LOCAL FUNCTIONS
+*/
+static uint8 NodeReg_Hash( uint8 *ieee );
+static uint8 NodeReg_Probe( uint8 *ieee, uint8 *avail );
+static void NodeReg_Save( uint8 idx );
+
+/*********************************************************************
+* @fn      NodeReg_Init
+*
+* @brief   Restore the arena from NV and rebuild the slot index. Records
+*          that do not fit the current number of slots are dropped.
+*
+* @param   slots - number of slots of the node table.
+*
+* @return  none
+*/
+void NodeReg_Init( uint8 slots )
+{
+    nodeRegEntry_t *e;
+    uint8 idx;
+
+    NodeReg_Slots = ( slots > NODE_REG_SIZE ) ? NODE_REG_SIZE : slots;
+    NodeReg_Used = 0;
+    osal_memset( NodeReg_Arena, NODE_REG_NONE, sizeof(NodeReg_Arena) );
+    osal_memset( NodeReg_BySlot, NODE_REG_NONE, sizeof(NodeReg_BySlot) );
+
+    // A new item is created from the empty arena, nothing to read back then.
+    if ( osal_nv_item_init( ZCD_NV_SERIALAPP_REG, sizeof(NodeReg_Arena), NodeReg_Arena ) == SUCCESS )
+    {
+        osal_nv_read( ZCD_NV_SERIALAPP_REG, 0, sizeof(NodeReg_Arena), NodeReg_Arena );
+    }
+
+    for ( idx = 0; idx < NODE_REG_SIZE; idx++ )
+    {
+        e = &NodeReg_Arena[idx];
+        if ( e->slot >= NODE_REG_DELETED )
+        {
+            continue;
+        }
+        if ( e->slot >= NodeReg_Slots || NodeReg_BySlot[e->slot] != NODE_REG_NONE )
+        {
+            e->slot = NODE_REG_DELETED;
+            NodeReg_Save( idx );
+            continue;
+        }
+        NodeReg_BySlot[e->slot] = idx;
+        NodeReg_Used++;
+    }
+}
+
+/*********************************************************************
+* @fn      NodeReg_Register
+*
+* @brief   Add a node or refresh its short address after a rejoin. NV is
+*          only written when the record changes.
+*
+* @param   ieee      - IEEE address of the node.
+* @param   shortAddr - current short address.
+* @param   nodeId    - node number.
+* @param   hint      - preferred slot for a new node.
+*
+* @return  slot of the node, NODE_REG_NONE if there is no room.
+*/
+uint8 NodeReg_Register( uint8 *ieee, uint16 shortAddr, uint16 nodeId, uint8 hint )
+{
+    nodeRegEntry_t *e;
+    uint8 idx, avail, slot;
+
+    idx = NodeReg_Probe( ieee, &avail );
+    if ( idx != NODE_REG_NONE )
+    {
+        e = &NodeReg_Arena[idx];
+        if ( e->shortAddr == shortAddr && e->nodeId == nodeId )
+        {
+            return e->slot;
+        }
+    }
+    else
+    {
+        if ( avail == NODE_REG_NONE || NodeReg_Used >= NodeReg_Slots )
+        {
+            return NODE_REG_NONE;
+        }
+
+        slot = hint;
+        if ( slot >= NodeReg_Slots || NodeReg_BySlot[slot] != NODE_REG_NONE )
+        {
+            for ( slot = 0; NodeReg_BySlot[slot] != NODE_REG_NONE; slot++ )
+            {
+            }
+        }
+
+        idx = avail;
+        e = &NodeReg_Arena[idx];
+        osal_memcpy( e->ieee, ieee, Z_EXTADDR_LEN );
+        e->slot = slot;
+        NodeReg_BySlot[slot] = idx;
+        NodeReg_Used++;
+    }
+
+    e->shortAddr = shortAddr;
+    e->nodeId = nodeId;
+    NodeReg_Save( idx );
+
+    return e->slot;
+}
+
+/*********************************************************************
+* @fn      NodeReg_Remove
+*
+* @brief   Forget a node. The record becomes a tombstone so that nodes
+*          probed past it are still found.
+*
+* @param   ieee - IEEE address of the node.
+*
+* @return  TRUE if the node was registered.
+*/
+uint8 NodeReg_Remove( uint8 *ieee )
+{
+    uint8 idx, avail;
+
+    idx = NodeReg_Probe( ieee, &avail );
+    if ( idx == NODE_REG_NONE )
+    {
+        return FALSE;
+    }
+
+    NodeReg_BySlot[NodeReg_Arena[idx].slot] = NODE_REG_NONE;
+    NodeReg_Arena[idx].slot = NODE_REG_DELETED;
+    NodeReg_Used--;
+    NodeReg_Save( idx );
+
+    return TRUE;
+}
+
+/*********************************************************************
+* @fn      NodeReg_Find
+*
+* @brief   Record of a node by IEEE address.
+*
+* @param   ieee - IEEE address.
+*
+* @return  record or NULL
+*/
+nodeRegEntry_t *NodeReg_Find( uint8 *ieee )
+{
+    uint8 idx, avail;
+
+    idx = NodeReg_Probe( ieee, &avail );
+    return ( idx == NODE_REG_NONE ) ? NULL : &NodeReg_Arena[idx];
+}
+
+/*********************************************************************
+* @fn      NodeReg_Slot
+*
+* @brief   Record of the node owning a slot.
+*
+* @param   slot - slot of the node table.
+*
+* @return  record or NULL
+*/
+nodeRegEntry_t *NodeReg_Slot( uint8 slot )
+{
+    if ( slot >= NodeReg_Slots || NodeReg_BySlot[slot] == NODE_REG_NONE )
+    {
+        return NULL;
+    }
+    return &NodeReg_Arena[NodeReg_BySlot[slot]];
+}
+
+/*********************************************************************
+* @fn      NodeReg_Count
+*
+* @brief   Number of registered nodes.
+*
+* @return  count
+*/
+uint8 NodeReg_Count( void )
+{
+    return NodeReg_Used;
+}
+
+/*********************************************************************
+* @fn      NodeReg_Hash
+*
+* @brief   Rotate-xor of the IEEE address. The low bytes carry the serial
+*          number, so every byte takes part.
+*
+* @return  arena index
+*/
+static uint8 NodeReg_Hash( uint8 *ieee )
+{
+    uint8 h = 0;
+    uint8 i;
+
+    for ( i = 0; i < Z_EXTADDR_LEN; i++ )
+    {
+        h = (uint8)((h << 1) | (h >> 7)) ^ ieee[i];
+    }
+    return h & (NODE_REG_SIZE - 1);
+}
+
+/*********************************************************************
+* @fn      NodeReg_Probe
+*
+* @brief   Linear probe from the hash of ieee until the node or an empty
+*          record is found.
+*
+* @param   ieee  - IEEE address.
+* @param   avail - returns the first empty or removed record on the way,
+*                  NODE_REG_NONE if the arena is full.
+*
+* @return  arena index of the node, NODE_REG_NONE if not registered.
+*/
+static uint8 NodeReg_Probe( uint8 *ieee, uint8 *avail )
+{
+    nodeRegEntry_t *e;
+    uint8 idx = NodeReg_Hash( ieee );
+    uint8 n;
+
+    *avail = NODE_REG_NONE;
+    for ( n = 0; n < NODE_REG_SIZE; n++ )
+    {
+        e = &NodeReg_Arena[idx];
+        if ( e->slot == NODE_REG_NONE )
+        {
+            if ( *avail == NODE_REG_NONE )
+            {
+                *avail = idx;
+            }
+            break;
+        }
+        if ( e->slot == NODE_REG_DELETED )
+        {
+            if ( *avail == NODE_REG_NONE )
+            {
+                *avail = idx;
+            }
+        }
+        else if ( osal_memcmp( e->ieee, ieee, Z_EXTADDR_LEN ) )
+        {
+            return idx;
+        }
+        idx = (idx + 1) & (NODE_REG_SIZE - 1);
+    }
+    return NODE_REG_NONE;
+}
+
+/*********************************************************************
+* @fn      NodeReg_Save
+*
+* @brief   Write one record back to NV.
+*
+* @param   idx - arena index.
+*
+* @return  none
+*/
+static void NodeReg_Save( uint8 idx )
+{
+    osal_nv_write( ZCD_NV_SERIALAPP_REG, (uint16)idx * sizeof(nodeRegEntry_t),
+                   sizeof(nodeRegEntry_t), &NodeReg_Arena[idx] );
+}
+
+/*********************************************************************
+*********************************************************************/
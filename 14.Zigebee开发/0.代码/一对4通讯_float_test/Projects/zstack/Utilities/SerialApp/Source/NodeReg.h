@@ -0,0 +1,92 @@
+/**************************************************************************************************
+  Filename:       NodeReg.h
+
+  Description:    Coordinator node registry: IEEE address -> short address
+                  -> slot of the node table.
+
+                  Entries live in a fixed arena of NODE_REG_SIZE records,
+                  open-addressed by a hash of the IEEE address with linear
+                  probing. A second array maps each slot back to its record,
+                  so both lookups are O(1). The arena is kept in NV item
+                  ZCD_NV_SERIALAPP_REG and restored at start-up, so nodes keep
+                  their slot across coordinator resets.
+**************************************************************************************************/
+
+#ifndef NODEREG_H
+#define NODEREG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Arena size, a power of two. Keep it at least twice the number of slots
+// so probe sequences stay short.
+#if !defined( NODE_REG_SIZE )
+#define NODE_REG_SIZE          16
+#endif
+
+#define ZCD_NV_SERIALAPP_REG   0x0201
+
+#define NODE_REG_NONE          0xFF      // no slot / empty record
+#define NODE_REG_DELETED       0xFE      // removed record, keeps probing going
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8  ieee[Z_EXTADDR_LEN];
+  uint16 shortAddr;
+  uint16 nodeId;                         // node number announced by the node
+  uint8  slot;                           // or NODE_REG_NONE/NODE_REG_DELETED
+} nodeRegEntry_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Restore the registry from NV for a table of slots entries.
+ */
+extern void NodeReg_Init( uint8 slots );
+
+/*
+ * Add or refresh a node. A new node gets slot hint if it is free, else the
+ * lowest free slot. Returns the slot or NODE_REG_NONE if the table is full.
+ */
+extern uint8 NodeReg_Register( uint8 *ieee, uint16 shortAddr, uint16 nodeId, uint8 hint );
+
+/*
+ * Forget a node and free its slot. Returns TRUE if it was registered.
+ */
+extern uint8 NodeReg_Remove( uint8 *ieee );
+
+/*
+ * Lookups, NULL if not registered.
+ */
+extern nodeRegEntry_t *NodeReg_Find( uint8 *ieee );
+extern nodeRegEntry_t *NodeReg_Slot( uint8 slot );
+
+/*
+ * Number of registered nodes.
+ */
+extern uint8 NodeReg_Count( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NODEREG_H */
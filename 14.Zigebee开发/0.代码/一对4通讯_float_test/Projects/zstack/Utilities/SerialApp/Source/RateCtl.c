@@ -0,0 +1,180 @@
+/*********************************************************************
+* INCLUDES
+*/
+#include "OSAL.h"
+#include "RateCtl.h"
+
+/*********************************************************************
+* LOCAL FUNCTIONS
+*/
+static void RateCtl_Backoff( rateCtl_t *rc );
+static void RateCtl_Age( rateCtl_t *rc );
+
+/*********************************************************************
+* @fn      RateCtl_Init
+*
+* @brief   Reset the controller.
+*
+* @param   rc     - controller.
+* @param   period - first period in ms.
+* @param   min    - shortest period in ms.
+* @param   max    - longest period in ms.
+* @param   cap    - most requests waiting for a confirm.
+*
+* @return  none
+*/
+void RateCtl_Init( rateCtl_t *rc, uint16 period, uint16 min, uint16 max, uint8 cap )
+{
+    osal_memset( rc, 0, sizeof(rateCtl_t) );
+    rc->min = min;
+    rc->max = max;
+    rc->period = period;
+    rc->cap = cap;
+    rc->quiet = osal_GetSystemClock();
+}
+
+/*********************************************************************
+* @fn      RateCtl_CanSend
+*
+* @brief   Check the number of outstanding requests.
+*
+* @param   rc - controller.
+*
+* @return  TRUE if a request may be made.
+*/
+uint8 RateCtl_CanSend( rateCtl_t *rc )
+{
+    RateCtl_Age( rc );
+    if ( rc->pending >= rc->cap )
+    {
+        rc->held++;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*********************************************************************
+* @fn      RateCtl_Sent
+*
+* @brief   A request that the stack refused, e.g. with the MAC queue or
+*          the heap full, gets no confirm; back off right away.
+*
+* @param   rc     - controller.
+* @param   status - return value of AF_DataRequest.
+*
+* @return  none
+*/
+void RateCtl_Sent( rateCtl_t *rc, uint8 status )
+{
+    if ( status == SUCCESS )
+    {
+        if ( rc->pending == 0 )
+        {
+            rc->quiet = osal_GetSystemClock();
+        }
+        rc->pending++;
+        rc->sent++;
+    }
+    else
+    {
+        rc->busy++;
+        RateCtl_Backoff( rc );
+    }
+}
+
+/*********************************************************************
+* @fn      RateCtl_Confirm
+*
+* @brief   Additive increase after RATE_CTL_WINDOW successes in a row,
+*          multiplicative decrease on a failure.
+*
+* @param   rc     - controller.
+* @param   status - status of the data confirm.
+*
+* @return  none
+*/
+void RateCtl_Confirm( rateCtl_t *rc, uint8 status )
+{
+    if ( rc->pending )
+    {
+        rc->pending--;
+    }
+    rc->quiet = osal_GetSystemClock();
+
+    if ( status != SUCCESS )
+    {
+        rc->fail++;
+        RateCtl_Backoff( rc );
+        return;
+    }
+
+    rc->ok++;
+    if ( ++rc->run >= RATE_CTL_WINDOW )
+    {
+        rc->run = 0;
+        rc->period = ( rc->period > rc->min + RATE_CTL_STEP ) ? rc->period - RATE_CTL_STEP
+                                                              : rc->min;
+    }
+}
+
+/*********************************************************************
+* @fn      RateCtl_Period
+*
+* @brief   Next period.
+*
+* @param   rc - controller.
+*
+* @return  period in ms
+*/
+uint16 RateCtl_Period( rateCtl_t *rc )
+{
+    RateCtl_Age( rc );
+    return rc->period;
+}
+
+/*********************************************************************
+* @fn      RateCtl_Age
+*
+* @brief   Confirms that never come would keep the cap reached for good,
+*          so after RATE_CTL_STALL periods without one the outstanding
+*          requests count as failed. Timed on the system clock rather
+*          than counted in RateCtl_Period(), which end devices never call.
+*
+* @param   rc - controller.
+*
+* @return  none
+*/
+static void RateCtl_Age( rateCtl_t *rc )
+{
+    uint32 now = osal_GetSystemClock();
+
+    if ( rc->pending && now - rc->quiet > (uint32)RATE_CTL_STALL * rc->period )
+    {
+        rc->fail += rc->pending;
+        rc->pending = 0;
+        rc->quiet = now;
+        RateCtl_Backoff( rc );
+    }
+}
+
+/*********************************************************************
+* @fn      RateCtl_Backoff
+*
+* @brief   Double the period, up to max.
+*
+* @param   rc - controller.
+*
+* @return  none
+*/
+static void RateCtl_Backoff( rateCtl_t *rc )
+{
+    rc->run = 0;
+    rc->period = ( rc->period > rc->max / 2 ) ? rc->max : rc->period * 2;
+    if ( rc->period < rc->min )
+    {
+        rc->period = rc->min;
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
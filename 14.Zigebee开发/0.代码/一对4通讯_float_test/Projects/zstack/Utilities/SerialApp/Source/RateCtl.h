@@ -0,0 +1,108 @@
+/**************************************************************************************************
+  Filename:       RateCtl.h
+
+  Description:    AIMD send-rate controller driven by AF data confirms.
+
+                  Every RATE_CTL_WINDOW successful confirms in a row shorten
+                  the send period by RATE_CTL_STEP ms (additive increase of
+                  the rate); a failed confirm, or a request refused by the
+                  stack because the MAC or the heap is busy, doubles it
+                  (multiplicative decrease). The period stays within
+                  [min, max]. At most cap requests may wait for their
+                  confirm, so a congested channel cannot fill the heap with
+                  queued frames.
+**************************************************************************************************/
+
+#ifndef RATECTL_H
+#define RATECTL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Successful confirms in a row before the period is shortened.
+#if !defined( RATE_CTL_WINDOW )
+#define RATE_CTL_WINDOW   4
+#endif
+
+// Additive step of the period in ms.
+#if !defined( RATE_CTL_STEP )
+#define RATE_CTL_STEP     10
+#endif
+
+// Send periods without any confirm, with requests outstanding, after which
+// the outstanding requests are written off as failed. Checked on every
+// RateCtl_CanSend() and RateCtl_Period(), so it works on any device that
+// keeps trying to send, periodic timer or not.
+#if !defined( RATE_CTL_STALL )
+#define RATE_CTL_STALL    4
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint16 period;                         // current send period in ms
+  uint16 min;
+  uint16 max;
+  uint8  pending;                        // requests waiting for a confirm
+  uint8  cap;                            // most requests allowed to wait
+  uint8  run;                            // successful confirms in a row
+  uint32 quiet;                          // clock of the last confirm, or of
+                                         // the first request waited for
+  uint16 sent;
+  uint16 ok;
+  uint16 fail;                           // failed confirms
+  uint16 busy;                           // requests refused by the stack
+  uint16 held;                           // requests not made, cap reached
+} rateCtl_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Start at period with nothing outstanding.
+ */
+extern void RateCtl_Init( rateCtl_t *rc, uint16 period, uint16 min, uint16 max, uint8 cap );
+
+/*
+ * TRUE if another request may be made now; counts it as held otherwise.
+ * Writes off requests stalled for RATE_CTL_STALL periods first.
+ */
+extern uint8 RateCtl_CanSend( rateCtl_t *rc );
+
+/*
+ * Result of AF_DataRequest for a request that was made.
+ */
+extern void RateCtl_Sent( rateCtl_t *rc, uint8 status );
+
+/*
+ * Status of an AF_DATA_CONFIRM_CMD.
+ */
+extern void RateCtl_Confirm( rateCtl_t *rc, uint8 status );
+
+/*
+ * Call once per period; returns the period to wait until the next one.
+ */
+extern uint16 RateCtl_Period( rateCtl_t *rc );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RATECTL_H */
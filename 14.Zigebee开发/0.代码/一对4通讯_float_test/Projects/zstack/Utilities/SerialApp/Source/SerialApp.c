@@ -8,6 +8,7 @@
 #include "OnBoard.h"
 #include "OSAL_Tasks.h"
 #include "SerialApp.h"
+#include "aps_groups.h"
 #include "ZDApp.h"
 #include "ZDObject.h"
 #include "ZDProfile.h"
@@ -21,6 +22,9 @@
 #include "hal_uart.h"
 
 #include "DHT11.h"
+#include "NodeReg.h"
+#include "RateCtl.h"
+#include "SlotFrame.h"
 #include "nwk_globals.h"
 /*********************************************************************
 * MACROS
@@ -28,10 +32,18 @@
 #define COORD_ADDR   0x00
 #define ED_ADDR      0x01
 #define UART0        0x00
-#define MAX_NODE     0x04
-#define SUM_NUM      0x01
+#if !defined( MAX_NODE )
+#define MAX_NODE     0x04        //ڵ,ۺΪһֽ,254
+#endif
+#if !defined( SUM_NUM )
+#define SUM_NUM      0x01        //ÿڵfloat
+#endif
 #define UART_DEBUG   0x00        //Ժ,ͨЭն˵IEEE̵ַ
 
+#define FRAME_SOF       0x3A     //֡ͷ
+#define FRAME_EOF       0x23     //֡β
+#define NODE_FRAME_LEN  9        //ն˷STM32: ֡ͷ+̵ַ(2)+(4)+У+֡β
+
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr)[0])
 
 
@@ -66,22 +78,177 @@
 #define SERIAL_APP_IDLE  6
 #endif
 
-// Loopback Rx bytes to Tx for throughput testing.
+// Loopback Rx bytes to Tx for throughput testing: the UART0 bytes go
+// through the same staging buffer as the OTA bridge and are written back
+// to UART0 instead of being sent.
 #if !defined( SERIAL_APP_LOOPBACK )
 #define SERIAL_APP_LOOPBACK  FALSE
 #endif
 
-// This is the max byte count per OTA message.
+// This is the max byte count per OTA message. UART0 bytes are collected
+// until this many, or the AF MTU if smaller, are waiting, or until
+// SERIAL_APP_TX_DEADLINE ms after the first of them, and then sent OTA on
+// SERIALAPP_CLUSTERID2 in one request.
 #if !defined( SERIAL_APP_TX_MAX )
-#define SERIAL_APP_TX_MAX  20
+#define SERIAL_APP_TX_MAX  80
+#endif
+
+#if !defined( SERIAL_APP_TX_DEADLINE )
+#define SERIAL_APP_TX_DEADLINE  10
+#endif
+
+// Period of the throughput report on the LCD, ms.
+#if !defined( SERIAL_APP_TPUT_PERIOD )
+#define SERIAL_APP_TPUT_PERIOD  1000
 #endif
 
 #define SERIAL_APP_RSP_CNT  4
 
+// Attempts to send a response before it is dropped, SERIALAPP_NAK_DELAY ms
+// apart.
+#if !defined( SERIAL_APP_RSP_RETRY )
+#define SERIAL_APP_RSP_RETRY  3
+#endif
+
+// Range of the send period set by the rate controller (RateCtl.h), and the
+// most AF requests allowed to wait for their data confirm.
+#if !defined( SERIAL_APP_PERIOD_MIN )
+#define SERIAL_APP_PERIOD_MIN  100
+#endif
+
+#if !defined( SERIAL_APP_PERIOD_MAX )
+#define SERIAL_APP_PERIOD_MAX  2000
+#endif
+
+#if !defined( SERIAL_APP_MAX_PENDING )
+#define SERIAL_APP_MAX_PENDING  6
+#endif
+
+// How the coordinator sends the node table OTA. AUTO broadcasts until a node
+// has registered, then unicasts one slot per registered node while there are
+// at most SERIAL_APP_UNICAST_MAX of them and multicasts above that.
+// Group frames are not buffered for sleeping end devices; use BROADCAST then.
+#define SERIAL_APP_DIST_AUTO       0
+#define SERIAL_APP_DIST_UNICAST    1
+#define SERIAL_APP_DIST_GROUP      2
+#define SERIAL_APP_DIST_BROADCAST  3
+
+#if !defined( SERIAL_APP_DIST )
+#define SERIAL_APP_DIST  SERIAL_APP_DIST_AUTO
+#endif
+
+#if !defined( SERIAL_APP_UNICAST_MAX )
+#define SERIAL_APP_UNICAST_MAX  3
+#endif
+
+#define ADDR_INFO_LEN  13        //0x3B+̵ַ(2)+IEEE(8)+ڵ(2)
+
+// Node number an end device announces; the coordinator gives it the slot
+// of that number if the slot is free, else the lowest free slot. Set it
+// per build, 1..MAX_NODE; 0 announces no preference. The node is then
+// known by EndDeviceID[slot] on both sides, whatever it announced.
+#if !defined( SERIAL_APP_NODE_ID )
+#define SERIAL_APP_NODE_ID  0
+#endif
+#define SLOT_ASSIGN    0x3D      //Эظն: 0x3D+IEEE(8)+ۺ
+#define SLOT_ASSIGN_LEN 10
+
+#if defined(ZDO_COORDINATOR) && ( NODE_REG_SIZE < 2 * MAX_NODE )
+#error "NODE_REG_SIZE must be at least 2 * MAX_NODE"
+#endif
+
+// Frames between keyframes of the node table; the frames in between carry
+// 16-bit deltas against the keyframe. 1 sends keyframes only.
+#if !defined( SERIAL_APP_KEY_INTERVAL )
+#define SERIAL_APP_KEY_INTERVAL  8
+#endif
+
+// Default delta quantum 2^SERIAL_APP_DELTA_EXP for every channel, see
+// SerialApp_DeltaExp. -6 gives 1/64 steps over +/-512 around the keyframe.
+#if !defined( SERIAL_APP_DELTA_EXP )
+#define SERIAL_APP_DELTA_EXP  (-6)
+#endif
+
+// Write the OTA table frames to UART0 instead of one node frame per node.
+#if !defined( SERIAL_APP_UART_TABLE )
+#define SERIAL_APP_UART_TABLE  FALSE
+#endif
+
+#if SUM_NUM > SLOT_FRAME_M_MAX
+#error "SUM_NUM must not exceed SLOT_FRAME_M_MAX"
+#endif
+
+// End device: senders tracked for sequence statistics, and table frames
+// between two link statistics reports on UART0 (0 = never).
+#if !defined( SERIAL_APP_SEQ_SRC )
+#define SERIAL_APP_SEQ_SRC  4
+#endif
+
+#if !defined( SERIAL_APP_SEQ_REPORT )
+#define SERIAL_APP_SEQ_REPORT  32
+#endif
+
+// A frame at most this many sequence numbers behind the last one is a late
+// retry and is dropped; further behind means the sender restarted.
+#define SERIAL_APP_SEQ_WINDOW  16
+
+#define LINK_FRAME_SOF  0x3F     //ն˷STM32·ͳ֡
+#define LINK_FRAME_LEN  13       //֡ͷ+Դַ(2)+յ/ʧ/ظ/(2)+У+֡β
+
+// Uplink TDMA. Every superframe starts with a broadcast beacon that carries
+// a bitmap of the registered slots; the n-th registered end device, in slot
+// order, sends its own slot SERIAL_APP_UPLINK_GUARD + n * SERIAL_APP_UPLINK_SLOT
+// ms after the beacon. The coordinator lengthens the superframe beyond
+// SERIALAPP_SEND_PERIODIC_TIMEOUT when the uplink slots need more room, and
+// frees the slot of a node that missed SERIAL_APP_UPLINK_MISS superframes
+// in a row (0 = never), so the others move up.
+#if !defined( SERIAL_APP_UPLINK_SLOT )
+#define SERIAL_APP_UPLINK_SLOT   16
+#endif
+
+#if !defined( SERIAL_APP_UPLINK_GUARD )
+#define SERIAL_APP_UPLINK_GUARD  40
+#endif
+
+#if !defined( SERIAL_APP_UPLINK_MISS )
+#define SERIAL_APP_UPLINK_MISS   16
+#endif
+
+#define BEACON_SOF       0x40    //Э㲥ĳ֡ʼ: ֡ͷ++ʱ+ʱ϶+λͼֽ
+#define BEACON_HDR_LEN   5
+#define BEACON_OVERHEAD  (BEACON_HDR_LEN + 2)   //+У+֡β
+#define BEACON_MAP_LEN   ((MAX_NODE + 7) / 8)
+
+// What an end device sends in its uplink slot:
+//   NONE  - its slot of NodesData, UART0 is bridged OTA (SERIAL_APP_TX_MAX)
+//   UART  - values the STM32 writes to UART0 as node frames whose address
+//           field is the channel 0..SUM_NUM-1
+//   DHT11 - channel 0 temperature, channel 1 humidity, read after every
+//           uplink for the next one, since a reading takes over 20 ms
+#define SERIAL_APP_UPLINK_NONE   0
+#define SERIAL_APP_UPLINK_UART   1
+#define SERIAL_APP_UPLINK_DHT11  2
+
+#if !defined( SERIAL_APP_UPLINK_SRC )
+#define SERIAL_APP_UPLINK_SRC  SERIAL_APP_UPLINK_NONE
+#endif
+
+// Coordinator: after the uplink window it writes the slots refreshed in
+// that superframe to UART0 as report frames:
+//   0x41 | seq | count | m | count * (slot, m floats) | xor | 0x23
+#define REPORT_SOF       0x41
+#define REPORT_HDR_LEN   4
+
+// Largest slot-table frame; afDataReqMTU() is normally smaller.
+#if !defined( SERIAL_APP_SLOT_BUF )
+#define SERIAL_APP_SLOT_BUF  100
+#endif
+
 // This list should be filled with Application specific Cluster IDs.
 const cId_t SerialApp_ClusterList[SERIALAPP_MAX_CLUSTERS] =
 {
-	SERIALAPP_CLUSTERID
+	SERIALAPP_CLUSTERID,
+	SERIALAPP_CLUSTERID2             //͸
 };
 
 const SimpleDescriptionFormat_t SerialApp_SimpleDesc =
@@ -109,6 +276,18 @@ const endPointDesc_t SerialApp_epDesc =
 * TYPEDEFS
 */
 
+// Sequence state and link statistics of one sender.
+typedef struct
+{
+  uint16 src;
+  uint8  last;
+  uint8  valid;
+  uint16 rx;
+  uint16 lost;
+  uint16 dup;
+  uint16 reorder;
+} serialAppSeq_t;
+
 /*********************************************************************
 * GLOBAL VARIABLES
 */
@@ -126,63 +305,69 @@ uint8 SerialApp_TaskID;    // Task ID for internal task/event processing.
 /*********************************************************************
 * LOCAL VARIABLES
 */
-static bool SendFlag = 0;
-
 static uint8 SerialApp_MsgID;
 
-static afAddrType_t SerialApp_TxAddr;
 static afAddrType_t Broadcast_DstAddr;
+#if defined(ZDO_COORDINATOR)
+static bool SendFlag = 0;
+static afAddrType_t Group_DstAddr;
+static afAddrType_t Node_DstAddr;
+#else
+static afAddrType_t SerialApp_TxAddr;     //ն˷Э
+#endif
 
 static uint8 SerialApp_TxSeq;
 static uint8 SerialApp_TxBuf[SERIAL_APP_TX_MAX+1];
 static uint8 SerialApp_TxLen;
 
+uint32 SerialApp_UartBytes;        //Ӵڶֽ
+uint32 SerialApp_AirBytes;         //͸(ػʱдش)ֽ
+
 static afAddrType_t SerialApp_RxAddr;
 static uint8 SerialApp_RspBuf[SERIAL_APP_RSP_CNT];
+static uint8 SerialApp_RspRetry;
 
-static devStates_t SerialApp_NwkState;
-static afAddrType_t SerialApp_TxAddr;
-static uint8 SerialApp_MsgID;
-//---------------------------------------------------------------------
-
-float NodesData[MAX_NODE][SUM_NUM]={{725.432},{2527.222},{125.115},{1.989}};  
-uint16 EndDeviceID[MAX_NODE]={0x0001,0x0002,0x0003,0x0004};
-uint16 EndDeviceID_current=0x0002;
-
-
-char position1_data[4]={0};//ն1
-char position2_data[4]={0};//ն2
-char position3_data[4]={0};//ն3
-char position4_data[4]={0};//ն4
+static rateCtl_t SerialApp_Rate;   //ݷȷϵ
 
+static devStates_t SerialApp_NwkState;
 
+//ǰڵĳʼ(һͨ),Ϊ0
+static const float SerialApp_InitData[] = { 725.432, 2527.222, 125.115, 1.989 };
+//---------------------------------------------------------------------
 
-union position1
-{
-  float position1_float;
-  unsigned char position1_char[4];
-}x1_data,y1_data,z1_data,theta1_data,phi1_data,gamma1_data;
+float NodesData[MAX_NODE][SUM_NUM];
+uint16 EndDeviceID[MAX_NODE];      //SerialApp_Init,iĽڵΪi+1,Эնͬ
+uint16 EndDeviceID_current;        //ն: ڵ,ۺʱȡEndDeviceID[ۺ]
+int8 SerialApp_DeltaExp[SUM_NUM];   //ͨ 2^e
 
 
-union position2
-{
-float position2_float;
-unsigned char position2_char[4];
-}x2_data,y2_data,z2_data,theta2_data,phi2_data,gamma2_data;
+static uint8 SerialApp_SlotBuf[SERIAL_APP_SLOT_BUF];
 
-union position3
-{
-float position3_float;
-unsigned char position3_char[4];
-}x3_data,y3_data,z3_data,theta3_data,phi3_data,gamma3_data;
+static float SerialApp_Key[MAX_NODE][SUM_NUM];      //һؼ֡,֡ԴΪ׼
+static uint8 SerialApp_KeyId;
+static uint8 SerialApp_KeyAge = SERIAL_APP_KEY_INTERVAL;
 
-union position4
-{
-float position4_float;
-unsigned char position4_char[4];
-}x4_data,y4_data,z4_data,theta4_data,phi4_data,gamma4_data;
+#if defined(ZDO_COORDINATOR)
+static uint8 SerialApp_UplinkMiss[MAX_NODE];        //δϱĳ֡
+static uint8 SerialApp_Fresh[BEACON_MAP_LEN];       //֡ϱĲ
+static float NodesUplink[MAX_NODE][SUM_NUM];        //նϱ,·NodesDataֿ
+#else
+static uint8 SerialApp_UplinkSeq;                   //ϱӦĳ֡
+#endif
 
+#if !defined(ZDO_COORDINATOR)
+static uint8 SerialApp_MySlot = SLOT_FRAME_NONE;   //նݱеĲۺ,Э
+static slotFrameKey_t SerialApp_MyKey;              //۵Ĺؼ֡
+static serialAppSeq_t SerialApp_Seq[SERIAL_APP_SEQ_SRC];
+static uint8 SerialApp_SeqNext;
+static uint8 SerialApp_SeqFrames;
+#endif
 
+#if defined(ZDO_COORDINATOR)
+static uint8 SerialApp_DistMode = SERIAL_APP_DIST;
+#else
+static aps_Group_t SerialApp_Group;
+#endif
 
 //---------------------------------------------------------------------
 /*********************************************************************
@@ -195,11 +380,40 @@ static void SerialApp_Resp(void);
 static void SerialApp_CallBack(uint8 port, uint8 event);
 
 
+#if !defined(ZDO_COORDINATOR)
 static void AfSendAddrInfo(void);
+#endif
+static afStatus_t SerialApp_Send( afAddrType_t *dstAddr, uint16 clusterId,
+                                  uint8 len, uint8 *buf );
+#if defined(ZDO_COORDINATOR) || SERIAL_APP_UPLINK_SRC != SERIAL_APP_UPLINK_UART
+static uint8 SerialApp_TxSize( void );
+#endif
+static uint8 SerialApp_Flush( void );
+#if defined ( LCD_SUPPORTED )
+static void SerialApp_Throughput( void );
+#endif
   
 static void SerialApp_SendPeriodicMessage( void );
+#if defined(ZDO_COORDINATOR)
+static uint8 SerialApp_DistSelect( void );
+static uint16 SerialApp_SendBeacon( void );
+static void SerialApp_Report( void );
+#else
+static void SerialApp_Beacon( uint8 *buf, uint16 len );
+static void SerialApp_SendUplink( void );
+#if SERIAL_APP_UPLINK_SRC == SERIAL_APP_UPLINK_UART
+static void SerialApp_UplinkParse( void );
+#endif
+#endif
+static void SerialApp_SendSlots( afAddrType_t *dstAddr, uint8 first, uint8 count,
+                                 uint8 per, uint8 delta );
 
 static uint8 XorCheckSum(uint8 * pBuf, uint8 len);
+static void SerialApp_UartWriteNode(uint16 addr, uint8 *data);
+#if !defined(ZDO_COORDINATOR)
+static uint8 SerialApp_SeqAccept( uint16 src, uint8 seq );
+static void SerialApp_UartWriteLink( void );
+#endif
 
 /*********************************************************************
 * @fn      SerialApp_Init
@@ -213,6 +427,7 @@ static uint8 XorCheckSum(uint8 * pBuf, uint8 len);
 void SerialApp_Init( uint8 task_id )
 {
     halUARTCfg_t uartConfig;
+    uint8 i;
     
   
 	
@@ -234,8 +449,34 @@ void SerialApp_Init( uint8 task_id )
 	uartConfig.callBackFunc         = SerialApp_CallBack;
 	HalUARTOpen (UART0, &uartConfig);
 	
+	RateCtl_Init( &SerialApp_Rate, SERIALAPP_SEND_PERIODIC_TIMEOUT, SERIAL_APP_PERIOD_MIN,
+	              SERIAL_APP_PERIOD_MAX, SERIAL_APP_MAX_PENDING );
+	
+	for ( i = 0; i < SUM_NUM; i++ )
+	{
+		SerialApp_DeltaExp[i] = SERIAL_APP_DELTA_EXP;
+	}
+	
+	for ( i = 0; i < MAX_NODE; i++ )
+	{
+		EndDeviceID[i] = i + 1;    //̵ַ0Э,ڵŴ1ʼ
+		if ( i < sizeof( SerialApp_InitData ) / sizeof( SerialApp_InitData[0] ) )
+		{
+			NodesData[i][0] = SerialApp_InitData[i];
+		}
+	}
+	
+#if defined(ZDO_COORDINATOR)
+	NodeReg_Init( MAX_NODE );      //NVָѵǼǵն,ۺŲ
+#else
+	SerialApp_Group.ID = SERIALAPP_GROUP_ID;
+	osal_memcpy( SerialApp_Group.name, "SerialApp", 9 );
+	aps_AddGroup( SERIALAPP_ENDPOINT, &SerialApp_Group );
+#endif
+	
 #if defined ( LCD_SUPPORTED )
 	HalLcdWriteString( "SerialApp", HAL_LCD_LINE_2 );
+	osal_start_timerEx( SerialApp_TaskID, SERIALAPP_TPUT_EVT, SERIAL_APP_TPUT_PERIOD );
 #endif
 	
 }
@@ -271,6 +512,10 @@ UINT16 SerialApp_ProcessEvent( uint8 task_id, UINT16 events )
 			case AF_INCOMING_MSG_CMD://ڵӦò㷢ԼݰԸ
 				SerialApp_ProcessMSGCmd( MSGpkt );
 				break;
+				
+			case AF_DATA_CONFIRM_CMD://ͽ,ݴ˵
+				RateCtl_Confirm( &SerialApp_Rate, ((afDataConfirm_t *)MSGpkt)->hdr.status );
+				break;
                 
             case ZDO_STATE_CHANGE://豸״̬Э·
               SerialApp_NwkState = (devStates_t)(MSGpkt->hdr.status);
@@ -282,10 +527,18 @@ UINT16 SerialApp_ProcessEvent( uint8 task_id, UINT16 events )
                     Broadcast_DstAddr.addrMode = (afAddrMode_t)AddrBroadcast;
                     Broadcast_DstAddr.endPoint = SERIALAPP_ENDPOINT;
                     Broadcast_DstAddr.addr.shortAddr = 0xFFFF;
+                    
+                    Group_DstAddr.addrMode = (afAddrMode_t)afAddrGroup;
+                    Group_DstAddr.endPoint = SERIALAPP_ENDPOINT;
+                    Group_DstAddr.addr.shortAddr = SERIALAPP_GROUP_ID;
+                    
+                    Node_DstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+                    Node_DstAddr.endPoint = SERIALAPP_ENDPOINT;
                 
                  
-                #else                        //ն߷Ͷ̵ַIEEE   
-                    AfSendAddrInfo();
+                #else                        //ն߷Ͷ̵ַIEEE,ֱЭۺ
+                    SerialApp_MySlot = SLOT_FRAME_NONE;
+                    osal_set_event( SerialApp_TaskID, SERIALAPP_ANNOUNCE_EVT );
                 #endif
                 
               }
@@ -304,21 +557,72 @@ UINT16 SerialApp_ProcessEvent( uint8 task_id, UINT16 events )
         
      if ( events & SERIALAPP_SEND_PERIODIC_EVT )
     {
+        uint16 period = RateCtl_Period( &SerialApp_Rate );
+#if defined(ZDO_COORDINATOR)
+        uint16 frame = SerialApp_SendBeacon();    //֡Ҫϱʱ϶
+        
+        if ( period < frame )
+        {
+            period = frame;
+        }
+#endif
         SerialApp_SendPeriodicMessage();
         
-        osal_start_timerEx( SerialApp_TaskID, SERIALAPP_SEND_PERIODIC_EVT,
-            (SERIALAPP_SEND_PERIODIC_TIMEOUT + (osal_rand() & 0x00FF)) );
+        osal_start_timerEx( SerialApp_TaskID, SERIALAPP_SEND_PERIODIC_EVT, period );
         
         return (events ^ SERIALAPP_SEND_PERIODIC_EVT);
     }
 
 	
+#if defined(ZDO_COORDINATOR)
+    if ( events & SERIALAPP_REPORT_EVT )
+    {
+        SerialApp_Report();
+        return (events ^ SERIALAPP_REPORT_EVT);
+    }
+#else
+    if ( events & SERIALAPP_ANNOUNCE_EVT )
+    {
+        if ( SerialApp_MySlot == SLOT_FRAME_NONE )
+        {
+            AfSendAddrInfo();
+            osal_start_timerEx( SerialApp_TaskID, SERIALAPP_ANNOUNCE_EVT,
+                (SERIALAPP_ANNOUNCE_TIMEOUT + (osal_rand() & 0x00FF)) );
+        }
+        return (events ^ SERIALAPP_ANNOUNCE_EVT);
+    }
+    
+    if ( events & SERIALAPP_UPLINK_EVT )
+    {
+        SerialApp_SendUplink();
+        return (events ^ SERIALAPP_UPLINK_EVT);
+    }
+#endif
+
+    if ( events & SERIALAPP_SEND_EVT )   //ݵȴʱ,һ֡Ҳ
+	{
+		if ( !SerialApp_Flush() )
+		{
+			osal_start_timerEx( SerialApp_TaskID, SERIALAPP_SEND_EVT, SERIAL_APP_TX_DEADLINE );
+		}
+		return ( events ^ SERIALAPP_SEND_EVT );
+	}
+	
     if ( events & SERIALAPP_RESP_EVT )
 	{
 		SerialApp_Resp();
 		return ( events ^ SERIALAPP_RESP_EVT );
 	}
 	
+#if defined ( LCD_SUPPORTED )
+    if ( events & SERIALAPP_TPUT_EVT )
+	{
+		SerialApp_Throughput();
+		osal_start_timerEx( SerialApp_TaskID, SERIALAPP_TPUT_EVT, SERIAL_APP_TPUT_PERIOD );
+		return ( events ^ SERIALAPP_TPUT_EVT );
+	}
+#endif
+	
 	return ( 0 ); 
 }
 
@@ -334,6 +638,8 @@ UINT16 SerialApp_ProcessEvent( uint8 task_id, UINT16 events )
 */
 void SerialApp_HandleKeys( uint8 shift, uint8 keys )
 {
+    (void)shift;  // Intentionally unreferenced parameter
+
 #if defined(ZDO_COORDINATOR)//Э
 	
     if ( keys & HAL_KEY_SW_6 ) //S1ֹͣն˶ʱϱ 
@@ -354,156 +660,657 @@ void SerialApp_HandleKeys( uint8 shift, uint8 keys )
         }
     }
     
+    if ( keys & HAL_KEY_SW_7 ) //S2лݱķͷʽ: Զ/㲥/鲥/㲥
+    {
+        SerialApp_DistMode = (SerialApp_DistMode + 1) % (SERIAL_APP_DIST_BROADCAST + 1);
+#if defined ( LCD_SUPPORTED )
+        HalLcdWriteStringValue( "Dist", SerialApp_DistMode, 10, HAL_LCD_LINE_3 );
+#endif
+    }
+    
+#else
+    (void)keys;   // Intentionally unreferenced parameter
 #endif
 }
 
 void SerialApp_ProcessMSGCmd( afIncomingMSGPacket_t *pkt )
 {
-
-   
-    uint8 afRxData[26]={0};
-    uint8 getData[4]={0};
+    float value[SLOT_FRAME_M_MAX];
+#if defined(ZDO_COORDINATOR)
+    slotFrameKey_t key;
+    uint8 rsp[SLOT_ASSIGN_LEN];
+    uint16 id;
     uint8 i;
+#endif
     
 	switch ( pkt->clusterId )
 	{
 
 	case SERIALAPP_CLUSTERID:
-        osal_memcpy(afRxData, pkt->cmd.Data, pkt->cmd.DataLength);
-		switch(afRxData[0]) 
+        if ( pkt->cmd.DataLength == 0 )
+        {
+            break;
+        }
+		switch ( pkt->cmd.Data[0] )
 		{
 #if defined(ZDO_COORDINATOR)//Э
-		
-         
-                 
+        case 0x3B:  //ն˵ַϢ: Ǽն,ۺŲն
+          if ( pkt->cmd.DataLength < ADDR_INFO_LEN )
+          {
+              break;
+          }
+          id = BUILD_UINT16( pkt->cmd.Data[12], pkt->cmd.Data[11] );
+          for ( i = 0; i < MAX_NODE && EndDeviceID[i] != id; i++ )
+          {
+          }
+          i = NodeReg_Register( &pkt->cmd.Data[3],
+                                BUILD_UINT16( pkt->cmd.Data[2], pkt->cmd.Data[1] ),
+                                id, i );
+          if ( i == NODE_REG_NONE )
+          {
+              break;
+          }
+          SerialApp_UplinkMiss[i] = 0;   //ڵΪEndDeviceID[i],ն˰ۺȡͬһ
+          
+          rsp[0] = SLOT_ASSIGN;
+          osal_memcpy( &rsp[1], &pkt->cmd.Data[3], Z_EXTADDR_LEN );
+          rsp[9] = i;
+          SerialApp_Send( &pkt->srcAddr, SERIALAPP_CLUSTERID, SLOT_ASSIGN_LEN, rsp );
+          break;
+          
+        case SLOT_FRAME_SOF:  //նԼʱ϶ϱ,ֻܲ۵˷
+          i = ( pkt->cmd.DataLength >= SLOT_FRAME_OVERHEAD ) ? pkt->cmd.Data[3] : SLOT_FRAME_NONE;
+          if ( NodeReg_Slot( i ) != NULL &&
+               NodeReg_Slot( i )->shortAddr == pkt->srcAddr.addr.shortAddr &&
+               SlotFrame_Check(pkt->cmd.Data, pkt->cmd.DataLength, i) &&
+               SlotFrame_Decode(pkt->cmd.Data, i, &key, value) == SUM_NUM )
+          {
+              osal_memcpy( NodesUplink[i], value, sizeof(NodesUplink[i]) );
+              SerialApp_UplinkMiss[i] = 0;
+              SerialApp_Fresh[i >> 3] |= BV( i & 7 );
+          }
+          break;
 #else  //նˣյ,ӡЭ
-        case 0x3A:  //ʼն˽յ	      
+        case SLOT_FRAME_SOF:        //ݱؼ֡/֡,ڽջУ,ۺֱȡն˵
+        case SLOT_FRAME_DELTA_SOF:
+          if ( SlotFrame_Check(pkt->cmd.Data, pkt->cmd.DataLength, SerialApp_MySlot) &&
+               SerialApp_SeqAccept(pkt->srcAddr.addr.shortAddr, SLOT_FRAME_SEQ(pkt->cmd.Data)) &&
+               SlotFrame_Decode(pkt->cmd.Data, SerialApp_MySlot, &SerialApp_MyKey, value) )
+          {
+              SerialApp_UartWriteNode(EndDeviceID_current, (uint8 *)value);
+          }
+          break;
           
-              if(EndDeviceID_current == afRxData[2])//֤ն豸ַ,0x01
-		    {
-                      for (i=0;i<4;i++)
-                      {
-                        getData[i]=afRxData[3+i];
-                      }
-
-                           HalUARTWrite(UART0, getData,4);                 
-                    }  
-              else if(EndDeviceID_current == afRxData[8])//֤ն豸ַ,0x01
-		    {
-		            for (i=0;i<4;i++)
-                      {
-                        getData[i]=afRxData[9+i];
-                      }
-                           HalUARTWrite(UART0, getData,4);                 
-                    }
-             else if(EndDeviceID_current == afRxData[14])//֤ն豸ַ,0x01
-		    {
-		            for (i=0;i<4;i++)
-                      {
-                        getData[i]=afRxData[15+i];
-                      }
-                           HalUARTWrite(UART0, getData,4);                 
-                    }
-              else if(EndDeviceID_current == afRxData[20])//֤ն豸ַ,0x01
-		    {
-		            for (i=0;i<4;i++)
-                      {
-                        getData[i]=afRxData[21+i];
-                      }
-                           HalUARTWrite(UART0, getData,4);                 
-                    }
-              
-          	
-        break;
-        	
+        case SLOT_ASSIGN:  //ЭĲۺ
+          if ( pkt->cmd.DataLength >= SLOT_ASSIGN_LEN &&
+               pkt->cmd.Data[9] < MAX_NODE &&   //ۺNodesData±,ԽĲ
+               osal_memcmp( &pkt->cmd.Data[1], NLME_GetExtAddr(), Z_EXTADDR_LEN ) )
+          {
+              SerialApp_MySlot = pkt->cmd.Data[9];
+              SerialApp_MyKey.valid = FALSE;
+              EndDeviceID_current = EndDeviceID[SerialApp_MySlot];
+          }
+          break;
+          
+        case BEACON_SOF:   //֡ʼ,ڱն˵ʱ϶ϱ
+          SerialApp_Beacon( pkt->cmd.Data, pkt->cmd.DataLength );
+          break;
 #endif
-       
         }
         break;
-			
-		
+	
+	case SERIALAPP_CLUSTERID2:   //Է͸,ԭд
+		HalUARTWrite( UART0, pkt->cmd.Data, pkt->cmd.DataLength );
+		break;
 	}
 }
 
-uint8 TxBuffer[26];
-
-
-void SerialApp_SendPeriodicMessage( void )//ն˶ʱЭ
-{ 
-   
-     
-     TxBuffer[0] = 0x3A;   
-     
-     TxBuffer[1] = 0x00;
-     TxBuffer[2] = EndDeviceID[0];
-   
-     
-     TxBuffer[7] = 0x00;
-     TxBuffer[8] = EndDeviceID[1];
+/*********************************************************************
+* @fn      SerialApp_UartWriteNode
+*
+* @brief   Write one node value to UART0 as a 0x3A ... 0x23 frame so the
+*          STM32 can resynchronize on it.
+*
+* @param   addr - node address.
+* @param   data - 4 bytes of float data.
+*
+* @return  none
+*/
+static void SerialApp_UartWriteNode(uint16 addr, uint8 *data)
+{
+    uint8 frame[NODE_FRAME_LEN];
     
-     
-     TxBuffer[13] = 0x00;
-     TxBuffer[14] = EndDeviceID[2];
-     
-     TxBuffer[19] = 0x00;
-     TxBuffer[20] = EndDeviceID[3];
-     
-
-          x1_data.position1_float=NodesData[0][0];
-        
-         
-          x2_data.position2_float=NodesData[1][0];
-         
-          
-          x3_data.position3_float=NodesData[2][0];
-         
-        
-          x4_data.position4_float=NodesData[3][0];
-        
- 
-        for (uint8 i=0;i<4;i++)
+    frame[0] = FRAME_SOF;
+    frame[1] = HI_UINT16( addr );
+    frame[2] = LO_UINT16( addr );
+    osal_memcpy(&frame[3], data, 4);
+    frame[7] = XorCheckSum(&frame[1], 6);
+    frame[8] = FRAME_EOF;
     
+    HalUARTWrite(UART0, frame, NODE_FRAME_LEN);
+}
+
+#if !defined(ZDO_COORDINATOR)
+/*********************************************************************
+* @fn      SerialApp_SeqAccept
+*
+* @brief   Latest value wins: accept a table frame only if its sequence
+*          number is newer than the last one accepted from the same sender,
+*          and count lost, duplicate and late (reordered) frames. Sends the
+*          link statistics to UART0 every SERIAL_APP_SEQ_REPORT frames.
+*
+* @param   src - short address of the sender.
+* @param   seq - sequence number of the frame.
+*
+* @return  TRUE if the frame is to be used.
+*/
+static uint8 SerialApp_SeqAccept( uint16 src, uint8 seq )
+{
+    serialAppSeq_t *s = NULL;
+    int8 d;
+    uint8 i, ok = TRUE;
+
+    for ( i = 0; i < SERIAL_APP_SEQ_SRC; i++ )
+    {
+        if ( SerialApp_Seq[i].valid && SerialApp_Seq[i].src == src )
         {
-               TxBuffer[3+i]=x1_data.position1_char[i];
-	      
-               
-               TxBuffer[9+i]=x2_data.position2_char[i];
-	      
-               TxBuffer[15+i]=x3_data.position3_char[i];
-	   
-               
-               TxBuffer[21+i]=x4_data.position4_char[i];
-	
+            s = &SerialApp_Seq[i];
+            break;
+        }
+    }
+
+    if ( s == NULL )                    //µķ,滻ɼ¼
+    {
+        s = &SerialApp_Seq[SerialApp_SeqNext];
+        SerialApp_SeqNext = (SerialApp_SeqNext + 1) % SERIAL_APP_SEQ_SRC;
+        osal_memset( s, 0, sizeof(serialAppSeq_t) );
+        s->src = src;
+    }
+    else
+    {
+        d = (int8)(seq - s->last);
+        if ( d == 0 )
+        {
+            s->dup++;
+            ok = FALSE;
+        }
+        else if ( d < 0 && d >= -SERIAL_APP_SEQ_WINDOW )
+        {
+            s->reorder++;
+            ok = FALSE;
+        }
+        else if ( d > 0 )
+        {
+            s->lost += d - 1;
+        }
+    }
 
-       
-             } 
-       
-         
-	TxBuffer[25] =0x23;
+    if ( ok )
+    {
+        s->last = seq;
+        s->valid = TRUE;
+        s->rx++;
+    }
 
-       
-        
-        HalUARTWrite(UART0, TxBuffer,26);		
-                
-        AF_DataRequest(&Broadcast_DstAddr,
-                       (endPointDesc_t *)&SerialApp_epDesc,
-                        SERIALAPP_CLUSTERID,
-                        26, 
-                        TxBuffer,
-                        &SerialApp_MsgID, 
-                        0, 
-                        AF_DEFAULT_RADIUS);
-           
-		 
-      
+#if SERIAL_APP_SEQ_REPORT
+    if ( ++SerialApp_SeqFrames >= SERIAL_APP_SEQ_REPORT )
+    {
+        SerialApp_SeqFrames = 0;
+        SerialApp_UartWriteLink();
+    }
+#endif
+
+    return ok;
+}
+
+/*********************************************************************
+* @fn      SerialApp_UartWriteLink
+*
+* @brief   Write the link statistics of every sender to UART0, one
+*          0x3F ... 0x23 frame per sender.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_UartWriteLink( void )
+{
+    uint8 frame[LINK_FRAME_LEN];
+    serialAppSeq_t *s;
+    uint8 i;
+
+    for ( i = 0; i < SERIAL_APP_SEQ_SRC; i++ )
+    {
+        s = &SerialApp_Seq[i];
+        if ( !s->valid )
+        {
+            continue;
+        }
+        frame[0]  = LINK_FRAME_SOF;
+        frame[1]  = HI_UINT16( s->src );
+        frame[2]  = LO_UINT16( s->src );
+        frame[3]  = HI_UINT16( s->rx );
+        frame[4]  = LO_UINT16( s->rx );
+        frame[5]  = HI_UINT16( s->lost );
+        frame[6]  = LO_UINT16( s->lost );
+        frame[7]  = HI_UINT16( s->dup );
+        frame[8]  = LO_UINT16( s->dup );
+        frame[9]  = HI_UINT16( s->reorder );
+        frame[10] = LO_UINT16( s->reorder );
+        frame[11] = XorCheckSum(&frame[1], 10);
+        frame[12] = FRAME_EOF;
+        HalUARTWrite(UART0, frame, LINK_FRAME_LEN);
+    }
+}
+#endif
+
+/*********************************************************************
+* @fn      XorCheckSum
+*
+* @brief   XOR of len bytes.
+*
+* @return  checksum
+*/
+static uint8 XorCheckSum(uint8 * pBuf, uint8 len)
+{
+    uint8 i;
+    uint8 byRet = 0;
+    
+    for (i = 0; i < len; i++)
+    {
+        byRet ^= pBuf[i];
+    }
+    return byRet;
+}
+
+/*********************************************************************
+* @fn      SerialApp_SendPeriodicMessage
+*
+* @brief   Write every node to UART0 as a node frame and send the node
+*          table OTA as slot-table frames, as many slots per frame as the
+*          AF MTU allows, in the mode chosen by SerialApp_DistSelect.
+*          Every SERIAL_APP_KEY_INTERVAL frames, or when a value has moved
+*          too far for a 16-bit delta, a keyframe is sent.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_SendPeriodicMessage( void )
+{
+    afDataReqMTU_t mtu;
+    uint8 per, delta, i;
+
+#if !SERIAL_APP_UART_TABLE
+    for ( i = 0; i < MAX_NODE; i++ )
+    {
+        SerialApp_UartWriteNode(EndDeviceID[i], (uint8 *)NodesData[i]);
+    }
+#endif
+
+    SerialApp_TxSeq++;
+    delta = ( SerialApp_KeyAge + 1 < SERIAL_APP_KEY_INTERVAL ) &&
+            SlotFrame_DeltaFits( MAX_NODE * SUM_NUM, SUM_NUM, NodesData[0],
+                                 SerialApp_Key[0], SerialApp_DeltaExp );
+    if ( delta )
+    {
+        SerialApp_KeyAge++;
+    }
+    else
+    {
+        SerialApp_KeyAge = 0;
+        SerialApp_KeyId++;
+        osal_memcpy( SerialApp_Key, NodesData, sizeof(SerialApp_Key) );
+    }
+
+    mtu.kvp = FALSE;
+    mtu.aps.secure = FALSE;
+    i = afDataReqMTU( &mtu );
+    if ( i > SERIAL_APP_SLOT_BUF )
+    {
+        i = SERIAL_APP_SLOT_BUF;
+    }
+    per = SlotFrame_Capacity( i, SUM_NUM, delta );
+    if ( per == 0 )
+    {
+        return;
+    }
+
+#if defined(ZDO_COORDINATOR)
+    switch ( SerialApp_DistSelect() )
+    {
+    case SERIAL_APP_DIST_UNICAST:   //ÿնֻյԼĲ
+      for ( i = 0; i < MAX_NODE; i++ )
+      {
+          if ( NodeReg_Slot( i ) != NULL )
+          {
+              Node_DstAddr.addr.shortAddr = NodeReg_Slot( i )->shortAddr;
+              SerialApp_SendSlots( &Node_DstAddr, i, 1, per, delta );
+          }
+      }
+      return;
+
+    case SERIAL_APP_DIST_GROUP:
+      SerialApp_SendSlots( &Group_DstAddr, 0, MAX_NODE, per, delta );
+      return;
+
+    default:
+      break;
+    }
+#endif
+    SerialApp_SendSlots( &Broadcast_DstAddr, 0, MAX_NODE, per, delta );
+}
+
+/*********************************************************************
+* @fn      SerialApp_SendSlots
+*
+* @brief   Send count slots starting at first, per slots per frame.
+*
+* @param   dstAddr - destination.
+* @param   first   - first slot.
+* @param   count   - number of slots.
+* @param   per     - slots per frame.
+* @param   delta   - TRUE for delta frames against SerialApp_Key.
+*
+* @return  none
+*/
+static void SerialApp_SendSlots( afAddrType_t *dstAddr, uint8 first, uint8 count,
+                                 uint8 per, uint8 delta )
+{
+    uint8 n, len;
+
+    while ( count )
+    {
+        n = (count > per) ? per : count;
+        if ( delta )
+        {
+            len = SlotFrame_BuildDelta( SerialApp_SlotBuf, SerialApp_TxSeq, SerialApp_KeyId,
+                                        first, n, SUM_NUM, NodesData[first],
+                                        SerialApp_Key[first], SerialApp_DeltaExp );
+        }
+        else
+        {
+            len = SlotFrame_Build( SerialApp_SlotBuf, SerialApp_TxSeq, SerialApp_KeyId,
+                                   first, n, SUM_NUM, NodesData[first] );
+        }
+#if SERIAL_APP_UART_TABLE
+        HalUARTWrite( UART0, SerialApp_SlotBuf, len );
+#endif
+        SerialApp_Send( dstAddr, SERIALAPP_CLUSTERID, len, SerialApp_SlotBuf );
+        first += n;
+        count -= n;
+    }
 }
 
+#if defined(ZDO_COORDINATOR)
+/*********************************************************************
+* @fn      SerialApp_DistSelect
+*
+* @brief   Resolve SERIAL_APP_DIST_AUTO. One unicast per node costs a
+*          frame per node but wakes only the addressee; a broadcast is
+*          one frame that every router repeats, that takes a broadcast
+*          transaction table entry, and that every device has to filter.
+*          A group frame is repeated the same way but is dropped by the
+*          APS of devices outside the group.
+*
+* @param   none
+*
+* @return  SERIAL_APP_DIST_UNICAST, _GROUP or _BROADCAST
+*/
+static uint8 SerialApp_DistSelect( void )
+{
+    uint8 n = NodeReg_Count();
 
+    if ( SerialApp_DistMode != SERIAL_APP_DIST_AUTO )
+    {
+        return SerialApp_DistMode;
+    }
+
+    if ( n == 0 )
+    {
+        return SERIAL_APP_DIST_BROADCAST;   //ûն˵Ǽ
+    }
+    return ( n <= SERIAL_APP_UNICAST_MAX ) ? SERIAL_APP_DIST_UNICAST
+                                           : SERIAL_APP_DIST_GROUP;
+}
+#endif
+
+#if defined(ZDO_COORDINATOR)
+/*********************************************************************
+* @fn      SerialApp_SendBeacon
+*
+* @brief   Start a superframe: broadcast the bitmap of registered slots,
+*          from which every end device derives its uplink slot, and free
+*          the slots of nodes that stopped sending.
+*
+* @param   none
+*
+* @return  superframe length in ms
+*/
+static uint16 SerialApp_SendBeacon( void )
+{
+    uint8 buf[BEACON_OVERHEAD + BEACON_MAP_LEN];
+    nodeRegEntry_t *e;
+    uint8 ieee[Z_EXTADDR_LEN];
+    uint8 i, n = 0;
+    uint16 period;
+
+    osal_memset( &buf[BEACON_HDR_LEN], 0, BEACON_MAP_LEN );
+    for ( i = 0; i < MAX_NODE; i++ )
+    {
+        e = NodeReg_Slot( i );
+        if ( e == NULL )
+        {
+            continue;
+        }
+#if SERIAL_APP_UPLINK_MISS
+        if ( ++SerialApp_UplinkMiss[i] > SERIAL_APP_UPLINK_MISS )
+        {
+            osal_memcpy( ieee, e->ieee, Z_EXTADDR_LEN );
+            NodeReg_Remove( ieee );      //ն뿪,նʱ϶ǰ
+            continue;
+        }
+#endif
+        buf[BEACON_HDR_LEN + (i >> 3)] |= BV( i & 7 );
+        n++;
+    }
+
+    buf[0] = BEACON_SOF;
+    buf[1] = SerialApp_TxSeq + 1;        //뱾֡ݱ֡ͬһ
+    buf[2] = SERIAL_APP_UPLINK_GUARD;
+    buf[3] = SERIAL_APP_UPLINK_SLOT;
+    buf[4] = BEACON_MAP_LEN;
+    buf[BEACON_HDR_LEN + BEACON_MAP_LEN] = XorCheckSum( &buf[1], BEACON_HDR_LEN - 1 + BEACON_MAP_LEN );
+    buf[BEACON_HDR_LEN + BEACON_MAP_LEN + 1] = FRAME_EOF;
+
+    SerialApp_Send( &Broadcast_DstAddr, SERIALAPP_CLUSTERID, sizeof(buf), buf );
+
+    period = SERIAL_APP_UPLINK_GUARD + (uint16)(n + 1) * SERIAL_APP_UPLINK_SLOT;
+    osal_start_timerEx( SerialApp_TaskID, SERIALAPP_REPORT_EVT, period );   //ϱʱ϶
+    return ( period > SERIALAPP_SEND_PERIODIC_TIMEOUT ) ? period
+                                                        : SERIALAPP_SEND_PERIODIC_TIMEOUT;
+}
+
+/*********************************************************************
+* @fn      SerialApp_Report
+*
+* @brief   Write the slots that end devices sent in this superframe to
+*          UART0 in as few report frames as SERIAL_APP_SLOT_BUF allows.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_Report( void )
+{
+    uint8 *p = &SerialApp_SlotBuf[REPORT_HDR_LEN];
+    uint8 per = (SERIAL_APP_SLOT_BUF - REPORT_HDR_LEN - 2) / (1 + SUM_NUM * sizeof(float));
+    uint8 i, n = 0, len;
+
+    for ( i = 0; i < MAX_NODE; i++ )
+    {
+        if ( SerialApp_Fresh[i >> 3] & BV( i & 7 ) )
+        {
+            *p++ = i;
+            osal_memcpy( p, NodesUplink[i], SUM_NUM * sizeof(float) );
+            p += SUM_NUM * sizeof(float);
+            n++;
+        }
+
+        if ( n != 0 && ( n == per || i == MAX_NODE - 1 ) )
+        {
+            SerialApp_SlotBuf[0] = REPORT_SOF;
+            SerialApp_SlotBuf[1] = SerialApp_TxSeq;
+            SerialApp_SlotBuf[2] = n;
+            SerialApp_SlotBuf[3] = SUM_NUM;
+            len = (uint8)(p - SerialApp_SlotBuf);
+            *p++ = XorCheckSum( &SerialApp_SlotBuf[1], len - 1 );
+            *p = FRAME_EOF;
+            HalUARTWrite( UART0, SerialApp_SlotBuf, len + 2 );
+            p = &SerialApp_SlotBuf[REPORT_HDR_LEN];
+            n = 0;
+        }
+    }
+
+    osal_memset( SerialApp_Fresh, 0, sizeof(SerialApp_Fresh) );
+}
+#else
+/*********************************************************************
+* @fn      SerialApp_Beacon
+*
+* @brief   Superframe start. The uplink slot is the rank of our table
+*          slot among the registered ones; a slot missing from the bitmap
+*          was freed by the coordinator, so register again.
+*
+* @param   buf - beacon frame.
+* @param   len - its length.
+*
+* @return  none
+*/
+static void SerialApp_Beacon( uint8 *buf, uint16 len )
+{
+    uint8 i, rank = 0;
+
+    if ( len < BEACON_OVERHEAD || len != BEACON_OVERHEAD + buf[4] ||
+         buf[len - 1] != FRAME_EOF ||
+         buf[len - 2] != XorCheckSum( &buf[1], len - 3 ) ||
+         SerialApp_MySlot == SLOT_FRAME_NONE )
+    {
+        return;
+    }
+
+    if ( (SerialApp_MySlot >> 3) >= buf[4] ||
+         !( buf[BEACON_HDR_LEN + (SerialApp_MySlot >> 3)] & BV( SerialApp_MySlot & 7 ) ) )
+    {
+        SerialApp_MySlot = SLOT_FRAME_NONE;
+        osal_set_event( SerialApp_TaskID, SERIALAPP_ANNOUNCE_EVT );
+        return;
+    }
+
+    for ( i = 0; i < SerialApp_MySlot; i++ )
+    {
+        if ( buf[BEACON_HDR_LEN + (i >> 3)] & BV( i & 7 ) )
+        {
+            rank++;
+        }
+    }
+
+    SerialApp_UplinkSeq = buf[1];
+    osal_start_timerEx( SerialApp_TaskID, SERIALAPP_UPLINK_EVT,
+                        buf[2] + (uint16)rank * buf[3] );
+}
+
+/*********************************************************************
+* @fn      SerialApp_SendUplink
+*
+* @brief   Send the values of our slot to the coordinator as a one-slot
+*          keyframe.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_SendUplink( void )
+{
+    uint8 len;
+
+    if ( SerialApp_MySlot >= MAX_NODE )
+    {
+        return;
+    }
+
+    len = SlotFrame_Build( SerialApp_SlotBuf, SerialApp_UplinkSeq, 0, SerialApp_MySlot, 1,
+                           SUM_NUM, NodesData[SerialApp_MySlot] );
+
+    SerialApp_TxAddr.addrMode = (afAddrMode_t)Addr16Bit;
+    SerialApp_TxAddr.endPoint = SERIALAPP_ENDPOINT;
+    SerialApp_TxAddr.addr.shortAddr = 0x0000;
+    SerialApp_Send( &SerialApp_TxAddr, SERIALAPP_CLUSTERID, len, SerialApp_SlotBuf );
+
+#if SERIAL_APP_UPLINK_SRC == SERIAL_APP_UPLINK_DHT11
+    DHT11();                             //һʪ,¸֡ϱ
+    NodesData[SerialApp_MySlot][0] = wendu;
+#if SUM_NUM > 1
+    NodesData[SerialApp_MySlot][1] = shidu;
+#endif
+#endif
+}
+
+#if SERIAL_APP_UPLINK_SRC == SERIAL_APP_UPLINK_UART
+/*********************************************************************
+* @fn      SerialApp_UplinkParse
+*
+* @brief   Collect the node frames the STM32 writes to UART0 in
+*          SerialApp_TxBuf. The address field of a frame is the channel
+*          of our slot it sets. Garbage is skipped up to the next 0x3A.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_UplinkParse( void )
+{
+    uint16 chan;
+    uint8 i;
+
+    while ( HalUARTRead( UART0, &SerialApp_TxBuf[SerialApp_TxLen], 1 ) )
+    {
+        SerialApp_UartBytes++;
+        if ( SerialApp_TxLen == 0 && SerialApp_TxBuf[0] != FRAME_SOF )
+        {
+            continue;
+        }
+        if ( ++SerialApp_TxLen < NODE_FRAME_LEN )
+        {
+            continue;
+        }
+
+        if ( SerialApp_TxBuf[8] == FRAME_EOF &&
+             SerialApp_TxBuf[7] == XorCheckSum( &SerialApp_TxBuf[1], 6 ) )
+        {
+            chan = BUILD_UINT16( SerialApp_TxBuf[2], SerialApp_TxBuf[1] );
+            if ( chan < SUM_NUM && SerialApp_MySlot < MAX_NODE )
+            {
+                osal_memcpy( &NodesData[SerialApp_MySlot][chan], &SerialApp_TxBuf[3], sizeof(float) );
+            }
+            SerialApp_TxLen = 0;
+            continue;
+        }
+
+        for ( i = 1; i < NODE_FRAME_LEN && SerialApp_TxBuf[i] != FRAME_SOF; i++ )
+        {
+        }
+        SerialApp_TxLen = NODE_FRAME_LEN - i;
+        osal_memcpy( SerialApp_TxBuf, &SerialApp_TxBuf[i], SerialApp_TxLen );
+    }
+}
+#endif
+#endif
 
 /*********************************************************************
 * @fn      SerialApp_Resp
 *
-* @brief   Send data OTA.
+* @brief   Send data OTA, retrying SERIAL_APP_RSP_RETRY times at most.
 *
 * @param   none
 *
@@ -511,20 +1318,53 @@ void SerialApp_SendPeriodicMessage( void )//
 */
 static void SerialApp_Resp(void)
 {
-	if (afStatus_SUCCESS != AF_DataRequest(&SerialApp_RxAddr,
-		(endPointDesc_t *)&SerialApp_epDesc,
-		SERIALAPP_CLUSTERID2,
-		SERIAL_APP_RSP_CNT, SerialApp_RspBuf,
-		&SerialApp_MsgID, 0, AF_DEFAULT_RADIUS))
+	if (afStatus_SUCCESS != SerialApp_Send(&SerialApp_RxAddr, SERIALAPP_CLUSTERID2,
+		SERIAL_APP_RSP_CNT, SerialApp_RspBuf) &&
+		++SerialApp_RspRetry < SERIAL_APP_RSP_RETRY)
 	{
-		osal_set_event(SerialApp_TaskID, SERIALAPP_RESP_EVT);
+		osal_start_timerEx(SerialApp_TaskID, SERIALAPP_RESP_EVT, SERIALAPP_NAK_DELAY);
+		return;
 	}
+	SerialApp_RspRetry = 0;
+}
+
+/*********************************************************************
+* @fn      SerialApp_Send
+*
+* @brief   AF_DataRequest through the rate controller: refused while too
+*          many requests wait for their confirm, and the result is fed
+*          back to the controller.
+*
+* @param   dstAddr   - destination.
+* @param   clusterId - cluster.
+* @param   len       - length of buf.
+* @param   buf       - data.
+*
+* @return  afStatus_SUCCESS, or afStatus_MEM_FAIL if not sent.
+*/
+static afStatus_t SerialApp_Send( afAddrType_t *dstAddr, uint16 clusterId,
+                                  uint8 len, uint8 *buf )
+{
+    afStatus_t status;
+
+    if ( !RateCtl_CanSend( &SerialApp_Rate ) )
+    {
+        return afStatus_MEM_FAIL;
+    }
+
+    status = AF_DataRequest( dstAddr, (endPointDesc_t *)&SerialApp_epDesc, clusterId,
+                             len, buf, &SerialApp_MsgID, 0, AF_DEFAULT_RADIUS );
+    RateCtl_Sent( &SerialApp_Rate, status );
+    return status;
 }
 
 /*********************************************************************
 * @fn      SerialApp_CallBack
 *
-* @brief   Send data OTA.
+* @brief   Move the received bytes into SerialApp_TxBuf and send it OTA
+*          whenever it is full. A partly filled buffer is sent by
+*          SERIALAPP_SEND_EVT when the deadline expires. Bytes that do not
+*          fit while the channel is busy stay in the UART driver.
 *
 * @param   port - UART port.
 * @param   event - the UART port event flag.
@@ -533,28 +1373,172 @@ static void SerialApp_Resp(void)
 */
 static void SerialApp_CallBack(uint8 port, uint8 event)
 {
+#if defined(ZDO_COORDINATOR) || SERIAL_APP_UPLINK_SRC != SERIAL_APP_UPLINK_UART
+	uint8 size = SerialApp_TxSize();
+	uint8 n;
+#endif
+	
 	(void)port;
 	
-	if ((event & (HAL_UART_RX_FULL | HAL_UART_RX_ABOUT_FULL | HAL_UART_RX_TIMEOUT)) &&
+	if (!(event & (HAL_UART_RX_FULL | HAL_UART_RX_ABOUT_FULL | HAL_UART_RX_TIMEOUT)))
+	{
+		return;
+	}
+	
+#if !defined(ZDO_COORDINATOR) && SERIAL_APP_UPLINK_SRC == SERIAL_APP_UPLINK_UART
+	SerialApp_UplinkParse();           //յSTM32Ĳֵ,ϱʱ϶Э
+#else
+	for (;;)
+	{
+		n = (uint8)HalUARTRead(UART0, &SerialApp_TxBuf[SerialApp_TxLen], size - SerialApp_TxLen);
+		SerialApp_TxLen += n;
+		SerialApp_UartBytes += n;
+		if (SerialApp_TxLen < size || !SerialApp_Flush())
+		{
+			break;
+		}
+	}
+	
+	if (SerialApp_TxLen && !osal_get_timeoutEx(SerialApp_TaskID, SERIALAPP_SEND_EVT))
+	{
+		osal_start_timerEx(SerialApp_TaskID, SERIALAPP_SEND_EVT, SERIAL_APP_TX_DEADLINE);
+	}
+#endif
+}
+
+#if defined(ZDO_COORDINATOR) || SERIAL_APP_UPLINK_SRC != SERIAL_APP_UPLINK_UART
+/*********************************************************************
+* @fn      SerialApp_TxSize
+*
+* @brief   Bytes of UART0 data per OTA frame.
+*
+* @param   none
+*
+* @return  the smaller of SERIAL_APP_TX_MAX and the AF MTU
+*/
+static uint8 SerialApp_TxSize( void )
+{
 #if SERIAL_APP_LOOPBACK
-		(SerialApp_TxLen < SERIAL_APP_TX_MAX))
+	return SERIAL_APP_TX_MAX;
 #else
-		!SerialApp_TxLen)
+	afDataReqMTU_t mtu;
+	uint8 size;
+	
+	mtu.kvp = FALSE;
+	mtu.aps.secure = FALSE;
+	size = afDataReqMTU( &mtu );
+	return ( size < SERIAL_APP_TX_MAX ) ? size : SERIAL_APP_TX_MAX;
+#endif
+}
 #endif
+
+/*********************************************************************
+* @fn      SerialApp_Flush
+*
+* @brief   Send the collected UART0 bytes in one request: from an end
+*          device to the coordinator, from the coordinator to every
+*          device. Bytes received before joining have nowhere to go and
+*          are dropped. In loopback mode they are written back to UART0.
+*
+* @param   none
+*
+* @return  FALSE if the bytes could not be sent yet.
+*/
+static uint8 SerialApp_Flush( void )
+{
+	if ( SerialApp_TxLen == 0 )
 	{
-		SerialApp_SendPeriodicMessage();
+		return TRUE;
 	}
+	
+#if SERIAL_APP_LOOPBACK
+	if ( HalUARTWrite( UART0, SerialApp_TxBuf, SerialApp_TxLen ) == 0 )
+	{
+		return FALSE;
+	}
+	SerialApp_AirBytes += SerialApp_TxLen;
+#else
+	if ( (SerialApp_NwkState == DEV_ZB_COORD)
+		|| (SerialApp_NwkState == DEV_ROUTER)
+		|| (SerialApp_NwkState == DEV_END_DEVICE) )
+	{
+#if defined(ZDO_COORDINATOR)
+		if ( SerialApp_Send( &Broadcast_DstAddr, SERIALAPP_CLUSTERID2,
+		                     SerialApp_TxLen, SerialApp_TxBuf ) != afStatus_SUCCESS )
+#else
+		SerialApp_TxAddr.addrMode = (afAddrMode_t)Addr16Bit;
+		SerialApp_TxAddr.endPoint = SERIALAPP_ENDPOINT;
+		SerialApp_TxAddr.addr.shortAddr = 0x0000;
+		if ( SerialApp_Send( &SerialApp_TxAddr, SERIALAPP_CLUSTERID2,
+		                     SerialApp_TxLen, SerialApp_TxBuf ) != afStatus_SUCCESS )
+#endif
+		{
+			return FALSE;
+		}
+		SerialApp_AirBytes += SerialApp_TxLen;
+	}
+#endif
+	
+	SerialApp_TxLen = 0;
+	osal_stop_timerEx( SerialApp_TaskID, SERIALAPP_SEND_EVT );
+	return TRUE;
+}
+
+#if defined ( LCD_SUPPORTED )
+/*********************************************************************
+* @fn      SerialApp_Throughput
+*
+* @brief   Show the bytes per second read from UART0 and sent OTA (or
+*          looped back) since the last report. With OSAL_TASK_METRICS,
+*          also show the task (index into tasksArr) whose event handler
+*          ran longest in that time, and for how many OSAL_TASK_CLOCK()
+*          ticks.
+*
+* @param   none
+*
+* @return  none
+*/
+static void SerialApp_Throughput( void )
+{
+	static uint32 uartLast, airLast;
+#if ( OSAL_TASK_METRICS )
+	osalTaskStats_t stats;
+	uint16 worst = 0;
+	uint8 i, slow = 0;
+#endif
+	
+	HalLcdWriteStringValue( "UART B/s", (uint16)((SerialApp_UartBytes - uartLast) *
+	                        1000 / SERIAL_APP_TPUT_PERIOD), 10, HAL_LCD_LINE_3 );
+	HalLcdWriteStringValue( "Air B/s", (uint16)((SerialApp_AirBytes - airLast) *
+	                        1000 / SERIAL_APP_TPUT_PERIOD), 10, HAL_LCD_LINE_4 );
+	uartLast = SerialApp_UartBytes;
+	airLast = SerialApp_AirBytes;
+	
+#if ( OSAL_TASK_METRICS )
+	for ( i = 0; i < tasksCnt; i++ )   //ҳڵδõ,λӳټЭջһ
+	{
+		osal_task_stats( i, &stats, TRUE );
+		if ( stats.maxTicks > worst )
+		{
+			worst = stats.maxTicks;
+			slow = i;
+		}
+	}
+	HalLcdWriteStringValueValue( "Slow", slow, 10, worst, 10, HAL_LCD_LINE_2 );
+#endif
 }
+#endif
 
 
 
 
 
 
+#if !defined(ZDO_COORDINATOR)
 void AfSendAddrInfo(void)
 {
     uint16 shortAddr;
-    uint8 strBuf[11]={0};  
+    uint8 strBuf[ADDR_INFO_LEN]={0};  
     
     SerialApp_TxAddr.addrMode = (afAddrMode_t)Addr16Bit;
     SerialApp_TxAddr.endPoint = SERIALAPP_ENDPOINT;
@@ -567,14 +1551,11 @@ void AfSendAddrInfo(void)
     strBuf[2] = LO_UINT16( shortAddr );        //Ŷ̵ַ8λ
     
     osal_memcpy(&strBuf[3], NLME_GetExtAddr(), 8);
+    strBuf[11] = HI_UINT16( SERIAL_APP_NODE_ID );   //ڵ,ЭȷýڵŵĲ
+    strBuf[12] = LO_UINT16( SERIAL_APP_NODE_ID );
         
-   if ( AF_DataRequest( &SerialApp_TxAddr, (endPointDesc_t *)&SerialApp_epDesc,
-                       SERIALAPP_CLUSTERID,
-                       11,
-                       strBuf,
-                       &SerialApp_MsgID, 
-                       0, 
-                       AF_DEFAULT_RADIUS ) == afStatus_SUCCESS )
+   if ( SerialApp_Send( &SerialApp_TxAddr, SERIALAPP_CLUSTERID,
+                        ADDR_INFO_LEN, strBuf ) == afStatus_SUCCESS )
   {
   }
   else
@@ -582,6 +1563,7 @@ void AfSendAddrInfo(void)
     // Error occurred in request to send.
   }   
 }
+#endif
 
 
 
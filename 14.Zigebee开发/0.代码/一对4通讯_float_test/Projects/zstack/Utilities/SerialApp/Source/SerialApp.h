@@ -67,11 +67,19 @@ extern "C"
 #define SERIALAPP_CLUSTERID              1
 #define SERIALAPP_CLUSTERID2             2
 
+// APS group joined by every end device for multicast of the node table
+#define SERIALAPP_GROUP_ID               0x0001
+
 #define SERIALAPP_SEND_EVT               0x0001
 #define SERIALAPP_RESP_EVT               0x0002
-#define SERIALAPP_SEND_PERIODIC_EVT      0x0003
+#define SERIALAPP_SEND_PERIODIC_EVT      0x0004
+#define SERIALAPP_ANNOUNCE_EVT           0x0008
+#define SERIALAPP_UPLINK_EVT             0x0010
+#define SERIALAPP_TPUT_EVT               0x0020
+#define SERIALAPP_REPORT_EVT             0x0040
   
 #define SERIALAPP_SEND_PERIODIC_TIMEOUT  500
+#define SERIALAPP_ANNOUNCE_TIMEOUT       2000
 
 // OTA Flow Control Delays
 #define SERIALAPP_ACK_DELAY              1
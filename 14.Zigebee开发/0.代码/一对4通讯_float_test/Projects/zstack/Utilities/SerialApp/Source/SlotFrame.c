@@ -0,0 +1,321 @@
+/*********************************************************************
+* INCLUDES
+*/
+#include "OSAL.h"
+#include "SlotFrame.h"
+
+/*********************************************************************
+* LOCAL FUNCTIONS
+*/
+
+static uint8 SlotFrame_Xor( const uint8 *pBuf, uint16 len );
+static float SlotFrame_Pow2( int8 e );
+static int16 SlotFrame_Quantize( float d, float inv );
+
+/*********************************************************************
+* @fn      SlotFrame_Capacity
+*
+* @brief   Slots per frame for a given MTU.
+*
+* @param   mtu   - max frame length, e.g. from afDataReqMTU().
+* @param   m     - values per slot.
+* @param   delta - TRUE for a delta frame.
+*
+* @return  number of slots, 0 if not even one slot fits.
+*/
+uint8 SlotFrame_Capacity( uint8 mtu, uint8 m, uint8 delta )
+{
+    uint8 overhead = SLOT_FRAME_OVERHEAD + (delta ? m : 0);
+
+    if ( m == 0 || mtu <= overhead )
+    {
+        return 0;
+    }
+    return (uint8)((mtu - overhead) / (m * (delta ? sizeof(int16) : sizeof(float))));
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Build
+*
+* @brief   Encode count slots of m floats into a keyframe.
+*
+* @param   buf   - destination, at least SLOT_FRAME_OVERHEAD + count*m*4 bytes.
+* @param   seq   - sequence number.
+* @param   id    - keyframe id.
+* @param   first - index of the first slot.
+* @param   count - number of slots.
+* @param   m     - floats per slot.
+* @param   data  - count * m floats.
+*
+* @return  frame length
+*/
+uint8 SlotFrame_Build( uint8 *buf, uint8 seq, uint8 id, uint8 first, uint8 count,
+                       uint8 m, const float *data )
+{
+    uint8 n = (uint8)(count * m * sizeof(float));
+
+    buf[0] = SLOT_FRAME_SOF;
+    buf[1] = seq;
+    buf[2] = id;
+    buf[3] = first;
+    buf[4] = count;
+    buf[5] = m;
+    osal_memcpy(&buf[SLOT_FRAME_HDR_LEN], (void *)data, n);
+    buf[SLOT_FRAME_HDR_LEN + n] = SlotFrame_Xor(&buf[1], SLOT_FRAME_HDR_LEN - 1 + n);
+    buf[SLOT_FRAME_HDR_LEN + n + 1] = SLOT_FRAME_EOF;
+
+    return (uint8)(n + SLOT_FRAME_OVERHEAD);
+}
+
+/*********************************************************************
+* @fn      SlotFrame_DeltaFits
+*
+* @brief   Check that a delta frame can carry the values.
+*
+* @param   n    - number of values.
+* @param   m    - values per slot.
+* @param   data - current values.
+* @param   key  - keyframe values.
+* @param   exp  - m quantum exponents.
+*
+* @return  TRUE if no delta overflows 16 bits.
+*/
+uint8 SlotFrame_DeltaFits( uint16 n, uint8 m, const float *data,
+                           const float *key, const int8 *exp )
+{
+    float inv[SLOT_FRAME_M_MAX];
+    float d;
+    uint16 i;
+    uint8 j;
+
+    if ( m > SLOT_FRAME_M_MAX )
+    {
+        return FALSE;
+    }
+    for ( j = 0; j < m; j++ )
+    {
+        inv[j] = SlotFrame_Pow2( -exp[j] );
+    }
+
+    for ( i = 0, j = 0; i < n; i++ )
+    {
+        d = (data[i] - key[i]) * inv[j];
+        if ( d > 32767.0f || d < -32767.0f )
+        {
+            return FALSE;
+        }
+        if ( ++j == m )
+        {
+            j = 0;
+        }
+    }
+    return TRUE;
+}
+
+/*********************************************************************
+* @fn      SlotFrame_BuildDelta
+*
+* @brief   Encode count slots of m values as 16-bit deltas against the
+*          keyframe. Call SlotFrame_DeltaFits first; deltas that do not
+*          fit are clipped.
+*
+* @param   buf   - destination.
+* @param   seq   - sequence number.
+* @param   id    - keyframe id of key.
+* @param   first - index of the first slot.
+* @param   count - number of slots.
+* @param   m     - values per slot.
+* @param   data  - count * m current values.
+* @param   key   - count * m keyframe values.
+* @param   exp   - m quantum exponents.
+*
+* @return  frame length
+*/
+uint8 SlotFrame_BuildDelta( uint8 *buf, uint8 seq, uint8 id, uint8 first, uint8 count,
+                            uint8 m, const float *data, const float *key,
+                            const int8 *exp )
+{
+    float inv[SLOT_FRAME_M_MAX];
+    uint8 *p;
+    int16 d;
+    uint16 i, n = (uint16)count * m;
+    uint8 j;
+
+    buf[0] = SLOT_FRAME_DELTA_SOF;
+    buf[1] = seq;
+    buf[2] = id;
+    buf[3] = first;
+    buf[4] = count;
+    buf[5] = m;
+    for ( j = 0; j < m; j++ )
+    {
+        buf[SLOT_FRAME_HDR_LEN + j] = (uint8)exp[j];
+        inv[j] = SlotFrame_Pow2( -exp[j] );
+    }
+
+    p = &buf[SLOT_FRAME_HDR_LEN + m];
+    for ( i = 0, j = 0; i < n; i++ )
+    {
+        d = SlotFrame_Quantize( data[i] - key[i], inv[j] );
+        *p++ = LO_UINT16( d );
+        *p++ = HI_UINT16( d );
+        if ( ++j == m )
+        {
+            j = 0;
+        }
+    }
+
+    *p = SlotFrame_Xor(&buf[1], (uint16)(p - &buf[1]));
+    p[1] = SLOT_FRAME_EOF;
+
+    return (uint8)(p + 2 - buf);
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Check
+*
+* @brief   Check a received frame where it lies, without copying it.
+*
+* @param   buf  - received frame.
+* @param   len  - received length.
+* @param   slot - slot wanted.
+*
+* @return  TRUE if the frame is valid and carries slot.
+*/
+uint8 SlotFrame_Check( uint8 *buf, uint16 len, uint8 slot )
+{
+    uint16 n;
+    uint8 delta, m;
+
+    if ( len < SLOT_FRAME_OVERHEAD ||
+         ( buf[0] != SLOT_FRAME_SOF && buf[0] != SLOT_FRAME_DELTA_SOF ) )
+    {
+        return FALSE;
+    }
+    delta = ( buf[0] == SLOT_FRAME_DELTA_SOF );
+
+    m = buf[5];
+    if ( m == 0 || m > SLOT_FRAME_M_MAX )
+    {
+        return FALSE;
+    }
+    n = SLOT_FRAME_OVERHEAD + (delta ? m : 0) +
+        (uint16)buf[4] * m * (delta ? sizeof(int16) : sizeof(float));
+    if ( len != n ||
+         buf[len - 1] != SLOT_FRAME_EOF ||
+         buf[len - 2] != SlotFrame_Xor(&buf[1], len - 3) )
+    {
+        return FALSE;
+    }
+
+    return ( slot >= buf[3] && slot - buf[3] < buf[4] );
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Decode
+*
+* @brief   Index the slot directly, without scanning the other slots.
+*
+* @param   buf  - frame that passed SlotFrame_Check for slot.
+* @param   slot - slot wanted.
+* @param   k    - key state of that slot.
+* @param   out  - returns the values of the slot.
+*
+* @return  number of values, 0 for a delta without its keyframe.
+*/
+uint8 SlotFrame_Decode( uint8 *buf, uint8 slot, slotFrameKey_t *k, float *out )
+{
+    uint8 *p;
+    uint8 m = buf[5];
+    uint8 j;
+    int16 d;
+
+    if ( buf[0] == SLOT_FRAME_SOF )
+    {
+        p = &buf[SLOT_FRAME_HDR_LEN + (uint16)(slot - buf[3]) * m * sizeof(float)];
+        osal_memcpy( out, p, m * sizeof(float) );
+        osal_memcpy( k->key, p, m * sizeof(float) );
+        k->id = buf[2];
+        k->valid = TRUE;
+        return m;
+    }
+
+    if ( !k->valid || k->id != buf[2] )
+    {
+        return 0;
+    }
+    p = &buf[SLOT_FRAME_HDR_LEN + m + (uint16)(slot - buf[3]) * m * sizeof(int16)];
+    for ( j = 0; j < m; j++, p += 2 )
+    {
+        d = (int16)BUILD_UINT16( p[0], p[1] );
+        out[j] = k->key[j] + d * SlotFrame_Pow2( (int8)buf[SLOT_FRAME_HDR_LEN + j] );
+    }
+    return m;
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Xor
+*
+* @brief   XOR of len bytes.
+*
+* @return  checksum
+*/
+static uint8 SlotFrame_Xor( const uint8 *pBuf, uint16 len )
+{
+    uint8 x = 0;
+
+    while ( len-- )
+    {
+        x ^= *pBuf++;
+    }
+    return x;
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Pow2
+*
+* @brief   2^e, exact, without pulling in the math library.
+*
+* @return  2^e
+*/
+static float SlotFrame_Pow2( int8 e )
+{
+    float f = 1.0f;
+
+    for ( ; e > 0; e-- )
+    {
+        f *= 2.0f;
+    }
+    for ( ; e < 0; e++ )
+    {
+        f *= 0.5f;
+    }
+    return f;
+}
+
+/*********************************************************************
+* @fn      SlotFrame_Quantize
+*
+* @brief   Round d / quantum to the nearest int16, clipping.
+*
+* @param   d   - difference to the key.
+* @param   inv - 1 / quantum.
+*
+* @return  delta in quanta
+*/
+static int16 SlotFrame_Quantize( float d, float inv )
+{
+    d *= inv;
+    if ( d >= 32767.0f )
+    {
+        return 32767;
+    }
+    if ( d <= -32767.0f )
+    {
+        return -32767;
+    }
+    return (int16)( d >= 0 ? d + 0.5f : d - 0.5f );
+}
+
+/*********************************************************************
+*********************************************************************/
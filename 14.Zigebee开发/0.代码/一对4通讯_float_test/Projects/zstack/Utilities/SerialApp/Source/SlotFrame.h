@@ -0,0 +1,130 @@
+/**************************************************************************************************
+  Filename:       SlotFrame.h
+
+  Description:    Slot-table frames used by the coordinator to distribute the
+                  node table OTA.
+
+                  [0]      SLOT_FRAME_SOF (0x3C, keyframe) or
+                           SLOT_FRAME_DELTA_SOF (0x3E, delta frame)
+                  [1]      sequence number, one per period of the sender
+                  [2]      keyframe id
+                  [3]      index of the first slot in this frame
+                  [4]      number of slots in this frame (count)
+                  [5]      values per slot (m, SUM_NUM)
+                  [6..]    delta frame only: m int8 exponents e, one per
+                           channel; the quantum of channel j is 2^e[j]
+                  [..]     count * m values, slot after slot: 4-byte floats
+                           in a keyframe, little-endian int16 in a delta frame
+                  [..]     xor of all bytes from [1] to the last value byte
+                  [..]     SLOT_FRAME_EOF (0x23)
+
+                  A delta frame carries value = key + delta * 2^e, where key
+                  is the value sent in the keyframe with the same id. The
+                  encoder sends a keyframe instead whenever a delta would not
+                  fit in 16 bits, so the error stays within half a quantum.
+                  A receiver that missed the keyframe ignores deltas until
+                  the next one.
+
+                  Slot i belongs to the node registered in slot i; a table
+                  larger than one MTU is sent as several frames with
+                  increasing first slot and the same sequence number, so a
+                  node sees consecutive numbers on the frames of its slot.
+**************************************************************************************************/
+
+#ifndef SLOTFRAME_H
+#define SLOTFRAME_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define SLOT_FRAME_SOF        0x3C
+#define SLOT_FRAME_DELTA_SOF  0x3E
+#define SLOT_FRAME_EOF        0x23
+#define SLOT_FRAME_HDR_LEN    6
+#define SLOT_FRAME_OVERHEAD   (SLOT_FRAME_HDR_LEN + 2)
+#define SLOT_FRAME_NONE       0xFF       // no slot assigned
+
+// Largest number of values per slot a receiver keeps a key for.
+#if !defined( SLOT_FRAME_M_MAX )
+#define SLOT_FRAME_M_MAX      4
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+#define SLOT_FRAME_SEQ( buf )  ( (buf)[1] )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Receiver state for one slot.
+typedef struct
+{
+  uint8 id;                              // keyframe id of key[]
+  uint8 valid;
+  float key[SLOT_FRAME_M_MAX];
+} slotFrameKey_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Number of slots of m values that fit in a frame of at most mtu bytes.
+ */
+extern uint8 SlotFrame_Capacity( uint8 mtu, uint8 m, uint8 delta );
+
+/*
+ * Build a keyframe from count slots starting at first; data holds
+ * count * m floats. Returns the frame length.
+ */
+extern uint8 SlotFrame_Build( uint8 *buf, uint8 seq, uint8 id, uint8 first, uint8 count,
+                              uint8 m, const float *data );
+
+/*
+ * TRUE if every one of n values is within 16 bits of quanta of its key.
+ * exp holds one exponent per channel, n is a multiple of m.
+ */
+extern uint8 SlotFrame_DeltaFits( uint16 n, uint8 m, const float *data,
+                                  const float *key, const int8 *exp );
+
+/*
+ * Build a delta frame against key, the values of keyframe id.
+ * Returns the frame length.
+ */
+extern uint8 SlotFrame_BuildDelta( uint8 *buf, uint8 seq, uint8 id, uint8 first, uint8 count,
+                                   uint8 m, const float *data, const float *key,
+                                   const int8 *exp );
+
+/*
+ * Validate a key or delta frame in place. TRUE if it is intact, carries
+ * slot and has no more than SLOT_FRAME_M_MAX values per slot.
+ */
+extern uint8 SlotFrame_Check( uint8 *buf, uint16 len, uint8 slot );
+
+/*
+ * Decode the values of slot from a frame that passed SlotFrame_Check into
+ * out. A keyframe also refreshes k. Returns m, or 0 for a delta frame
+ * without a matching key.
+ */
+extern uint8 SlotFrame_Decode( uint8 *buf, uint8 slot, slotFrameKey_t *k, float *out );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLOTFRAME_H */